@@ -15,6 +15,52 @@
 //  7) Ctrl+Up / Ctrl+Down: reorder single selected row in list
 //  8) Ctrl+Plus: combine selected files via video_combine.exe in background threads
 //     with per-task log windows; app cannot exit until all combines finish.
+//  9) Optional extended columns (codec, bitrate, fps, audio, channels, container):
+//     one ffprobe per file in the metadata worker, kept in a persistent metadata cache.
+// 10) Ctrl+T thumbnail column: one keyframe per video (ffmpeg), bounded worker pool with
+//     viewport priority, stored in a packed content-keyed thumbnail cache.
+// 11) Ctrl+S similar-video finder: perceptual scene-anchored fingerprints (cached), grouped into
+//     sets shown in the Search view; Ctrl+A there selects all but one per set.
+// 12) Ctrl+D duplicate finder: size buckets -> partial SHA-256 -> full SHA-256 (parallel,
+//     cached by size+mtime), same grouped view.
+// 13) Folder rows show recursive size / video count / total duration, computed in the
+//     background and memoized per directory by its mtime; changed levels update their
+//     ancestors by delta, and big trees show running totals while they are walked.
+// 14) Copy engine for paste / copy / Topaz / combine inputs: overlapped 1 MB I/O,
+//     8 deep, preallocated destinations, unbuffered for big files, several files in flight.
+// 15) File-op tasks are scheduled per physical device: bulk tasks sharing a disk queue,
+//     tasks on different disks run in parallel, deletes/renames never wait.
+// 16) One job scheduler runs file ops, ffmpeg edits, combines and metadata probing on a
+//     fixed worker pool (priorities, dependencies, cancel tokens, one output channel).
+// 17) copy_verify: the copy engine hashes data in flight (SHA-256) and re-reads the
+//     destination (or trusts a flushed write); the hash goes to the metadata cache and
+//     into Topaz job files.
+// 18) Large copies are resumable: they are written to <dst>.partial with a journal next to it
+//     (.mecopy) and renamed when complete; interrupted copies continue after a last-chunk
+//     check, network errors retry with backoff.
+// 19) Status bar shows smoothed throughput and ETA per transfer plus a total across running
+//     transfers; each task's bytes / time / average / peak rate go to the log when it ends.
+// 20) Same-volume copies try a block clone first (ReFS / Dev Drive: instant, copy-on-write).
+// 21) ffmpeg trim/flip read the source in place and write a temp beside it, published by a
+//     same-directory rename; temps orphaned by a crash are deleted at the next start.
+// 22) MP4 / MOV trims skip ffmpeg: the moov is rebuilt (sample tables cut down, one edit-list
+//     entry for a frame-accurate start) and only the kept media bytes are written or cloned.
+// 23) Horizontal flip is a display-matrix edit for MP4 / MOV (clone + 36 bytes, else 36 bytes in
+//     place, journaled) and a display_hflip remux for MKV (ffmpeg 7+, else baked in);
+//     re-encoding is kept as an explicit "baked in" option.
+// 24) ffmpeg tools build one edit plan per file during playback (trims, flip); the plan is
+//     compiled into a single native or ffmpeg pass when playback leaves the file.
+// 25) Keyframe index per video (MP4 stss, Matroska Cues, else ffprobe packets) in the metadata
+//     cache: seeks land on keyframes; trim_mode = keyframe snaps cuts.
+// 26) Combine joins parts by stream copy (concat demuxer) when every part has the same codec
+//     parameters (probed once, cached); otherwise parts are normalized in parallel to an
+//     H.264 / AAC MPEG-TS mezzanine, byte-joined and remuxed (one transcode, not two).
+// 27) The combine join streams the parts into ffmpeg's stdin in process (no copy /B, no
+//     command-line limit); the joined intermediate never touches the disk.
+// 28) Combine reads the sources in place (no working copies); only normalized parts go to a
+//     working dir, on combine_scratch when configured.
+// 29) ffmpeg edits and combines run with -progress: percent, fps, speed and ETA (against the
+//     cached duration) in the status bar; the log gets a progress line every 10 s.
 
 #ifndef UNICODE
 #  define UNICODE
@@ -44,6 +90,7 @@
 #include <cstdint>
 #include <cwchar>
 #include <climits>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
@@ -54,8 +101,11 @@
 #include <io.h> // for _unlink
 #include <unordered_map>
 #include <memory>
+#include <functional>
+#include <bitset>
 #include <winnetwk.h>   // WNetGetConnectionW
 #include <winreg.h>     // registry (RemotePath fallback)
+#include <bcrypt.h>     // SHA-256 (duplicate finder)
 
 
 
@@ -69,6 +119,7 @@
 #pragma comment(lib, "Uuid.lib")
 #pragma comment(lib, "Mpr.lib")
 #pragma comment(lib, "Advapi32.lib")
+#pragma comment(lib, "Bcrypt.lib")
 
 #include <vlc/vlc.h>
 
@@ -109,7 +160,19 @@ struct Row {
     ULONGLONG    vDur100ns;
     // NEW (Drives view): mapped drive UNC like \\server\share
     std::wstring netRemote;
-    Row() : isDir(false), size(0), vW(0), vH(0), vDur100ns(0) { modified.dwLowDateTime = modified.dwHighDateTime = 0; }
+    // NEW: extended props (one ffprobe per file, only when extendedColumns=1)
+    std::wstring vCodec, aCodec, container;
+    ULONGLONG    bitrate;      // overall bits/s
+    int          fpsMilli;     // frames/s * 1000
+    int          aChannels;
+    bool         extProbed;    // ffprobe already ran (fields may still be empty)
+    // NEW (grouped result views: similar / duplicate finders): 1-based set number, 0 = not grouped
+    int          groupId;
+    // NEW (folder rows): recursive totals are kept in size / vDur100ns plus this count
+    uint32_t     aggVideos;
+    bool         aggDone;
+    bool         aggPartial;   // running totals: the walk has not reached every subfolder yet
+    Row() : isDir(false), size(0), vW(0), vH(0), vDur100ns(0), bitrate(0), fpsMilli(0), aChannels(0), extProbed(false), groupId(0), aggVideos(0), aggDone(false), aggPartial(false) { modified.dwLowDateTime = modified.dwHighDateTime = 0; }
 };
 std::vector<Row> g_rows;
 
@@ -137,6 +200,7 @@ static bool g_loadingFolder = false;
 
 // sorting
 int  g_sortCol = 0;      // 0=Name,1=Type,2=Size,3=Modified,4=Resolution,5=Duration
+                         // extended: 6=Codec,7=Bitrate,8=FPS,9=Audio,10=Channels,11=Container
 bool g_sortAsc = true;
 
 // VLC
@@ -145,6 +209,16 @@ libvlc_media_player_t* g_mp = NULL;
 bool                      g_inPlayback = false;
 std::vector<std::wstring> g_playlist;
 size_t                    g_playlistIndex = 0;
+std::vector<std::wstring> g_rowsDeletedInPlayback; // deletes that finished while playing: rows dropped on exit
+// Find Similar / Find Duplicates that finished while playing: shown on exit (the latest one)
+struct FinderResultInPlayback {
+    bool have = false;
+    std::vector<Row> rows;
+    std::wstring label;
+    ViewKind originView = ViewKind::Drives;
+    std::wstring originFolder;
+};
+FinderResultInPlayback g_finderResultInPlayback;
 bool                      g_userDragging = false;
 libvlc_time_t             g_lastLenForRange = -1;
 
@@ -162,6 +236,21 @@ struct AppConfig {
     std::wstring loggingPath;          // folder from INI
     std::wstring logFile;             // full path to mediaexplorer.log
     std::wstring vlcHwAccel = L"d3d11va";
+
+    bool extendedColumns = false;   // show Codec/Bitrate/FPS/Audio/Channels/Container (needs ffprobeAvailable)
+    std::wstring metaCachePath;     // optional; default <exe dir>\mediaexplorer.metacache
+
+    bool thumbnails = false;        // start with the thumbnail column on (Ctrl+T toggles; needs ffmpegAvailable)
+    std::wstring thumbCachePath;    // optional; default <exe dir>\mediaexplorer.thumbs
+    int  thumbWorkers = 0;          // 0 = auto (half the cores, max 4)
+
+    int  copyFilesInFlight = 0;     // copy engine: files copied concurrently (0 = auto: 4)
+    bool copyUnbuffered = true;     // copy engine: unbuffered I/O for files >= 256 MB
+    int  copyVerify = 0;            // copy engine: 0 off, 1 re-read destination, 2 trust flushed write
+    int  ioTasksPerDevice = 0;      // bulk file-op tasks per physical device (0 = auto: 1)
+    int  jobWorkers = 0;            // job scheduler pool size (0 = auto: cores, 4..8)
+    int  trimMode = 0;              // ffmpeg tools: 0 exact, 1 snap trims to keyframes
+    std::wstring combineScratch;    // optional folder for combine intermediates; default beside the output
 };
 
 AppConfig g_cfg;
@@ -178,6 +267,7 @@ static std::string NarrowFromWideACP(const std::wstring & ws);
 // forward decls (used by Topaz submit helpers)
 static std::wstring EnsureSlash(std::wstring p);
 static std::string  ToUtf8(const std::wstring& ws);
+static std::wstring FromUtf8(const std::string& s);
 static void PumpMessagesThrottled(DWORD msInterval);
 static bool GetDriveRemoteUNC(wchar_t letter, std::wstring& outRemote);
 static bool GetPersistentMappedRemotePath(wchar_t letter, std::wstring& outRemote);
@@ -242,6 +332,10 @@ struct SearchState {
     std::vector<std::wstring> explicitFolders; // each ends with '\'
     std::vector<std::wstring> explicitFiles;   // absolute file paths
 
+    // NEW: grouped result views (similar / duplicate finders). Non-empty label means
+    // the rows came from a finder task: refresh only drops vanished files, never re-searches.
+    std::wstring groupLabel;
+
     SearchState()
         : active(false),
         originView(ViewKind::Drives),
@@ -251,27 +345,27 @@ struct SearchState {
 
 // ----------------------------- Async metadata fill
 constexpr UINT WM_APP_META = WM_APP + 100;
-constexpr UINT WM_APP_COMBINE_OUTPUT = WM_APP + 200;
-constexpr UINT WM_APP_COMBINE_DONE = WM_APP + 201;
-// New for ffmpeg tools
-constexpr UINT WM_APP_FFMPEG_OUTPUT = WM_APP + 300;
-constexpr UINT WM_APP_FFMPEG_DONE = WM_APP + 301;
-// New for background file operations (copy/move/delete/upscale)
-constexpr UINT WM_APP_FILEOP_OUTPUT = WM_APP + 400;
-constexpr UINT WM_APP_FILEOP_DONE = WM_APP + 401;
+// Job scheduler: output and completion of every job kind (file ops, ffmpeg, combine)
+constexpr UINT WM_APP_JOB_OUTPUT = WM_APP + 400;
+constexpr UINT WM_APP_JOB_DONE = WM_APP + 401;
 // NEW: background folder reload finished
 constexpr UINT WM_APP_FOLDER_RELOAD_DONE = WM_APP + 450;
 static const UINT WMU_STATUS_OP = WM_APP + 250;
 
-enum class StatusOpAction : UINT_PTR { Begin = 1, Update = 2, End = 3 };
+enum class StatusOpAction : UINT_PTR { Begin = 1, Update = 2, End = 3, Bytes = 4 };
 
 struct StatusOpMsg
 {
     StatusOpAction action;
     uint64_t       id;
     std::wstring   text;  // used for Begin/Update
+    ULONGLONG      bytesDone = 0;   // used for Bytes
+    ULONGLONG      bytesTotal = 0;
 };
 
+static std::wstring FormatSize(ULONGLONG bytes);
+static std::wstring FormatHMSms(LONGLONG ms);
+
 static std::atomic<uint64_t> g_nextStatusOpId{ 1 };
 
 // ----------------------------- Status line operation tracker (RESTORED)
@@ -281,12 +375,46 @@ class StatusOpTracker
 public:
     uint64_t begin(uint64_t id, std::wstring text)
     {
+        IoStats& io = m_io[id];
+        io.title = text;
+        io.beginTick = GetTickCount64();
         m_text[id] = std::move(text);
         m_stack.push_back(id);
         cleanup();
         return id;
     }
 
+    // Byte progress of the op's current transfer. 'moved' is the op's own counter and only
+    // grows by forward steps: a new transfer (other total) adds what it reports, the same
+    // transfer adds done - previous done. A retry rolling 'done' back adds nothing, so progress
+    // is never counted twice; data sent again after a rollback does count (it moved again).
+    void bytes(uint64_t id, ULONGLONG done, ULONGLONG total)
+    {
+        auto it = m_io.find(id);
+        if (it == m_io.end() || m_text.find(id) == m_text.end()) return;
+        IoStats& io = it->second;
+        const ULONGLONG now = GetTickCount64();
+        if (total != io.total) io.moved += done;
+        else if (done > io.done) io.moved += done - io.done;
+        io.done = done;
+        io.total = total;
+
+        const ULONGLONG movedNow = io.moved;
+        if (!io.firstTick) {
+            io.firstTick = now;
+            io.lastTick = now;
+            io.lastMoved = movedNow;
+            return;
+        }
+        const ULONGLONG dt = now - io.lastTick;
+        if (dt < kRateWindowMs) return;
+        const double inst = (double)(movedNow - io.lastMoved) * 1000.0 / (double)dt;
+        io.rate = (io.rate <= 0.0) ? inst : (kRateSmoothing * inst + (1.0 - kRateSmoothing) * io.rate);
+        if (inst > io.peak) io.peak = inst;
+        io.lastTick = now;
+        io.lastMoved = movedNow;
+    }
+
     void update(uint64_t id, std::wstring text)
     {
         auto it = m_text.find(id);
@@ -297,6 +425,11 @@ public:
 
     void end(uint64_t id)
     {
+        auto io = m_io.find(id);
+        if (io != m_io.end()) {
+            logTotals(io->second);
+            m_io.erase(io);
+        }
         m_text.erase(id);
         auto it = std::find(m_stack.begin(), m_stack.end(), id);
         if (it != m_stack.end())
@@ -311,12 +444,70 @@ public:
         auto it = m_text.find(top);
         if (it == m_text.end()) return L"";
 
-        if (m_text.size() > 1)
-            return it->second + L"   (" + std::to_wstring(m_text.size()) + L" running)";
-        return it->second;
+        std::wstring line = it->second;
+        auto io = m_io.find(top);
+        if (io != m_io.end() && io->second.rate > 0.0)
+            line += L"  -  " + rateText(io->second.rate, remaining(io->second));
+
+        // Sum over every op that is moving data (tells a slow disk/network from a busy scheduler)
+        int transfers = 0;
+        double rate = 0.0;
+        ULONGLONG left = 0;
+        for (const auto& kv : m_io) {
+            if (kv.second.rate <= 0.0 || m_text.find(kv.first) == m_text.end()) continue;
+            ++transfers;
+            rate += kv.second.rate;
+            left += remaining(kv.second);
+        }
+        if (transfers > 1)
+            line += L"   [" + std::to_wstring(transfers) + L" transfers: " + rateText(rate, left) + L"]";
+        else if (m_text.size() > 1)
+            line += L"   (" + std::to_wstring(m_text.size()) + L" running)";
+        return line;
     }
 
 private:
+    static constexpr ULONGLONG kRateWindowMs = 500;  // min spacing of rate samples
+    static constexpr double kRateSmoothing = 0.3;    // EMA weight of the newest sample
+
+    struct IoStats {
+        std::wstring title;         // Begin text (Update text changes with progress)
+        ULONGLONG beginTick = 0;
+        ULONGLONG firstTick = 0;    // first byte report (0 = none yet)
+        ULONGLONG lastTick = 0;
+        ULONGLONG done = 0, total = 0;
+        ULONGLONG moved = 0;        // bytes moved by the op so far (only grows)
+        ULONGLONG lastMoved = 0;
+        double rate = 0.0;          // smoothed bytes/s
+        double peak = 0.0;
+    };
+
+    static ULONGLONG remaining(const IoStats& io)
+    {
+        return io.total > io.done ? io.total - io.done : 0;
+    }
+
+    static std::wstring rateText(double rate, ULONGLONG left)
+    {
+        std::wstring t = FormatSize((ULONGLONG)rate) + L"/s";
+        if (left > 0 && rate > 0.0)
+            t += L", " + FormatSize(left) + L" left, ETA " + FormatHMSms((LONGLONG)((double)left * 1000.0 / rate));
+        return t;
+    }
+
+    static void logTotals(const IoStats& io)
+    {
+        if (!io.firstTick) return; // no data moved
+        const ULONGLONG now = GetTickCount64();
+        const ULONGLONG bytes = io.moved;
+        const double activeSec = (double)(now - io.firstTick) / 1000.0;
+        const double waitSec = (double)(io.firstTick - io.beginTick) / 1000.0;
+        const double avg = activeSec > 0.0 ? (double)bytes / activeSec : 0.0;
+        LogLine(L"[IO] %s: %s in %.1f s (first byte after %.1f s), avg %s/s, peak %s/s",
+            io.title.c_str(), FormatSize(bytes).c_str(), activeSec, waitSec,
+            FormatSize((ULONGLONG)avg).c_str(), FormatSize((ULONGLONG)io.peak).c_str());
+    }
+
     void cleanup()
     {
         while (!m_stack.empty() && m_text.find(m_stack.back()) == m_text.end())
@@ -324,6 +515,7 @@ private:
     }
 
     std::unordered_map<uint64_t, std::wstring> m_text;
+    std::unordered_map<uint64_t, IoStats> m_io;
     std::vector<uint64_t> m_stack;
 };
 
@@ -376,7 +568,17 @@ static void StatusOpEnd(uint64_t id)
     PostStatusMsg(new StatusOpMsg{ StatusOpAction::End, id, L"" });
 }
 
-enum class FileOpKind { ClipboardPaste, DeleteFiles, CopyToPath, TopazSubmit};
+// Byte progress for the throughput / ETA display (from the copy engine's onProgress)
+static void StatusOpBytes(uint64_t id, ULONGLONG done, ULONGLONG total)
+{
+    if (!id) return;
+    StatusOpMsg* msg = new StatusOpMsg{ StatusOpAction::Bytes, id, L"" };
+    msg->bytesDone = done;
+    msg->bytesTotal = total;
+    PostStatusMsg(msg);
+}
+
+enum class FileOpKind { ClipboardPaste, DeleteFiles, CopyToPath, TopazSubmit, FindSimilar, FindDuplicates };
 
 enum class TopazTarget { K4, K8 };
 enum class TopazProfile {
@@ -419,8 +621,16 @@ static void CenterInWorkArea(const RECT& wa, int W, int H, int& outX, int& outY)
     outY = wa.top + ((wa.bottom - wa.top) - H) / 2;
 }
 
+// Playback-exit bulk delete held back until the copies of the same files are done (a file sent
+// to the upscale folder and marked for delete must not lose its source first). UI thread only.
+struct PlaybackExitDelete {
+    std::vector<std::wstring> files;
+    uint32_t gen = 0;           // playback-exit batch
+    int copiesLeft = 0;         // copies still to finish
+};
+
 struct FileOpTask {
-    HANDLE hThread = NULL;
+    uint64_t jobId = 0;     // scheduler job (0 = not submitted yet)
     HWND   hwnd = NULL;     // log window
     HWND   hEdit = NULL;    // multiline read-only edit
     HWND   hCancel = NULL;  // cancel button
@@ -436,13 +646,30 @@ struct FileOpTask {
     std::vector<std::wstring> srcFiles;
     std::wstring dstFolder; // ends with '\'
 
+    // DeleteFiles (targets in srcFiles): the paths actually removed (their rows are dropped
+    // from the view when done)
+    std::vector<std::wstring> deleted;
+
     // CopyToPath
     std::wstring srcSingle;
     std::wstring dstPath;
+    PlaybackExitDelete* deleteAfter = nullptr;  // delete waiting for this copy (null = none)
 
      // TopazSubmit (batch)
      TopazJobOptions topaz;
 
+    // FindSimilar / FindDuplicates (scan scope + grouped result rows, shown as a Search-style view when done)
+    std::vector<std::wstring> scanFolders;  // recursed, each ends with '\'
+    std::vector<std::wstring> scanFiles;    // taken as-is
+    ViewKind     scanOriginView = ViewKind::Drives;
+    std::wstring scanOriginFolder;
+    std::vector<Row> resultRows;
+    std::wstring resultLabel;
+
+    // Per-device I/O scheduling: device keys this task reads/writes (empty = small task)
+    std::vector<std::wstring> ioDevices;
+    bool ioHeld = false;                    // holds a slot on each of ioDevices
+
     std::wstring title;
     std::atomic<bool> cancel{ false };
     bool running = false;
@@ -486,6 +713,7 @@ static std::string NowUtcIso8601() {
 static void BuildTopazJobJsonUtf8(const std::wstring & originalFull,
     const std::wstring & queuedFileNameOnly,
     const TopazJobOptions & opt,
+    const std::string & inputSha256,   // empty unless copy_verify checked the queued copy
     std::string & outUtf8)
      {
     const int w = (opt.target == TopazTarget::K8) ? 7680 : 3840;
@@ -525,7 +753,10 @@ static void BuildTopazJobJsonUtf8(const std::wstring & originalFull,
          << "  \"job_version\": 1,\n"
          << "  \"submitted_utc\": \"" << utc << "\",\n"
          << "  \"source_original\": \"" << orig << "\",\n"
-         << "  \"input_file\": \"" << inFile << "\",\n"
+         << "  \"input_file\": \"" << inFile << "\",\n";
+     if (!inputSha256.empty())
+         oss << "  \"input_sha256\": \"" << inputSha256 << "\",\n";
+     oss
          << "  \"target\": \"" << t << "\",\n"
          << "  \"target_w\": " << wh << ",\n"
          << "  \"target_h\": " << hh << ",\n"
@@ -542,6 +773,9 @@ CRITICAL_SECTION g_fileLock;
 std::vector<FileOpTask*> g_fileTasks;
 
 // Cancel the most recently started running file-op task (Esc in list view)
+static void IoSchedPump();
+static void IoRelease(FileOpTask* task);
+
 static void CancelMostRecentFileOpTask()
 {
     FileOpTask* found = nullptr;
@@ -555,6 +789,7 @@ static void CancelMostRecentFileOpTask()
     if (!found) return;
     found->cancel.store(true, std::memory_order_relaxed);
     if (found->statusId) StatusOpUpdate(found->statusId, found->title + L" (cancelling...)");
+    IoSchedPump(); // a task still waiting for its device starts now and ends at once
 }
 
 
@@ -570,9 +805,11 @@ static void ScheduleCopyToPathAsync(const std::wstring& src,
     const std::wstring& dst,
     const std::wstring& title,
     bool fromPlaybackExit = false,
-    uint32_t playbackExitGen = 0);
+    uint32_t playbackExitGen = 0,
+    PlaybackExitDelete* deleteAfter = nullptr);
 
 static void RefreshCurrentView();
+static void DirAggFillRow(Row& r);
 
 // NEW: background folder reload helpers
 static void CancelBackgroundFolderReload();
@@ -593,29 +830,102 @@ struct MetaResult {
     int          w, h;
     ULONGLONG    dur;
     uint32_t     gen;
+    // extended props (valid when extProbed)
+    bool         extProbed;
+    std::wstring vCodec, aCodec, container;
+    ULONGLONG    bitrate;
+    int          fpsMilli;
+    int          aChannels;
 };
 
+// Worker pops this many paths per lock and posts them as one WM_APP_META
+constexpr size_t kMetaBatch = 16;
+
 std::atomic<uint32_t> g_metaGen{ 0 };
-CRITICAL_SECTION      g_metaLock;          // protects g_metaTodoPaths
+CRITICAL_SECTION      g_metaLock;          // protects g_metaTodoPaths, g_metaJobActive
 std::vector<std::wstring> g_metaTodoPaths; // paths that still need deep props
-HANDLE                g_metaThread = NULL;
+bool                  g_metaJobActive = false; // a MetaJobProc is queued or running
+std::atomic<bool>     g_metaWantExt{ false }; // search filters on ffprobe fields: probe them even with the columns off
+
+// ----------------------------- Metadata cache (NEW)
+// Keyed by lower-cased full path; an entry is only valid while size + last-write time still match.
+// Persisted as UTF-8 text next to the exe (or metaCachePath) so reopening a folder needs no probing.
+struct MetaCacheEntry {
+    ULONGLONG size = 0;
+    ULONGLONG mtime = 0;       // FILETIME as 64-bit
+    int       w = 0, h = 0;
+    ULONGLONG dur = 0;         // 100ns
+    bool      extProbed = false;
+    std::wstring vCodec, aCodec, container;
+    ULONGLONG bitrate = 0;
+    int       fpsMilli = 0;
+    int       aChannels = 0;
+    ULONGLONG thumbKey = 0;    // content key into the packed thumbnail cache (0 = not computed)
+    std::vector<ULONGLONG> fingerprint; // perceptual frame hashes (empty = not computed)
+    std::string partialHash;   // SHA-256 hex of size + first/middle/last 64KB (duplicate finder)
+    std::string fullHash;      // SHA-256 hex of the whole file
+    bool      kfIndexed = false;            // keyframe index computed
+    bool      kfAllIntra = false;           // ... and every frame is a keyframe (list stays empty)
+    std::vector<uint32_t> keyframes;        // video keyframe times, ms from the start, ascending
+    std::string streamSig;     // codec parameters of the video/audio streams (combine stream-copy check)
+    bool      mirrorRead = false;           // MP4 / MOV display matrix read
+    bool      mirrored = false;             // ... and it mirrors the picture
+};
+
+CRITICAL_SECTION g_metaCacheLock;          // protects g_metaCache
+std::unordered_map<std::wstring, MetaCacheEntry> g_metaCache;
+bool             g_metaCacheDirty = false;
+
+// ----------------------------- Thumbnails (NEW)
+// One keyframe per video, extracted by ffmpeg on a small worker pool, stored downscaled in a
+// single packed file (mediaexplorer.thumbs) indexed by content key -> record offset.
+constexpr UINT WM_APP_THUMB = WM_APP + 110;
+constexpr int  kThumbW = 128;
+constexpr int  kThumbH = 72;
+constexpr DWORD kThumbBytes = kThumbW * kThumbH * 3; // BGR24, rows are already DWORD aligned
+
+struct ThumbResult {
+    std::wstring      path;
+    uint32_t          gen;
+    std::vector<BYTE> bgr;     // kThumbBytes, top-down
+};
+
+std::atomic<uint32_t>     g_thumbGen{ 0 };
+CRITICAL_SECTION          g_thumbLock;      // protects g_thumbTodo, g_thumbWorkers, packed file + index
+std::vector<std::wstring> g_thumbTodo;      // back() is next; visible rows get moved to the back
+int                       g_thumbWorkers = 0;
+HANDLE                    g_thumbJob = NULL; // job object of the running extractions (killed on cancel)
+HANDLE                    g_thumbFile = INVALID_HANDLE_VALUE;
+ULONGLONG                 g_thumbFileEnd = 0;
+std::unordered_map<ULONGLONG, ULONGLONG> g_thumbIndex; // content key -> record offset
+
+// UI thread only
+bool                      g_thumbsOn = false;
+HIMAGELIST                g_thumbImages = NULL;
+std::unordered_map<std::wstring, int> g_thumbImageOfPath; // lower-cased path -> image list index
 
 // ----------------------------- Combine tasks (video_combine in background)
 
 struct CombineTask {
-    HANDLE hThread;
+    uint64_t jobId;
+    uint64_t statusId;          // StatusOpBegin() id while the job runs
     HANDLE hProcess;
     HWND   hwnd;      // log window
     HWND   hEdit;     // multiline read-only edit inside log window
-    std::wstring workingDir;    // dir where inputs are copied
+    std::wstring workingDir;    // dir for intermediates (sources are read in place); unique per job
+    bool   workingDirCreated = false;        // this job made workingDir (only then is it removed)
+    std::vector<std::wstring> workFiles;     // intermediates this job wrote (the only files cleanup deletes)
     std::vector<std::wstring> srcFiles;      // original source file paths
     std::wstring combinedFull;  // final combined video path
+    std::wstring outputTemp;    // ffmpeg output beside it (.metmp-), renamed over the final name on success
     std::wstring title;         // short description (e.g., output file name)
     bool   running;
     bool   hiddenByPlayback;    // <--- NEW
+    std::atomic<bool> cancel{ false };
 
     CombineTask() :
-        hThread(NULL),
+        jobId(0),
+        statusId(0),
         hProcess(NULL),
         hwnd(NULL),
         hEdit(NULL),
@@ -630,7 +940,7 @@ std::vector<CombineTask*> g_combineTasks;
 static void EnsureCombineLogClass();
 static HWND CreateCombineLogWindow(CombineTask* task);
 static void PostCombineOutput(CombineTask* task, const std::wstring& text);
-static DWORD WINAPI CombineThreadProc(LPVOID param);
+static DWORD WINAPI CombineJobProc(LPVOID param);
 
 static bool HasRunningCombineTasks() {
     EnterCriticalSection(&g_combineLock);
@@ -644,25 +954,29 @@ static bool HasRunningCombineTasks() {
 
 // ----------------------------- FFmpeg processing tasks (trim/flip in background)
 
-enum class FfmpegOpKind { TrimFront, TrimEnd, HFlip };
+enum class FfmpegOpKind { TrimFront, TrimEnd, HFlip, HFlipBake };   // HFlip: display matrix when possible
 
 struct FfmpegTask {
-    HANDLE hThread = NULL;
+    uint64_t jobId = 0;
     HANDLE hProcess = NULL;
     HWND   hwnd = NULL;        // log window
     HWND   hEdit = NULL;       // multiline read-only edit in log window
-    std::wstring sourceFull;   // original video path
-    std::wstring workingDir;   // ...video_process
-    std::wstring inputCopy;    // workingDir + base.ext (copied original)
-    std::wstring outputTemp;   // workingDir + base_<op>.ext  (ffmpeg output)
-    std::wstring finalWorking; // after rename, path of final processed file in workingDir
-    std::wstring title;        // short title, e.g. "Trim front: file.mp4"
-    FfmpegOpKind kind;
-    libvlc_time_t refMs = 0;   // time in ms when user invoked operation
+    std::wstring sourceFull;   // original video path (ffmpeg reads it in place)
+    std::wstring outputTemp;   // beside the source: base.metmp-<pid>-<n>-<op>.ext (ffmpeg output)
+    std::wstring finalWorking; // outputTemp once ffmpeg succeeded; renamed to "base (n).ext" at finalize
+    std::wstring title;        // short title, e.g. "Edits: file.mp4"
+    // Edit plan: every edit of this file made during one playback visit, run as a single pass
+    int64_t keepFromMs = 0;    // trim front (0 = from the start)
+    int64_t keepToMs = -1;     // trim end (-1 = to the end)
+    bool hflip = false;        // net horizontal flip (two flips cancel)
+    bool bakeFlip = false;     // flip by re-encoding instead of a display flag
+    bool submitted = false;    // plan closed (playback left the file) and handed to the scheduler
+    uint64_t statusId = 0;     // StatusOpBegin() id while the job runs
     bool running = false;
     bool done = false;
     DWORD exitCode = 0;
     bool hiddenByPlayback = false;  // <--- NEW
+    std::atomic<bool> cancel{ false };
 };
 
 CRITICAL_SECTION g_ffLock;
@@ -835,284 +1149,2270 @@ static bool GetMediaCreatedTime(const std::wstring& path, FILETIME& outFt, bool&
 }
 
 
-// ----------------------------- FFmpeg task log window + helpers
+// ----------------------------- Parallel helper (NEW)
+struct ParallelForCtx {
+    std::atomic<size_t> next{ 0 };
+    size_t count = 0;
+    const std::function<void(size_t)>* fn = nullptr;
+    const std::atomic<bool>* cancel = nullptr;
+};
 
-static LRESULT CALLBACK FfmpegLogProc(HWND h, UINT m, WPARAM w, LPARAM l) {
-    FfmpegTask* task = reinterpret_cast<FfmpegTask*>(GetWindowLongPtrW(h, GWLP_USERDATA));
-    switch (m) {
-    case WM_CREATE: {
-        LPCREATESTRUCT pcs = (LPCREATESTRUCT)l;
-        task = (FfmpegTask*)pcs->lpCreateParams;
-        SetWindowLongPtrW(h, GWLP_USERDATA, (LONG_PTR)task);
+static DWORD WINAPI ParallelForThreadProc(LPVOID param) {
+    ParallelForCtx* ctx = (ParallelForCtx*)param;
+    CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+    for (;;) {
+        if (ctx->cancel && ctx->cancel->load(std::memory_order_relaxed)) break;
+        size_t i = ctx->next.fetch_add(1);
+        if (i >= ctx->count) break;
+        (*ctx->fn)(i);
+    }
+    CoUninitialize();
+    return 0;
+}
 
-        HFONT hf = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
-        RECT rc; GetClientRect(h, &rc);
+// Runs fn(0..count-1) on up to 'threads' threads (the caller's thread is one of them).
+static void ParallelFor(size_t count, int threads, const std::function<void(size_t)>& fn,
+    const std::atomic<bool>& cancel)
+{
+    if (count == 0) return;
+    ParallelForCtx ctx;
+    ctx.count = count;
+    ctx.fn = &fn;
+    ctx.cancel = &cancel;
+
+    if (threads > MAXIMUM_WAIT_OBJECTS) threads = MAXIMUM_WAIT_OBJECTS;
+    if ((size_t)threads > count) threads = (int)count;
+
+    std::vector<HANDLE> hs;
+    for (int t = 1; t < threads; ++t) {
+        HANDLE h = CreateThread(NULL, 0, ParallelForThreadProc, &ctx, 0, NULL);
+        if (h) hs.push_back(h);
+    }
+    ParallelForThreadProc(&ctx);
+    if (!hs.empty()) WaitForMultipleObjects((DWORD)hs.size(), hs.data(), TRUE, INFINITE);
+    for (HANDLE h : hs) CloseHandle(h);
+}
+
+// ----------------------------- Job scheduler (NEW)
+// One fixed pool (job_workers) runs the background jobs: file ops (paste / copy / delete /
+// Topaz submit / finders) and the source-delete lane of a move, ffmpeg edits, combines,
+// metadata probing, thumbnail extraction and folder totals. A job has a priority,
+// the ids of jobs that must finish first, and a cancel token it polls; a job cancelled before
+// it starts is not run. Normal/Low jobs never take the last worker, so a paste or delete starts
+// even while combines fill the pool; metadata probing for the rows on screen is High for the
+// same reason. Every process a job starts is put in g_jobChildren, so shutdown can kill them
+// and join the workers. Output and completion of every job kind reach the UI through
+// WM_APP_JOB_OUTPUT / WM_APP_JOB_DONE.
+enum class JobKind { FileOp, Ffmpeg, Combine, Meta };
+enum class JobPriority { High = 0, Normal = 1, Low = 2 };
+
+struct Job {
+    uint64_t id = 0;
+    JobKind kind = JobKind::FileOp;
+    JobPriority prio = JobPriority::Normal;
+    std::vector<uint64_t> deps;                  // job ids that must finish first
+    const std::atomic<bool>* cancel = nullptr;   // cooperative cancel token (may be null)
+    LPTHREAD_START_ROUTINE proc = nullptr;       // returns the job's rc
+    LPVOID param = nullptr;                      // owner task
+    bool notifyDone = false;                     // post WM_APP_JOB_DONE with the rc
+};
 
-        HWND hEdit = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"",
-            WS_CHILD | WS_VISIBLE | ES_MULTILINE | ES_AUTOVSCROLL | ES_READONLY | WS_VSCROLL,
-            4, 4, rc.right - 8, rc.bottom - 8, h, (HMENU)101, g_hInst, NULL);
-        SendMessageW(hEdit, WM_SETFONT, (WPARAM)hf, TRUE);
+// lParam of WM_APP_JOB_OUTPUT / WM_APP_JOB_DONE (the UI thread deletes it)
+struct JobEvent {
+    JobKind kind = JobKind::FileOp;
+    void* owner = nullptr;
+    std::wstring text;      // OUTPUT
+    DWORD rc = 0;           // DONE
+};
 
-        if (task) task->hEdit = hEdit;
-        return 0;
+CRITICAL_SECTION      g_jobLock;
+CONDITION_VARIABLE    g_jobWake;
+std::vector<Job*>     g_jobQueue;     // not started, submit order
+std::vector<uint64_t> g_jobRunning;   // started, not finished
+uint64_t g_jobNextId = 1;
+int  g_jobThreads = 0;                // workers alive (created on demand, never more than JobWorkerCount)
+int  g_jobIdle = 0;                   // workers waiting for work
+int  g_jobLongBusy = 0;               // workers on Normal/Low jobs
+bool g_jobStop = false;
+std::vector<HANDLE> g_jobThreadHandles; // every worker ever started; joined by JobShutdown
+HANDLE g_jobChildren = NULL;          // job object of the processes jobs start (ffmpeg, ffprobe, ...)
+// Children are spawned from several threads with bInheritHandles = TRUE. Pipes are created
+// non-inheritable; a child's ends are made inheritable, the process created and those ends closed
+// (or made private again) under this lock, so no other spawn can pick up a foreign pipe end.
+CRITICAL_SECTION g_spawnLock;
+
+static int JobWorkerCount() {
+    int n = g_cfg.jobWorkers;
+    if (n <= 0) {
+        SYSTEM_INFO si{};
+        GetSystemInfo(&si);
+        n = (int)si.dwNumberOfProcessors;
+        if (n < 4) n = 4;
+        if (n > 8) n = 8;
+    }
+    return n < 2 ? 2 : (n > 64 ? 64 : n);
+}
+
+static bool JobUnfinishedLocked(uint64_t id) {
+    if (std::find(g_jobRunning.begin(), g_jobRunning.end(), id) != g_jobRunning.end()) return true;
+    for (const Job* j : g_jobQueue) if (j->id == id) return true;
+    return false;
+}
+
+// Highest-priority job whose dependencies are done (earliest submitted wins ties).
+static Job* JobTakeLocked() {
+    const bool longRoom = g_jobLongBusy < JobWorkerCount() - 1;
+    size_t best = g_jobQueue.size();
+    for (size_t i = 0; i < g_jobQueue.size(); ++i) {
+        const Job* j = g_jobQueue[i];
+        if (best < g_jobQueue.size() && j->prio >= g_jobQueue[best]->prio) continue;
+        if (j->prio != JobPriority::High && !longRoom) continue;
+        bool ready = true;
+        for (uint64_t d : j->deps) {
+            if (JobUnfinishedLocked(d)) { ready = false; break; }
+        }
+        if (ready) best = i;
     }
-    case WM_SIZE: {
-        if (task && task->hEdit) {
-            RECT rc; GetClientRect(h, &rc);
-            MoveWindow(task->hEdit, 4, 4, rc.right - 8, rc.bottom - 8, TRUE);
+    if (best == g_jobQueue.size()) return nullptr;
+    Job* j = g_jobQueue[best];
+    g_jobQueue.erase(g_jobQueue.begin() + best);
+    return j;
+}
+
+static DWORD WINAPI JobWorkerProc(LPVOID) {
+    CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+    EnterCriticalSection(&g_jobLock);
+    while (!g_jobStop) {
+        Job* job = JobTakeLocked();
+        if (!job) {
+            ++g_jobIdle;
+            SleepConditionVariableCS(&g_jobWake, &g_jobLock, INFINITE);
+            --g_jobIdle;
+            continue;
         }
+        const bool isLong = (job->prio != JobPriority::High);
+        if (isLong) ++g_jobLongBusy;
+        g_jobRunning.push_back(job->id);
+        LeaveCriticalSection(&g_jobLock);
+
+        DWORD rc = ERROR_CANCELLED;
+        if (!job->cancel || !job->cancel->load(std::memory_order_relaxed))
+            rc = job->proc(job->param);
+        if (job->notifyDone) {
+            JobEvent* ev = new JobEvent();
+            ev->kind = job->kind;
+            ev->owner = job->param;
+            ev->rc = rc;
+            PostMessageW(g_hwndMain, WM_APP_JOB_DONE, 0, (LPARAM)ev);
+        }
+
+        EnterCriticalSection(&g_jobLock);
+        if (isLong) --g_jobLongBusy;
+        g_jobRunning.erase(std::find(g_jobRunning.begin(), g_jobRunning.end(), job->id));
+        delete job;
+        WakeAllConditionVariable(&g_jobWake); // dependents / held-back jobs may be ready now
+    }
+    --g_jobThreads;
+    LeaveCriticalSection(&g_jobLock);
+    CoUninitialize();
+    return 0;
+}
+
+// Queues proc(param); returns the job id, or 0 if no worker could be started.
+static uint64_t JobSubmit(JobKind kind, JobPriority prio, LPTHREAD_START_ROUTINE proc, LPVOID param,
+    const std::atomic<bool>* cancel, bool notifyDone, const std::vector<uint64_t>& deps = {})
+{
+    Job* job = new Job();
+    job->kind = kind;
+    job->prio = prio;
+    job->deps = deps;
+    job->cancel = cancel;
+    job->proc = proc;
+    job->param = param;
+    job->notifyDone = notifyDone;
+
+    EnterCriticalSection(&g_jobLock);
+    if (g_jobStop) {
+        LeaveCriticalSection(&g_jobLock);
+        delete job;
         return 0;
     }
-    case WM_CLOSE:
-        ShowWindow(h, SW_HIDE); // hide, don't destroy; keep log available
+    job->id = g_jobNextId++;
+    g_jobQueue.push_back(job);
+    if ((int)g_jobQueue.size() > g_jobIdle && g_jobThreads < JobWorkerCount()) {
+        HANDLE th = CreateThread(NULL, 0, JobWorkerProc, NULL, 0, NULL);
+        if (th) { g_jobThreadHandles.push_back(th); ++g_jobThreads; }
+    }
+    if (g_jobThreads == 0) {
+        g_jobQueue.pop_back();
+        LeaveCriticalSection(&g_jobLock);
+        delete job;
         return 0;
     }
-    return DefWindowProcW(h, m, w, l);
+    const uint64_t id = job->id;
+    WakeAllConditionVariable(&g_jobWake);
+    LeaveCriticalSection(&g_jobLock);
+    return id;
 }
 
-static void EnsureFfmpegLogClass() {
-    static bool reg = false;
-    if (!reg) {
-        WNDCLASSW wc{}; wc.lpfnWndProc = FfmpegLogProc; wc.hInstance = g_hInst;
-        wc.hCursor = LoadCursor(NULL, IDC_ARROW);
-        wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
-        wc.lpszClassName = L"FfmpegLogClass";
-        RegisterClassW(&wc);
-        reg = true;
+// Drops job id if it has not started. Returns true when it is not running (dropped now, dropped
+// by shutdown, or already done); false means it is running right now.
+static bool JobWithdraw(uint64_t id) {
+    EnterCriticalSection(&g_jobLock);
+    for (size_t i = 0; i < g_jobQueue.size(); ++i) {
+        if (g_jobQueue[i]->id != id) continue;
+        delete g_jobQueue[i];
+        g_jobQueue.erase(g_jobQueue.begin() + i);
+        WakeAllConditionVariable(&g_jobWake); // jobs that depended on it may be ready now
+        LeaveCriticalSection(&g_jobLock);
+        return true;
+    }
+    const bool running = std::find(g_jobRunning.begin(), g_jobRunning.end(), id) != g_jobRunning.end();
+    LeaveCriticalSection(&g_jobLock);
+    return !running;
+}
+
+// WM_DESTROY, after every task's cancel flag is set: drop jobs that have not started, kill the
+// processes of running ones and join the workers, so no job outlives the task it works on.
+// Sent messages are dispatched while waiting (a worker may be inside SetWindowText & co.), and
+// the kill is repeated in case a job started one more process before seeing its cancel flag.
+static void JobShutdown() {
+    EnterCriticalSection(&g_jobLock);
+    g_jobStop = true;
+    for (Job* j : g_jobQueue) delete j;
+    g_jobQueue.clear();
+    WakeAllConditionVariable(&g_jobWake);
+    std::vector<HANDLE> threads;
+    threads.swap(g_jobThreadHandles);
+    LeaveCriticalSection(&g_jobLock);
+
+    for (HANDLE th : threads) {
+        for (;;) {
+            if (g_jobChildren) TerminateJobObject(g_jobChildren, ERROR_CANCELLED);
+            const DWORD w = MsgWaitForMultipleObjects(1, &th, FALSE, 250, QS_SENDMESSAGE);
+            if (w == WAIT_OBJECT_0 || w == WAIT_FAILED) break;
+            MSG msg;
+            PeekMessageW(&msg, NULL, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+        }
+        CloseHandle(th);
     }
+    if (g_jobChildren) { CloseHandle(g_jobChildren); g_jobChildren = NULL; }
 }
 
-static HWND CreateFfmpegLogWindow(FfmpegTask* task) {
-    RECT wa{}; GetWorkAreaForOwner(g_hwndMain, wa);
-    int W = DpiScale(640), H = DpiScale(480);
-    int X = 0, Y = 0; CenterInWorkArea(wa, W, H, X, Y);
-
-    std::wstring title = L"FFmpeg task: ";
-    title += task ? task->title : L"(unknown)";
-
-    HWND hwnd = CreateWindowExW(WS_EX_TOOLWINDOW, L"FfmpegLogClass", title.c_str(),
-        WS_OVERLAPPEDWINDOW | WS_VISIBLE,
-        X, Y, W, H, g_hwndMain, NULL, g_hInst, task);
+// Log text for the owner task's window; the UI thread appends it (and mirrors it to the log).
+static void JobPostOutput(JobKind kind, void* owner, const std::wstring& text) {
+    if (!owner) return;
+    JobEvent* ev = new JobEvent();
+    ev->kind = kind;
+    ev->owner = owner;
+    ev->text = text;
+    PostMessageW(g_hwndMain, WM_APP_JOB_OUTPUT, 0, (LPARAM)ev);
+}
 
-    if (hwnd && task)
-    {
-        task->hwnd = hwnd;
+// ----------------------------- SHA-256 (CNG) helpers
+// Lowercase hex digests; the copy engine and the duplicate finder produce the same value for
+// the same content, so a verified copy already has its full hash in the metadata cache.
+struct Sha256Ctx {
+    BCRYPT_ALG_HANDLE alg = NULL;
+    BCRYPT_HASH_HANDLE h = NULL;
+};
 
-        if (g_inPlayback)
-        {
-            if (IsWindowVisible(hwnd))
-                ShowWindow(hwnd, SW_HIDE);
-            task->hiddenByPlayback = true;
-        }
+static bool Sha256Begin(Sha256Ctx& c) {
+    if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&c.alg, BCRYPT_SHA256_ALGORITHM, NULL, 0))) {
+        c.alg = NULL;
+        return false;
     }
-    return hwnd;
+    if (!BCRYPT_SUCCESS(BCryptCreateHash(c.alg, &c.h, NULL, 0, NULL, 0, 0))) {
+        BCryptCloseAlgorithmProvider(c.alg, 0);
+        c.alg = NULL;
+        c.h = NULL;
+        return false;
+    }
+    return true;
 }
 
-static void PostFfmpegOutput(FfmpegTask* task, const std::wstring& text) {
-    if (!task) return;
-    std::wstring* p = new std::wstring(text);
-    PostMessageW(g_hwndMain, WM_APP_FFMPEG_OUTPUT, (WPARAM)task, (LPARAM)p);
+static bool Sha256Update(Sha256Ctx& c, const void* data, DWORD len) {
+    return BCRYPT_SUCCESS(BCryptHashData(c.h, (PUCHAR)data, len, 0));
 }
 
-static DWORD WINAPI FfmpegThreadProc(LPVOID param) {
-    FfmpegTask* task = (FfmpegTask*)param;
-    if (!task) return 0;
+// Releases the context; outHex (may be null) receives the digest.
+static bool Sha256End(Sha256Ctx& c, std::string* outHex) {
+    BYTE digest[32];
+    bool ok = outHex && c.h && BCRYPT_SUCCESS(BCryptFinishHash(c.h, digest, sizeof(digest), 0));
+    if (c.h) BCryptDestroyHash(c.h);
+    if (c.alg) BCryptCloseAlgorithmProvider(c.alg, 0);
+    c.h = NULL;
+    c.alg = NULL;
+    if (!ok) return false;
 
-    LogLine(L"FFmpegTask start: src=\"%s\" inputCopy=\"%s\" outputTemp=\"%s\" kind=%d refMs=%lld",
-        task->sourceFull.c_str(), task->inputCopy.c_str(),
-        task->outputTemp.c_str(), (int)task->kind, (long long)task->refMs);
-
-    // 1) Create working directory
-    if (!CreateDirectoryW(task->workingDir.c_str(), NULL)) {
-        DWORD e = GetLastError();
-        if (e != ERROR_ALREADY_EXISTS) {
-            std::wstring msg = L"ERROR: Failed to create working directory:\r\n";
-            msg += task->workingDir;
-            msg += L"\r\n";
-            PostFfmpegOutput(task, msg);
-            task->exitCode = 1;
-            task->running = false;
-            PostMessageW(g_hwndMain, WM_APP_FFMPEG_DONE, (WPARAM)task, (LPARAM)task->exitCode);
-            return 0;
-        }
-    }
+    static const char* kHex = "0123456789abcdef";
+    outHex->clear();
+    outHex->reserve(64);
+    for (BYTE b : digest) { outHex->push_back(kHex[b >> 4]); outHex->push_back(kHex[b & 15]); }
+    return true;
+}
 
-    // Paths should already be filled in, but ensure theyre non-empty.
-    if (task->inputCopy.empty() || task->outputTemp.empty()) {
-        PostFfmpegOutput(task, L"ERROR: task paths are not initialized.\r\n");
-        task->exitCode = 2;
-        task->running = false;
-        PostMessageW(g_hwndMain, WM_APP_FFMPEG_DONE, (WPARAM)task, (LPARAM)task->exitCode);
-        return 0;
-    }
+static void MetaCacheSetHashes(const std::wstring& path, ULONGLONG size, ULONGLONG mtime,
+    const std::string& partialHash, const std::string& fullHash);
+static bool SameVolume(const std::wstring& a, const std::wstring& b);
+
+static bool ReadExactAt(HANDLE f, ULONGLONG offset, BYTE* buf, DWORD len) {
+    LARGE_INTEGER li; li.QuadPart = (LONGLONG)offset;
+    if (!SetFilePointerEx(f, li, NULL, FILE_BEGIN)) return false;
+    DWORD got = 0;
+    return ReadFile(f, buf, len, &got, NULL) && got == len;
+}
+
+// ----------------------------- Copy engine (NEW)
+// Replaces CopyFileW / CopyFileExW for every bulk copy. Per file: kCopyDepth overlapped reads
+// and writes of kCopyChunk bytes in flight, destination preallocated, and unbuffered I/O for
+// large files (keeps a 50 GB copy from flushing the file cache). Batches run several files at
+// once. Last-write time and attributes are carried over like CopyFileEx does.
+// With copy_verify the source bytes are hashed as they pass through (no extra read of the
+// source); 'reread' then reads the destination back uncached and compares, 'flush' only
+// flushes it. A mismatch fails the copy with ERROR_CRC and removes the destination.
+// Files of kCopyResumeMin and up are written to <dst>.partial, with a journal (<dst>.mecopy) of
+// how far it is complete, and renamed to dst only once complete (and verified), so an
+// interrupted copy never leaves a truncated file under the real name. A cancelled or failed
+// copy leaves the .partial + journal; the next copy of the same source to the same place
+// re-checks the last chunk and continues there. Network-type errors are retried
+// (kCopyAttempts, doubling waits), each retry resuming the same way.
+static constexpr DWORD kCopyChunk = 1024 * 1024;
+static constexpr int kCopyDepth = 8;
+static constexpr DWORD kCopyAlign = 4096;                         // sector multiple for unbuffered writes
+static constexpr ULONGLONG kCopyUnbufferedMin = 256ULL * 1024 * 1024;
+static constexpr ULONGLONG kCopyResumeMin = 256ULL * 1024 * 1024;
+static constexpr ULONGLONG kCopyJournalEvery = 64ULL * 1024 * 1024;  // journal at most this far behind
+static constexpr int kCopyAttempts = 4;                               // 1 try + 3 retries (1 s, 2 s, 4 s)
+
+struct CopyJob {
+    std::wstring src, dst;
+    ULONGLONG size = 0;
+    DWORD err = 0;
+    bool ok = false;
+    bool createNew = false; // planned fresh name: fail with ERROR_FILE_EXISTS rather than overwrite
+    std::string sha256;     // content hash (copy_verify only)
+};
 
-    // 2) Copy input into working directory
-    {
-        std::wstring msg = L"Copying input to working directory:\r\n  ";
-        msg += task->inputCopy;
-        msg += L"\r\n";
-        PostFfmpegOutput(task, msg);
+struct CopyProgress {
+    ULONGLONG bytesTotal = 0;
+    std::atomic<ULONGLONG> bytesDone{ 0 };
+    const std::atomic<bool>* cancel = nullptr;   // user cancel (may be null)
+    std::atomic<bool> failed{ false };           // first failure stops the rest of a batch
+    std::atomic<DWORD> lastReport{ 0 };
+    std::function<void(ULONGLONG done, ULONGLONG total)> onProgress; // throttled; called on copy threads
+    std::function<void(const CopyJob& job)> onFileDone;              // batch: each completed file, on copy threads
+};
 
-        if (!CopyFileW(task->sourceFull.c_str(), task->inputCopy.c_str(), FALSE)) {
-            std::wstring err = L"ERROR: Failed to copy file:\r\n  ";
-            err += task->sourceFull;
-            err += L"\r\n";
-            PostFfmpegOutput(task, err);
-            task->exitCode = 3;
-            task->running = false;
-            PostMessageW(g_hwndMain, WM_APP_FFMPEG_DONE, (WPARAM)task, (LPARAM)task->exitCode);
-            return 0;
-        }
-    }
+static bool CopyStopped(const CopyProgress& p) {
+    return (p.cancel && p.cancel->load(std::memory_order_relaxed)) || p.failed.load(std::memory_order_relaxed);
+}
 
-    // 3) Build ffmpeg command line
-    double seconds = (double)task->refMs / 1000.0;
-    wchar_t secBuf[64];
-    swprintf_s(secBuf, L"%.3f", seconds);
+static void CopyReport(CopyProgress& p, LONGLONG delta) {
+    ULONGLONG done = p.bytesDone.fetch_add((ULONGLONG)delta) + (ULONGLONG)delta;
+    if (!p.onProgress) return;
+    DWORD now = GetTickCount();
+    DWORD prev = p.lastReport.load();
+    if (now - prev >= 200 && p.lastReport.compare_exchange_strong(prev, now)) p.onProgress(done, p.bytesTotal);
+}
 
-    std::wstring cmd = QuoteArg(g_ffmpegExeW) + L" -y ";
-    switch (task->kind) {
-    case FfmpegOpKind::TrimFront:
-        // Keep from refMs -> end
-        cmd += L"-ss ";
-        cmd += secBuf;
-        cmd += L" -i \"";
-        cmd += task->inputCopy;
-        cmd += L"\" -c copy \"";
-        cmd += task->outputTemp;
-        cmd += L"\"";
-        break;
-    case FfmpegOpKind::TrimEnd:
-        // Keep from 0 -> refMs
-        cmd += L"-i \"";
-        cmd += task->inputCopy;
-        cmd += L"\" -t ";
-        cmd += secBuf;
-        cmd += L" -c copy \"";
-        cmd += task->outputTemp;
-        cmd += L"\"";
-        break;
-    case FfmpegOpKind::HFlip:
-        cmd += L"-i \"";
-        cmd += task->inputCopy;
-        cmd += L"\" -vf hflip -c:a copy \"";
-        cmd += task->outputTemp;
-        cmd += L"\"";
-        break;
-    }
+// ---- Resume journal: "<dst>.mecopy", a few key=value lines (UTF-8)
+struct CopyJournal {
+    std::wstring src;
+    ULONGLONG size = 0;
+    ULONGLONG mtime = 0;
+    ULONGLONG done = 0;     // destination bytes [0, done) are complete (multiple of kCopyChunk)
+};
 
-    PostFfmpegOutput(task, L"Running command:\r\n");
-    PostFfmpegOutput(task, cmd + L"\r\n\r\n");
+static std::wstring CopyJournalPath(const std::wstring& dst) {
+    return dst + L".mecopy";
+}
 
-    SECURITY_ATTRIBUTES sa{};
-    sa.nLength = sizeof(sa);
-    sa.bInheritHandle = TRUE;
-    sa.lpSecurityDescriptor = NULL;
+static std::wstring CopyPartialPath(const std::wstring& dst) {
+    return dst + L".partial";
+}
 
-    HANDLE hRead = NULL, hWrite = NULL;
-    if (!CreatePipe(&hRead, &hWrite, &sa, 0)) {
-        PostFfmpegOutput(task, L"ERROR: Failed to create pipe.\r\n");
-        task->exitCode = 4;
-        task->running = false;
-        PostMessageW(g_hwndMain, WM_APP_FFMPEG_DONE, (WPARAM)task, (LPARAM)task->exitCode);
-        return 0;
-    }
-    SetHandleInformation(hRead, HANDLE_FLAG_INHERIT, 0);
+static void CopyJournalWrite(const std::wstring& dst, const CopyJournal& j) {
+    char nums[160];
+    sprintf_s(nums, "size=%llu\nmtime=%llu\ndone=%llu\n",
+        (unsigned long long)j.size, (unsigned long long)j.mtime, (unsigned long long)j.done);
+    std::string text = "mecopy 1\nsrc=" + ToUtf8(j.src) + "\n" + nums;
 
-    STARTUPINFOW si{};
-    si.cb = sizeof(si);
-    si.dwFlags |= STARTF_USESTDHANDLES;
-    si.hStdOutput = hWrite;
-    si.hStdError = hWrite;
+    HANDLE h = CreateFileW(CopyJournalPath(dst).c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_HIDDEN | FILE_FLAG_WRITE_THROUGH, NULL);
+    if (h == INVALID_HANDLE_VALUE) return; // no journal = no resume, the copy itself is unaffected
+    DWORD wrote = 0;
+    WriteFile(h, text.data(), (DWORD)text.size(), &wrote, NULL);
+    CloseHandle(h);
+}
 
-    PROCESS_INFORMATION pi{};
-    std::vector<wchar_t> cmdBuf(cmd.size() + 1);
-    wcscpy_s(cmdBuf.data(), cmdBuf.size(), cmd.c_str());
-
-    BOOL ok = CreateProcessW(NULL, cmdBuf.data(),
-        NULL, NULL, TRUE,
-        CREATE_NO_WINDOW,
-        NULL, NULL,
-        &si, &pi);
-    CloseHandle(hWrite);
-    hWrite = NULL;
+static bool CopyJournalRead(const std::wstring& dst, CopyJournal& j) {
+    HANDLE h = CreateFileW(CopyJournalPath(dst).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    char buf[8192];
+    DWORD got = 0;
+    BOOL ok = ReadFile(h, buf, sizeof(buf) - 1, &got, NULL);
+    CloseHandle(h);
+    if (!ok) return false;
 
-    if (!ok) {
-        PostFfmpegOutput(task, L"ERROR: Failed to start ffmpeg.\r\n");
-        CloseHandle(hRead);
-        task->exitCode = 5;
-        task->running = false;
-        PostMessageW(g_hwndMain, WM_APP_FFMPEG_DONE, (WPARAM)task, (LPARAM)task->exitCode);
-        return 0;
+    std::istringstream in(std::string(buf, got));
+    std::string line;
+    if (!std::getline(in, line) || line != "mecopy 1") return false;
+    int fields = 0;
+    while (std::getline(in, line)) {
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        std::string k = line.substr(0, eq), v = line.substr(eq + 1);
+        if (k == "src") { j.src = FromUtf8(v); ++fields; }
+        else if (k == "size") { j.size = _strtoui64(v.c_str(), NULL, 10); ++fields; }
+        else if (k == "mtime") { j.mtime = _strtoui64(v.c_str(), NULL, 10); ++fields; }
+        else if (k == "done") { j.done = _strtoui64(v.c_str(), NULL, 10); ++fields; }
+    }
+    return fields == 4;
+}
+
+// Where a copy of jn.src to dst can continue in <dst>.partial (0 = start over). The journal must
+// describe the same source (path, size, last-write time) and the last journaled chunk must still
+// match it: a write that never reached the disk before a crash would otherwise go unnoticed.
+static ULONGLONG CopyResumePoint(const std::wstring& dst, const CopyJournal& jn) {
+    CopyJournal old;
+    if (!CopyJournalRead(dst, old)) return 0;
+    if (_wcsicmp(old.src.c_str(), jn.src.c_str()) != 0 || old.size != jn.size || old.mtime != jn.mtime) return 0;
+    if (old.done < kCopyChunk || old.done >= jn.size || (old.done % kCopyChunk) != 0) return 0;
+
+    const std::wstring partial = CopyPartialPath(dst);
+    WIN32_FILE_ATTRIBUTE_DATA fa{};
+    if (!GetFileAttributesExW(partial.c_str(), GetFileExInfoStandard, &fa)) return 0;
+    ULARGE_INTEGER have; have.HighPart = fa.nFileSizeHigh; have.LowPart = fa.nFileSizeLow;
+    if (have.QuadPart < old.done) return 0;
+
+    const DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    HANDLE a = CreateFileW(jn.src.c_str(), GENERIC_READ, share, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    HANDLE b = CreateFileW(partial.c_str(), GENERIC_READ, share, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    bool same = false;
+    if (a != INVALID_HANDLE_VALUE && b != INVALID_HANDLE_VALUE) {
+        std::vector<BYTE> x(kCopyChunk), y(kCopyChunk);
+        const ULONGLONG at = old.done - kCopyChunk;
+        same = ReadExactAt(a, at, x.data(), kCopyChunk) && ReadExactAt(b, at, y.data(), kCopyChunk) &&
+            memcmp(x.data(), y.data(), kCopyChunk) == 0;
+    }
+    if (a != INVALID_HANDLE_VALUE) CloseHandle(a);
+    if (b != INVALID_HANDLE_VALUE) CloseHandle(b);
+    return same ? old.done : 0;
+}
+
+// A resumed copy with copy_verify hashes the part an earlier attempt copied (source side).
+static bool CopyHashPrefix(const std::wstring& src, ULONGLONG upto, Sha256Ctx& sha, BYTE* buf,
+    const CopyProgress& prog, DWORD& err)
+{
+    HANDLE f = CreateFileW(src.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (f == INVALID_HANDLE_VALUE) { err = GetLastError(); return false; }
+    bool ok = true;
+    for (ULONGLONG at = 0; ok && at < upto; at += kCopyChunk) {
+        if (CopyStopped(prog)) { err = ERROR_CANCELLED; ok = false; break; }
+        DWORD got = 0;
+        if (!ReadFile(f, buf, kCopyChunk, &got, NULL) || got != kCopyChunk) { err = ERROR_HANDLE_EOF; ok = false; break; }
+        if (!Sha256Update(sha, buf, got)) { err = ERROR_CRC; ok = false; }
+    }
+    CloseHandle(f);
+    return ok;
+}
+
+static bool CopyErrorIsTransient(DWORD err) {
+    switch (err) {
+    case ERROR_NETNAME_DELETED:
+    case ERROR_UNEXP_NET_ERR:
+    case ERROR_SEM_TIMEOUT:
+    case ERROR_BAD_NETPATH:
+    case ERROR_NETWORK_UNREACHABLE:
+    case ERROR_CONNECTION_ABORTED:
+    case ERROR_DEV_NOT_EXIST:
+    case ERROR_NOT_READY:
+    case ERROR_IO_DEVICE:
+    case ERROR_TIMEOUT:
+    case ERROR_SHARING_VIOLATION:
+    case ERROR_LOCK_VIOLATION:
+        return true;
+    default:
+        return false;
     }
+}
 
-    task->hProcess = pi.hProcess;
-    CloseHandle(pi.hThread);
+static int CopyFilesInFlight() {
+    return g_cfg.copyFilesInFlight > 0 ? g_cfg.copyFilesInFlight : 4;
+}
 
-    // 4) Read ffmpeg stdout/stderr
-    char buf[4096];
-    DWORD bytes = 0;
-    std::string accum;
+struct CopySlot {
+    OVERLAPPED ov;
+    BYTE* buf;
+    ULONGLONG offset;
+    DWORD len;
+    int state; // 0 idle, 1 reading, 2 writing
+};
 
-    while (ReadFile(hRead, buf, sizeof(buf), &bytes, NULL) && bytes > 0) {
-        accum.append(buf, buf + bytes);
-        size_t pos = 0;
-        while (true) {
-            size_t nl = accum.find('\n', pos);
-            if (nl == std::string::npos) {
-                accum.erase(0, pos);
-                break;
-            }
-            std::string line = accum.substr(pos, nl - pos + 1);
-            pos = nl + 1;
+static bool CopyIssue(HANDLE h, CopySlot& s, bool write, DWORD len, DWORD& err) {
+    s.ov.Offset = (DWORD)(s.offset & 0xFFFFFFFFull);
+    s.ov.OffsetHigh = (DWORD)(s.offset >> 32);
+    BOOL ok = write ? WriteFile(h, s.buf, len, NULL, &s.ov) : ReadFile(h, s.buf, len, NULL, &s.ov);
+    if (!ok && GetLastError() != ERROR_IO_PENDING) { err = GetLastError(); return false; }
+    s.state = write ? 2 : 1;
+    return true;
+}
 
-            int n = MultiByteToWideChar(CP_ACP, 0, line.c_str(), (int)line.size(), NULL, 0);
-            if (n <= 0) continue;
-            std::wstring wline(n, L'\0');
-            MultiByteToWideChar(CP_ACP, 0, line.c_str(), (int)line.size(), &wline[0], n);
-            PostFfmpegOutput(task, wline);
-        }
-    }
-    CloseHandle(hRead);
+// One attempt; 'reported' is what this attempt added to prog.bytesDone (rolled back on retry).
+// Reads dst back around the file cache and compares its SHA-256 with wantHex.
+static bool CopyVerifyReadBack(const std::wstring& dst, ULONGLONG size, const std::string& wantHex,
+    const CopyProgress& prog, DWORD& err)
+{
+    HANDLE f = CreateFileW(dst.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (f == INVALID_HANDLE_VALUE && GetLastError() == ERROR_INVALID_PARAMETER) // redirector without uncached reads
+        f = CreateFileW(dst.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (f == INVALID_HANDLE_VALUE) { err = GetLastError(); return false; }
+    BYTE* buf = (BYTE*)VirtualAlloc(NULL, kCopyChunk, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    Sha256Ctx sha;
+    bool ok = buf && Sha256Begin(sha);
+    if (!ok) err = ERROR_NOT_ENOUGH_MEMORY;
+
+    ULONGLONG total = 0;
+    while (ok) {
+        if (CopyStopped(prog)) { err = ERROR_CANCELLED; ok = false; break; }
+        DWORD got = 0;
+        if (!ReadFile(f, buf, kCopyChunk, &got, NULL)) { err = GetLastError(); ok = false; break; }
+        if (got == 0) break;
+        total += got;
+        if (!Sha256Update(sha, buf, got)) { err = ERROR_CRC; ok = false; }
+    }
+    std::string haveHex;
+    if (!Sha256End(sha, ok ? &haveHex : nullptr) && ok) { err = ERROR_CRC; ok = false; }
+    if (ok && (total != size || haveHex != wantHex)) { err = ERROR_CRC; ok = false; }
+    if (buf) VirtualFree(buf, 0, MEM_RELEASE);
+    CloseHandle(f);
+    return ok;
+}
 
-    WaitForSingleObject(task->hProcess, INFINITE);
-    DWORD exitCode = 0;
-    GetExitCodeProcess(task->hProcess, &exitCode);
-    CloseHandle(task->hProcess);
-    task->hProcess = NULL;
+static void CopyApplyAttributes(const std::wstring& dst, const WIN32_FILE_ATTRIBUTE_DATA& srcInfo) {
+    const DWORD keep = srcInfo.dwFileAttributes & (FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_HIDDEN |
+        FILE_ATTRIBUTE_SYSTEM | FILE_ATTRIBUTE_ARCHIVE | FILE_ATTRIBUTE_NOT_CONTENT_INDEXED);
+    if (keep) SetFileAttributesW(dst.c_str(), keep);
+}
 
-    wchar_t doneMsg[128];
-    swprintf_s(doneMsg, L"\r\n[ffmpeg exited with code %lu]\r\n", exitCode);
-    PostFfmpegOutput(task, doneMsg);
+// ---- Clone-first fast path (same volume only)
+// A block clone shares the source's extents copy-on-write: the result is an independent file,
+// made in milliseconds whatever the size. Only ReFS (incl. Dev Drive) supports it; elsewhere
+// the FSCTL fails and the normal copy runs.
+static constexpr ULONGLONG kCloneChunk = 1ULL << 30;   // bytes per FSCTL call (must stay below 4 GB)
 
-    task->exitCode = exitCode;
+static bool CopyTryBlockClone(const std::wstring& src, const std::wstring& dst, ULONGLONG size,
+    const WIN32_FILE_ATTRIBUTE_DATA& srcInfo, bool createNew)
+{
+    // These need a matching destination set up first; not worth it, take the normal path
+    if (srcInfo.dwFileAttributes & (FILE_ATTRIBUTE_INTEGRITY_STREAM | FILE_ATTRIBUTE_SPARSE_FILE |
+        FILE_ATTRIBUTE_ENCRYPTED | FILE_ATTRIBUTE_COMPRESSED)) return false;
 
-    // On success, rename outputTemp -> inputCopy (so finalWorking is the "base.ext" in video_process)
-    if (exitCode == 0) {
-        // Delete original copy, then rename
-        DeleteFileW(task->inputCopy.c_str());
-        MoveFileExW(task->outputTemp.c_str(), task->inputCopy.c_str(),
-            MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED);
-        task->finalWorking = task->inputCopy;
+    wchar_t root[MAX_PATH]{};
+    DWORD spc = 0, bps = 0, freeC = 0, totalC = 0;
+    if (!GetVolumePathNameW(src.c_str(), root, MAX_PATH) || !GetDiskFreeSpaceW(root, &spc, &bps, &freeC, &totalC))
+        return false;
+    const ULONGLONG cluster = (ULONGLONG)spc * bps;
+    if (!cluster) return false;
+
+    HANDLE hSrc = CreateFileW(src.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hSrc == INVALID_HANDLE_VALUE) return false;
+    DWORD fsFlags = 0;
+    if (!GetVolumeInformationByHandleW(hSrc, NULL, 0, NULL, NULL, &fsFlags, NULL, 0) ||
+        !(fsFlags & FILE_SUPPORTS_BLOCK_REFCOUNTING)) {
+        CloseHandle(hSrc);
+        return false;
     }
 
-    task->running = false;
-    task->done = true;
-    PostMessageW(g_hwndMain, WM_APP_FFMPEG_DONE, (WPARAM)task, (LPARAM)exitCode);
-    LogLine(L"FFmpegTask done: src=\"%s\" exitCode=%lu finalWorking=\"%s\"",
-        task->sourceFull.c_str(), exitCode, task->finalWorking.c_str());
-    return 0;
-}
+    HANDLE hDst = CreateFileW(dst.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, createNew ? CREATE_NEW : CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    bool ok = (hDst != INVALID_HANDLE_VALUE);
+    if (ok) {
+        FILE_END_OF_FILE_INFO eof{};
+        eof.EndOfFile.QuadPart = (LONGLONG)size;
+        ok = SetFileInformationByHandle(hDst, FileEndOfFileInfo, &eof, sizeof(eof)) != FALSE;
+    }
+    for (ULONGLONG off = 0; ok && off < size; off += kCloneChunk) {
+        ULONGLONG len = (size - off < kCloneChunk) ? size - off : kCloneChunk;
+        len = (len + cluster - 1) / cluster * cluster; // ranges are whole clusters; the last may run past EOF
+        DUPLICATE_EXTENTS_DATA dup{};
+        dup.FileHandle = hSrc;
+        dup.SourceFileOffset.QuadPart = (LONGLONG)off;
+        dup.TargetFileOffset.QuadPart = (LONGLONG)off;
+        dup.ByteCount.QuadPart = (LONGLONG)len;
+        DWORD ret = 0;
+        ok = DeviceIoControl(hDst, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &dup, sizeof(dup), NULL, 0, &ret, NULL) != FALSE;
+    }
+    if (ok) SetFileTime(hDst, NULL, NULL, &srcInfo.ftLastWriteTime);
+    if (hDst != INVALID_HANDLE_VALUE) CloseHandle(hDst);
+    CloseHandle(hSrc);
 
-// ----------------------------- Helpers
-static inline bool IsDriveRoot(const std::wstring& p) {
-    return p.size() == 3 &&
-        ((p[0] >= L'A' && p[0] <= L'Z') || (p[0] >= L'a' && p[0] <= L'z')) &&
-        p[1] == L':' && (p[2] == L'\\' || p[2] == L'/');
-}
-static inline std::wstring EnsureSlash(std::wstring p) {
-    if (!p.empty() && p.back() != L'\\' && p.back() != L'/') p.push_back(L'\\');
-    return p;
+    if (!ok) {
+        if (hDst != INVALID_HANDLE_VALUE) DeleteFileW(dst.c_str());
+        return false;
+    }
+    CopyApplyAttributes(dst, srcInfo);
+    return true;
+}
+
+// jn (null = not resumable) is kept up to date while copying; resumable copies write to
+// <dst>.partial (startAt > 0 continues it) and rename it to dst at the end.
+static bool CopyFileEngineOnce(const std::wstring& src, const std::wstring& dst, ULONGLONG size,
+    const WIN32_FILE_ATTRIBUTE_DATA& srcInfo, bool unbuffered, CopyProgress& prog, DWORD& err, ULONGLONG& reported,
+    std::string* hashHex, ULONGLONG startAt, CopyJournal* jn, bool createNew)
+{
+    err = 0;
+    reported = 0;
+    const std::wstring work = jn ? CopyPartialPath(dst) : dst;
+    if (jn && createNew && GetFileAttributesW(dst.c_str()) != INVALID_FILE_ATTRIBUTES) {
+        err = ERROR_FILE_EXISTS; // the rename at the end would fail; say so before copying anything
+        return false;
+    }
+    const DWORD extra = unbuffered ? FILE_FLAG_NO_BUFFERING : 0;
+    HANDLE hSrc = CreateFileW(src.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+        FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN | extra, NULL);
+    if (hSrc == INVALID_HANDLE_VALUE) { err = GetLastError(); return false; }
+    const DWORD disp = startAt ? OPEN_EXISTING : ((createNew && !jn) ? CREATE_NEW : CREATE_ALWAYS);
+    HANDLE hDst = CreateFileW(work.c_str(), GENERIC_WRITE, 0, NULL, disp,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | extra, NULL);
+    if (hDst == INVALID_HANDLE_VALUE) { err = GetLastError(); CloseHandle(hSrc); return false; }
+
+    // Preallocate: one extent up front instead of growing the file chunk by chunk
+    if (!startAt) {
+        FILE_ALLOCATION_INFO alloc{};
+        alloc.AllocationSize.QuadPart = (LONGLONG)size;
+        SetFileInformationByHandle(hDst, FileAllocationInfo, &alloc, sizeof(alloc));
+    }
+
+    BYTE* mem = (BYTE*)VirtualAlloc(NULL, (SIZE_T)kCopyChunk * kCopyDepth, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    CopySlot slots[kCopyDepth] = {};
+    bool ok = (mem != NULL);
+    if (!ok) err = ERROR_NOT_ENOUGH_MEMORY;
+
+    // Ranges reach the read-done branch in offset order (slots are visited and refilled
+    // round-robin), so the hash sees the file front to back.
+    Sha256Ctx sha;
+    ULONGLONG hashedTo = startAt;
+    if (ok && hashHex && !Sha256Begin(sha)) { err = ERROR_NOT_SUPPORTED; ok = false; }
+    if (ok && hashHex && startAt && !CopyHashPrefix(src, startAt, sha, mem, prog, err)) ok = false;
+
+    // Writes also complete in offset order: 'written' is the contiguous complete prefix
+    ULONGLONG written = startAt, journaled = startAt;
+    if (ok && startAt) {
+        CopyReport(prog, (LONGLONG)startAt);
+        reported += startAt;
+    }
+
+    int active = 0;
+    ULONGLONG nextRead = startAt;
+    for (int i = 0; i < kCopyDepth; ++i) {
+        slots[i].buf = mem ? mem + (SIZE_T)i * kCopyChunk : NULL;
+        slots[i].ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        if (ok && nextRead < size) {
+            slots[i].offset = nextRead;
+            if (!CopyIssue(hSrc, slots[i], false, kCopyChunk, err)) { ok = false; break; }
+            nextRead += kCopyChunk;
+            ++active;
+        }
+    }
+
+    // Visit slots round-robin: read done -> write the same range; write done -> read the next range
+    for (int cur = 0; active > 0; cur = (cur + 1) % kCopyDepth) {
+        CopySlot& s = slots[cur];
+        if (s.state == 0) continue;
+        HANDLE h = (s.state == 1) ? hSrc : hDst;
+        DWORD got = 0;
+        BOOL done = GetOverlappedResult(h, &s.ov, &got, TRUE);
+        if (!ok) { s.state = 0; --active; continue; } // draining after a failure
+
+        if (!done) err = GetLastError();
+        else if (CopyStopped(prog)) err = ERROR_CANCELLED;
+        if (err) {
+            ok = false;
+            s.state = 0; --active;
+            CancelIoEx(hSrc, NULL);
+            CancelIoEx(hDst, NULL);
+            continue;
+        }
+
+        if (s.state == 1) {
+            const ULONGLONG want = (size - s.offset < kCopyChunk) ? (size - s.offset) : kCopyChunk;
+            if (got != want) { err = ERROR_HANDLE_EOF; ok = false; s.state = 0; --active; CancelIoEx(hSrc, NULL); CancelIoEx(hDst, NULL); continue; } // source changed
+            if (hashHex && (s.offset != hashedTo || !Sha256Update(sha, s.buf, got))) {
+                err = ERROR_CRC; ok = false; s.state = 0; --active; CancelIoEx(hSrc, NULL); CancelIoEx(hDst, NULL); continue;
+            }
+            hashedTo += got;
+            s.len = got;
+            DWORD wlen = got;
+            if (unbuffered && (wlen % kCopyAlign)) {
+                wlen = (wlen + kCopyAlign - 1) / kCopyAlign * kCopyAlign; // tail is trimmed by the EOF below
+                memset(s.buf + got, 0, wlen - got);
+            }
+            if (!CopyIssue(hDst, s, true, wlen, err)) { ok = false; s.state = 0; --active; CancelIoEx(hSrc, NULL); }
+        }
+        else {
+            CopyReport(prog, s.len);
+            reported += s.len;
+            written = s.offset + s.len;
+            if (jn && written - journaled >= kCopyJournalEvery && written < size) {
+                jn->done = written;
+                CopyJournalWrite(dst, *jn);
+                journaled = written;
+            }
+            if (nextRead < size) {
+                s.offset = nextRead;
+                nextRead += kCopyChunk;
+                if (!CopyIssue(hSrc, s, false, kCopyChunk, err)) { ok = false; s.state = 0; --active; CancelIoEx(hDst, NULL); }
+            }
+            else {
+                s.state = 0; --active;
+            }
+        }
+    }
+
+    for (int i = 0; i < kCopyDepth; ++i) if (slots[i].ov.hEvent) CloseHandle(slots[i].ov.hEvent);
+    if (mem) VirtualFree(mem, 0, MEM_RELEASE);
+
+    if (ok) {
+        FILE_END_OF_FILE_INFO eof{};
+        eof.EndOfFile.QuadPart = (LONGLONG)size;
+        if (!SetFileInformationByHandle(hDst, FileEndOfFileInfo, &eof, sizeof(eof))) { err = GetLastError(); ok = false; }
+    }
+    if (ok) SetFileTime(hDst, NULL, NULL, &srcInfo.ftLastWriteTime);
+    if (ok && hashHex && g_cfg.copyVerify == 2 && !FlushFileBuffers(hDst)) { err = GetLastError(); ok = false; }
+    CloseHandle(hSrc);
+    CloseHandle(hDst);
+
+    if (hashHex) {
+        if (!Sha256End(sha, ok ? hashHex : nullptr) && ok) { err = ERROR_CRC; ok = false; }
+        if (ok && g_cfg.copyVerify == 1) ok = CopyVerifyReadBack(work, size, *hashHex, prog, err);
+        if (!ok) hashHex->clear();
+    }
+
+    if (!ok) {
+        // Keep what is complete for the next attempt, unless the data itself is suspect
+        const bool keep = jn && written >= kCopyChunk && err != ERROR_HANDLE_EOF && err != ERROR_CRC;
+        if (keep) {
+            jn->done = written / kCopyChunk * kCopyChunk;
+            CopyJournalWrite(dst, *jn);
+        }
+        else {
+            DeleteFileW(work.c_str());
+            if (jn) DeleteFileW(CopyJournalPath(dst).c_str());
+        }
+        return false;
+    }
+    if (jn) {
+        if (!MoveFileExW(work.c_str(), dst.c_str(), (createNew ? 0 : MOVEFILE_REPLACE_EXISTING) | MOVEFILE_WRITE_THROUGH)) {
+            err = GetLastError();
+            if (err == ERROR_ALREADY_EXISTS) err = ERROR_FILE_EXISTS;
+            if (CopyErrorIsTransient(err)) return false; // .partial + journal stay: a retry resumes and renames
+            DeleteFileW(work.c_str());
+            DeleteFileW(CopyJournalPath(dst).c_str());
+            return false;
+        }
+        DeleteFileW(CopyJournalPath(dst).c_str());
+    }
+    CopyApplyAttributes(dst, srcInfo);
+    return true;
+}
+
+// Copy one file (overwrites dst; with createNew an existing dst fails with ERROR_FILE_EXISTS).
+// err = ERROR_CANCELLED when stopped via prog.
+// With copy_verify on, sha256 (may be null) receives the verified content hash.
+static bool CopyFileEngine(const std::wstring& src, const std::wstring& dst, CopyProgress& prog, DWORD& err,
+    std::string* sha256 = nullptr, bool createNew = false)
+{
+    WIN32_FILE_ATTRIBUTE_DATA fa{};
+    if (!GetFileAttributesExW(src.c_str(), GetFileExInfoStandard, &fa)) { err = GetLastError(); return false; }
+    ULARGE_INTEGER uli; uli.HighPart = fa.nFileSizeHigh; uli.LowPart = fa.nFileSizeLow;
+
+    bool unbuffered = g_cfg.copyUnbuffered && uli.QuadPart >= kCopyUnbufferedMin;
+    std::string hex;
+    std::string* hashHex = g_cfg.copyVerify ? &hex : nullptr;
+    const ULONGLONG mtime = ((ULONGLONG)fa.ftLastWriteTime.dwHighDateTime << 32) | fa.ftLastWriteTime.dwLowDateTime;
+
+    CopyJournal jn;
+    jn.src = src;
+    jn.size = uli.QuadPart;
+    jn.mtime = mtime;
+    CopyJournal* journal = (uli.QuadPart >= kCopyResumeMin) ? &jn : nullptr;
+
+    // Same volume: clone before moving any data
+    if (uli.QuadPart > 0 && SameVolume(src, dst) && CopyTryBlockClone(src, dst, uli.QuadPart, fa, createNew)) {
+        DeleteFileW(CopyPartialPath(dst).c_str());
+        DeleteFileW(CopyJournalPath(dst).c_str());
+        CopyReport(prog, (LONGLONG)uli.QuadPart);
+        LogLine(L"[Copy] block clone: \"%s\" -> \"%s\"", src.c_str(), dst.c_str());
+        return true;
+    }
+
+    for (int attempt = 1;;) {
+        ULONGLONG reported = 0;
+        const ULONGLONG startAt = journal ? CopyResumePoint(dst, jn) : 0;
+        if (startAt) {
+            LogLine(L"[Copy] resuming \"%s\" at %llu of %llu bytes", dst.c_str(),
+                (unsigned long long)startAt, (unsigned long long)uli.QuadPart);
+        }
+        const bool ok = CopyFileEngineOnce(src, dst, uli.QuadPart, fa, unbuffered, prog, err, reported, hashHex,
+            startAt, journal, createNew);
+        // Written in place (no journal): after the first attempt the destination is ours. Journaled
+        // copies only ever own the .partial; the rename keeps refusing a dst that appeared meanwhile.
+        if (!journal && err != ERROR_FILE_EXISTS) createNew = false;
+        if (ok) {
+            if (hashHex) {
+                // Both files now have this content and the same size + last-write time
+                MetaCacheSetHashes(src, uli.QuadPart, mtime, std::string(), hex);
+                MetaCacheSetHashes(dst, uli.QuadPart, mtime, std::string(), hex);
+                if (sha256) *sha256 = hex;
+            }
+            return true;
+        }
+        CopyReport(prog, -(LONGLONG)reported);
+        // Some redirectors / odd sector sizes reject unbuffered I/O: retry once through the cache
+        if (unbuffered && err != ERROR_CANCELLED && !CopyStopped(prog) &&
+            (err == ERROR_INVALID_PARAMETER || err == ERROR_NOT_SUPPORTED || err == ERROR_INVALID_FUNCTION)) {
+            unbuffered = false;
+            continue;
+        }
+        if (CopyStopped(prog) || !CopyErrorIsTransient(err) || attempt >= kCopyAttempts) return false;
+
+        const DWORD waitMs = 1000u << (attempt - 1);
+        LogLine(L"[Copy] \"%s\" failed (err=%lu); retry %d of %d in %lu ms", src.c_str(), err,
+            attempt, kCopyAttempts - 1, waitMs);
+        for (DWORD waited = 0; waited < waitMs && !CopyStopped(prog); waited += 100) Sleep(100);
+        if (CopyStopped(prog)) return false;
+        ++attempt;
+    }
+}
+
+// Copies all jobs, CopyFilesInFlight() at a time. Returns 0, ERROR_CANCELLED, or the first
+// failing job's error (in job order); job.ok / job.err tell what happened to each file.
+static DWORD CopyEngineRunBatch(std::vector<CopyJob>& jobs, CopyProgress& prog) {
+    prog.bytesTotal = 0;
+    for (auto& j : jobs) {
+        WIN32_FILE_ATTRIBUTE_DATA fa{};
+        if (GetFileAttributesExW(j.src.c_str(), GetFileExInfoStandard, &fa)) {
+            ULARGE_INTEGER uli; uli.HighPart = fa.nFileSizeHigh; uli.LowPart = fa.nFileSizeLow;
+            j.size = uli.QuadPart;
+            prog.bytesTotal += j.size;
+        }
+    }
+
+    std::atomic<bool> noCancel{ false };
+    ParallelFor(jobs.size(), CopyFilesInFlight(), [&](size_t i) {
+        CopyJob& j = jobs[i];
+        if (CopyStopped(prog)) { j.err = ERROR_CANCELLED; return; }
+        j.ok = CopyFileEngine(j.src, j.dst, prog, j.err, &j.sha256, j.createNew);
+        // A name collision only concerns this file: the caller picks a new name and retries it
+        if (!j.ok && j.err != ERROR_CANCELLED && !(j.createNew && j.err == ERROR_FILE_EXISTS)) prog.failed = true;
+        if (j.ok && prog.onFileDone) prog.onFileDone(j);
+    }, prog.cancel ? *prog.cancel : noCancel);
+    if (prog.onProgress) prog.onProgress(prog.bytesDone.load(), prog.bytesTotal); // last one is not throttled
+
+    if (prog.cancel && prog.cancel->load()) return ERROR_CANCELLED;
+    for (const auto& j : jobs) if (!j.ok && j.err && j.err != ERROR_CANCELLED) return j.err;
+    for (const auto& j : jobs) if (!j.ok) return j.err ? j.err : 1;
+    return 0;
+}
+
+// Single-file convenience for the Topaz / copy-to-path paths.
+static bool CopyFileFast(const std::wstring& src, const std::wstring& dst, const std::atomic<bool>* cancel,
+    DWORD& err, const std::function<void(ULONGLONG, ULONGLONG)>& onProgress = nullptr, std::string* sha256 = nullptr,
+    bool createNew = false)
+{
+    CopyProgress prog;
+    prog.cancel = cancel;
+    prog.onProgress = onProgress;
+    WIN32_FILE_ATTRIBUTE_DATA fa{};
+    if (GetFileAttributesExW(src.c_str(), GetFileExInfoStandard, &fa)) {
+        ULARGE_INTEGER uli; uli.HighPart = fa.nFileSizeHigh; uli.LowPart = fa.nFileSizeLow;
+        prog.bytesTotal = uli.QuadPart;
+    }
+    err = 0;
+    const bool ok = CopyFileEngine(src, dst, prog, err, sha256, createNew);
+    if (prog.onProgress) prog.onProgress(prog.bytesDone.load(), prog.bytesTotal); // last one is not throttled
+    return ok;
+}
+
+// ---- Move pipeline: source deletes (slow on SMB) run on their own lane (a High job) while the
+// copy engine streams the next files. Failed deletes fall back to delete-on-reboot. If the pool
+// is too busy to start the lane, the deletes queue up and run when the move finishes.
+struct DeleteLane {
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE wake;
+    std::vector<std::wstring> todo;
+    std::vector<std::pair<std::wstring, DWORD>> failed;   // path, error (queued for reboot)
+    size_t deleted = 0;
+    bool closing = false;
+    uint64_t job = 0;      // lane job id (0 = deletes run inline)
+    HANDLE done = NULL;    // set when the lane job returns
+};
+
+static void DeleteLaneDeleteOne(DeleteLane& lane, const std::wstring& path) {
+    if (DeleteFileW(path.c_str())) {
+        EnterCriticalSection(&lane.lock);
+        ++lane.deleted;
+        LeaveCriticalSection(&lane.lock);
+        return;
+    }
+    DWORD err = GetLastError();
+    MoveFileExW(path.c_str(), NULL, MOVEFILE_DELAY_UNTIL_REBOOT);
+    EnterCriticalSection(&lane.lock);
+    lane.failed.emplace_back(path, err ? err : 1);
+    LeaveCriticalSection(&lane.lock);
+}
+
+static DWORD WINAPI DeleteLaneProc(LPVOID param) {
+    DeleteLane& lane = *(DeleteLane*)param;
+    EnterCriticalSection(&lane.lock);
+    for (;;) {
+        while (lane.todo.empty() && !lane.closing) SleepConditionVariableCS(&lane.wake, &lane.lock, INFINITE);
+        if (lane.todo.empty()) break;
+        std::vector<std::wstring> batch;
+        batch.swap(lane.todo);
+        LeaveCriticalSection(&lane.lock);
+        for (const auto& p : batch) DeleteLaneDeleteOne(lane, p);
+        EnterCriticalSection(&lane.lock);
+    }
+    LeaveCriticalSection(&lane.lock);
+    SetEvent(lane.done); // last touch: the lane may be gone right after
+    return 0;
+}
+
+static void DeleteLaneStart(DeleteLane& lane) {
+    InitializeCriticalSection(&lane.lock);
+    InitializeConditionVariable(&lane.wake);
+    lane.done = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!lane.done) return;
+    lane.job = JobSubmit(JobKind::FileOp, JobPriority::High, DeleteLaneProc, &lane, nullptr, false);
+    if (!lane.job) { CloseHandle(lane.done); lane.done = NULL; }
+}
+
+// Any thread. Without a lane job the delete happens inline.
+static void DeleteLanePush(DeleteLane& lane, const std::wstring& path) {
+    if (!lane.job) { DeleteLaneDeleteOne(lane, path); return; }
+    EnterCriticalSection(&lane.lock);
+    lane.todo.push_back(path);
+    WakeConditionVariable(&lane.wake);
+    LeaveCriticalSection(&lane.lock);
+}
+
+// Runs the remaining deletes and stops the lane.
+static void DeleteLaneFinish(DeleteLane& lane) {
+    if (lane.job) {
+        // The lane job only returns after 'closing', so "not running" here means it never started
+        if (JobWithdraw(lane.job)) {
+            for (const auto& p : lane.todo) DeleteLaneDeleteOne(lane, p);
+            lane.todo.clear();
+        } else {
+            EnterCriticalSection(&lane.lock);
+            lane.closing = true;
+            WakeConditionVariable(&lane.wake);
+            LeaveCriticalSection(&lane.lock);
+            WaitForSingleObject(lane.done, INFINITE);
+        }
+        CloseHandle(lane.done);
+        lane.done = NULL;
+        lane.job = 0;
+    }
+    DeleteCriticalSection(&lane.lock);
+}
+
+// ----------------------------- Native MP4 / MOV trim (NEW)
+// Trim front / trim end of .mp4 / .m4v / .mov without ffmpeg: only the moov box is rebuilt.
+// Every track keeps the samples the kept range needs (from the sync sample at or before the
+// cut to the last sample shown before the end), its sample tables are cut down to them, and a
+// single edit-list entry hides the extra frames, so the cut is frame-accurate with no re-encode.
+// The output is ftyp + moov + mdat holding only the source byte range the kept samples use;
+// where the volume supports block cloning that range is cloned instead of copied.
+// Fragmented files, multi-entry edit lists, stz2 and encryption boxes are not handled: the
+// caller falls back to ffmpeg. Everything up to Mp4TrimFile works on memory only.
+static constexpr uint32_t Mp4Fcc(const char (&s)[5]) {
+    return ((uint32_t)(uint8_t)s[0] << 24) | ((uint32_t)(uint8_t)s[1] << 16) |
+        ((uint32_t)(uint8_t)s[2] << 8) | (uint32_t)(uint8_t)s[3];
+}
+
+static std::wstring Mp4FccStr(uint32_t t) {
+    std::wstring s;
+    for (int sh = 24; sh >= 0; sh -= 8) {
+        const wchar_t c = (wchar_t)((t >> sh) & 0xFF);
+        s += (c >= 32 && c < 127) ? c : L'?';
+    }
+    return s;
+}
+
+static uint32_t Mp4Rd32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+static uint64_t Mp4Rd64(const uint8_t* p) { return ((uint64_t)Mp4Rd32(p) << 32) | Mp4Rd32(p + 4); }
+static void Mp4Put32(std::vector<uint8_t>& v, uint32_t x) {
+    v.push_back((uint8_t)(x >> 24)); v.push_back((uint8_t)(x >> 16));
+    v.push_back((uint8_t)(x >> 8));  v.push_back((uint8_t)x);
+}
+static void Mp4Put64(std::vector<uint8_t>& v, uint64_t x) { Mp4Put32(v, (uint32_t)(x >> 32)); Mp4Put32(v, (uint32_t)x); }
+static void Mp4Set32(uint8_t* p, uint32_t x) { p[0] = (uint8_t)(x >> 24); p[1] = (uint8_t)(x >> 16); p[2] = (uint8_t)(x >> 8); p[3] = (uint8_t)x; }
+static void Mp4Set64(uint8_t* p, uint64_t x) { Mp4Set32(p, (uint32_t)(x >> 32)); Mp4Set32(p + 4, (uint32_t)x); }
+
+// Bounds-checked reader over one box payload; any overrun clears ok.
+struct Mp4Reader {
+    const uint8_t* p = nullptr;
+    size_t n = 0, pos = 0;
+    bool ok = true;
+    Mp4Reader(const std::vector<uint8_t>& v, size_t at = 0) : p(v.data()), n(v.size()), pos(at) {}
+    bool has(size_t k) { if (pos > n || n - pos < k) ok = false; return ok; }
+    uint8_t  u8()  { if (!has(1)) return 0; return p[pos++]; }
+    uint32_t u32() { if (!has(4)) return 0; uint32_t v = Mp4Rd32(p + pos); pos += 4; return v; }
+    uint64_t u64() { if (!has(8)) return 0; uint64_t v = Mp4Rd64(p + pos); pos += 8; return v; }
+    // entry count that fits in what is left (guards against corrupt counts)
+    uint32_t count(size_t entryBytes) { uint32_t c = u32(); if (ok && (n - pos) / entryBytes < c) ok = false; return ok ? c : 0; }
+};
+
+struct Mp4Box {
+    uint32_t type = 0;
+    bool container = false;
+    std::vector<uint8_t> data;      // leaf: payload after the size/type header
+    std::vector<Mp4Box> kids;       // container: child boxes
+};
+
+static bool Mp4IsContainer(uint32_t t) {
+    return t == Mp4Fcc("moov") || t == Mp4Fcc("trak") || t == Mp4Fcc("edts") ||
+        t == Mp4Fcc("mdia") || t == Mp4Fcc("minf") || t == Mp4Fcc("stbl");
+}
+
+static bool Mp4Parse(const uint8_t* p, size_t n, std::vector<Mp4Box>& out) {
+    size_t pos = 0;
+    while (n - pos >= 8) {
+        uint64_t size = Mp4Rd32(p + pos);
+        const uint32_t type = Mp4Rd32(p + pos + 4);
+        size_t hdr = 8;
+        if (size == 1) {
+            if (n - pos < 16) return false;
+            size = Mp4Rd64(p + pos + 8);
+            hdr = 16;
+        }
+        else if (size == 0) size = n - pos;
+        if (size < hdr || size > n - pos) return false;
+
+        Mp4Box b;
+        b.type = type;
+        b.container = Mp4IsContainer(type);
+        if (b.container) {
+            if (!Mp4Parse(p + pos + hdr, (size_t)size - hdr, b.kids)) return false;
+        }
+        else b.data.assign(p + pos + hdr, p + pos + (size_t)size);
+        out.push_back(std::move(b));
+        pos += (size_t)size;
+    }
+    return true;    // a few trailing zero bytes are common (udta terminators)
+}
+
+static void Mp4Write(const Mp4Box& b, std::vector<uint8_t>& out) {
+    const size_t at = out.size();
+    Mp4Put32(out, 0);
+    Mp4Put32(out, b.type);
+    if (b.container) for (const auto& k : b.kids) Mp4Write(k, out);
+    else out.insert(out.end(), b.data.begin(), b.data.end());
+    Mp4Set32(&out[at], (uint32_t)(out.size() - at));
+}
+
+static Mp4Box* Mp4Child(Mp4Box& parent, uint32_t type) {
+    for (auto& k : parent.kids) if (k.type == type) return &k;
+    return nullptr;
+}
+
+// Duration field of mvhd / mdhd (off0/off1 = offset for version 0/1) or tkhd.
+static uint64_t Mp4GetField(const Mp4Box& b, size_t off0, size_t off1, bool wide1) {
+    const bool v1 = !b.data.empty() && b.data[0] == 1;
+    const size_t off = v1 ? off1 : off0;
+    const size_t len = (v1 && wide1) ? 8 : 4;
+    if (b.data.size() < off + len) return 0;
+    return len == 8 ? Mp4Rd64(&b.data[off]) : Mp4Rd32(&b.data[off]);
+}
+static void Mp4SetField(Mp4Box& b, size_t off0, size_t off1, uint64_t v) {
+    const bool v1 = !b.data.empty() && b.data[0] == 1;
+    const size_t off = v1 ? off1 : off0;
+    if (b.data.size() < off + (v1 ? 8 : 4)) return;
+    if (v1) Mp4Set64(&b.data[off], v);
+    else Mp4Set32(&b.data[off], v > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)v);
+}
+// mvhd / mdhd: timescale (32-bit in both versions) and duration; tkhd: duration
+static uint32_t Mp4Timescale(const Mp4Box& hd) { return (uint32_t)Mp4GetField(hd, 12, 20, false); }
+static uint64_t Mp4HdDuration(const Mp4Box& hd) { return Mp4GetField(hd, 16, 24, true); }
+static void Mp4SetHdDuration(Mp4Box& hd, uint64_t v) { Mp4SetField(hd, 16, 24, v); }
+static void Mp4SetTkhdDuration(Mp4Box& tkhd, uint64_t v) { Mp4SetField(tkhd, 20, 28, v); }
+
+// One track's sample tables, expanded to one entry per sample (decode order).
+struct Mp4Samples {
+    std::vector<uint32_t> delta, size, chunk, sdi;
+    std::vector<int64_t> ctsOff;
+    std::vector<uint64_t> dts, offset;
+    std::vector<uint8_t> sync;
+    bool hasCtts = false, hasStss = false;
+    uint8_t cttsVersion = 0;
+    uint32_t uniformSize = 0;       // stsz sample_size when every sample has it
+};
+
+static bool Mp4ReadSamples(Mp4Box& stbl, Mp4Samples& s, std::wstring& why) {
+    const Mp4Box *stts = nullptr, *ctts = nullptr, *stss = nullptr, *stsz = nullptr, *stsc = nullptr, *stco = nullptr;
+    bool co64 = false;
+    for (const auto& k : stbl.kids) {
+        const uint32_t t = k.type;
+        if (t == Mp4Fcc("stts")) stts = &k;
+        else if (t == Mp4Fcc("ctts")) ctts = &k;
+        else if (t == Mp4Fcc("stss")) stss = &k;
+        else if (t == Mp4Fcc("stsz")) stsz = &k;
+        else if (t == Mp4Fcc("stsc")) stsc = &k;
+        else if (t == Mp4Fcc("stco")) stco = &k;
+        else if (t == Mp4Fcc("co64")) { stco = &k; co64 = true; }
+        else if (t != Mp4Fcc("stsd") && t != Mp4Fcc("cslg") && t != Mp4Fcc("sdtp") &&
+            t != Mp4Fcc("sgpd") && t != Mp4Fcc("sbgp")) {
+            why = L"sample table has '" + Mp4FccStr(t) + L"'";
+            return false;
+        }
+    }
+    if (!stts || !stsz || !stsc || !stco) { why = L"incomplete sample table"; return false; }
+
+    Mp4Reader rz(stsz->data, 4);
+    s.uniformSize = rz.u32();
+    const uint32_t n = s.uniformSize ? rz.u32() : rz.count(4);
+    if (!rz.ok || n == 0) { why = L"bad stsz"; return false; }
+    s.size.resize(n, s.uniformSize);
+    if (!s.uniformSize) for (uint32_t i = 0; i < n; ++i) s.size[i] = rz.u32();
+
+    Mp4Reader rt(stts->data, 4);
+    for (uint32_t e = 0, ec = rt.count(8); rt.ok && e < ec; ++e) {
+        const uint32_t cnt = rt.u32(), d = rt.u32();
+        for (uint32_t i = 0; i < cnt && s.delta.size() < n; ++i) s.delta.push_back(d);
+    }
+    if (!rt.ok || s.delta.size() != n) { why = L"stts does not match stsz"; return false; }
+    s.dts.resize(n);
+    for (uint32_t i = 0; i < n; ++i) s.dts[i] = i ? s.dts[i - 1] + s.delta[i - 1] : 0;
+
+    s.ctsOff.assign(n, 0);
+    if (ctts) {
+        s.hasCtts = true;
+        s.cttsVersion = ctts->data.empty() ? 0 : ctts->data[0];
+        Mp4Reader rc(ctts->data, 4);
+        size_t i = 0;
+        for (uint32_t e = 0, ec = rc.count(8); rc.ok && e < ec; ++e) {
+            const uint32_t cnt = rc.u32(), off = rc.u32();
+            const int64_t v = s.cttsVersion ? (int64_t)(int32_t)off : (int64_t)off;
+            for (uint32_t k = 0; k < cnt && i < n; ++k) s.ctsOff[i++] = v;
+        }
+        if (!rc.ok) { why = L"bad ctts"; return false; }
+    }
+
+    s.sync.assign(n, stss ? 0 : 1);
+    if (stss) {
+        s.hasStss = true;
+        Mp4Reader rs(stss->data, 4);
+        for (uint32_t e = 0, ec = rs.count(4); rs.ok && e < ec; ++e) {
+            const uint32_t idx = rs.u32();
+            if (idx >= 1 && idx <= n) s.sync[idx - 1] = 1;
+        }
+        if (!rs.ok) { why = L"bad stss"; return false; }
+    }
+
+    std::vector<uint64_t> chunkOff;
+    Mp4Reader ro(stco->data, 4);
+    for (uint32_t e = 0, ec = ro.count(co64 ? 8 : 4); ro.ok && e < ec; ++e) chunkOff.push_back(co64 ? ro.u64() : ro.u32());
+    if (!ro.ok || chunkOff.empty()) { why = L"bad chunk offsets"; return false; }
+
+    struct Run { uint32_t first, spc, sdi; };
+    std::vector<Run> runs;
+    Mp4Reader rs(stsc->data, 4);
+    for (uint32_t e = 0, ec = rs.count(12); rs.ok && e < ec; ++e) {
+        Run r; r.first = rs.u32(); r.spc = rs.u32(); r.sdi = rs.u32();
+        runs.push_back(r);
+    }
+    if (!rs.ok || runs.empty()) { why = L"bad stsc"; return false; }
+
+    s.chunk.resize(n); s.sdi.resize(n); s.offset.resize(n);
+    size_t i = 0;
+    for (size_t r = 0; r < runs.size() && i < n; ++r) {
+        const uint32_t last = (r + 1 < runs.size()) ? runs[r + 1].first - 1 : (uint32_t)chunkOff.size();
+        if (runs[r].first < 1 || last > chunkOff.size()) { why = L"bad stsc"; return false; }
+        for (uint32_t c = runs[r].first; c <= last && i < n; ++c) {
+            uint64_t at = chunkOff[c - 1];
+            for (uint32_t k = 0; k < runs[r].spc && i < n; ++k, ++i) {
+                s.chunk[i] = c;
+                s.sdi[i] = runs[r].sdi;
+                s.offset[i] = at;
+                at += s.size[i];
+            }
+        }
+    }
+    if (i != n) { why = L"stsc does not cover every sample"; return false; }
+    return true;
+}
+
+// Run-length (count, value) of v[a, b)
+template <class T>
+static std::vector<std::pair<uint32_t, T>> Mp4Runs(const std::vector<T>& v, size_t a, size_t b) {
+    std::vector<std::pair<uint32_t, T>> runs;
+    for (size_t i = a; i < b; ++i) {
+        if (!runs.empty() && runs.back().second == v[i]) ++runs.back().first;
+        else runs.push_back({ 1u, v[i] });
+    }
+    return runs;
+}
+
+// sbgp: same grouping, restricted to samples [a, b)
+static bool Mp4SliceSbgp(std::vector<uint8_t>& data, size_t n, size_t a, size_t b) {
+    Mp4Reader r(data);
+    const uint8_t version = r.u8();
+    r.pos = 8 + (version == 1 ? 4 : 0);
+    std::vector<uint32_t> group(n, 0);
+    size_t i = 0;
+    for (uint32_t e = 0, ec = r.count(8); r.ok && e < ec; ++e) {
+        const uint32_t cnt = r.u32(), g = r.u32();
+        for (uint32_t k = 0; k < cnt && i < n; ++k) group[i++] = g;
+    }
+    if (!r.ok) return false;
+    std::vector<uint8_t> out(data.begin(), data.begin() + 8 + (version == 1 ? 4 : 0));
+    const auto runs = Mp4Runs(group, a, b);
+    Mp4Put32(out, (uint32_t)runs.size());
+    for (const auto& run : runs) { Mp4Put32(out, run.first); Mp4Put32(out, run.second); }
+    data.swap(out);
+    return true;
+}
+
+struct Mp4TrimPlan {
+    std::vector<uint8_t> ftyp;                      // raw box (may be empty: old QuickTime files)
+    Mp4Box moov;
+    std::vector<std::vector<uint64_t>> chunkSrc;    // per trak: new chunks' offsets in the source
+    uint64_t keepLo = 0, keepHi = 0;                // source byte range the kept samples use
+};
+
+// Keeps presentation time [t0Ms, t1Ms) (t1Ms < 0 = to the end). moovPayload = moov without header.
+static bool Mp4TrimPlanBuild(const std::vector<uint8_t>& moovPayload, int64_t t0Ms, int64_t t1Ms,
+    Mp4TrimPlan& plan, std::wstring& why)
+{
+    plan.moov = Mp4Box();
+    plan.moov.type = Mp4Fcc("moov");
+    plan.moov.container = true;
+    if (!Mp4Parse(moovPayload.data(), moovPayload.size(), plan.moov.kids)) { why = L"malformed moov"; return false; }
+    if (Mp4Child(plan.moov, Mp4Fcc("mvex"))) { why = L"fragmented file"; return false; }
+    Mp4Box* mvhd = Mp4Child(plan.moov, Mp4Fcc("mvhd"));
+    const uint32_t movieTs = mvhd ? Mp4Timescale(*mvhd) : 0;
+    if (!movieTs) { why = L"no movie timescale"; return false; }
+
+    plan.chunkSrc.clear();
+    plan.keepLo = ~0ull;
+    plan.keepHi = 0;
+    uint64_t movieDur = 0;
+
+    for (auto& trak : plan.moov.kids) {
+        if (trak.type != Mp4Fcc("trak")) continue;
+        Mp4Box* tkhd = Mp4Child(trak, Mp4Fcc("tkhd"));
+        Mp4Box* mdia = Mp4Child(trak, Mp4Fcc("mdia"));
+        Mp4Box* mdhd = mdia ? Mp4Child(*mdia, Mp4Fcc("mdhd")) : nullptr;
+        Mp4Box* minf = mdia ? Mp4Child(*mdia, Mp4Fcc("minf")) : nullptr;
+        Mp4Box* stbl = minf ? Mp4Child(*minf, Mp4Fcc("stbl")) : nullptr;
+        const uint32_t mediaTs = mdhd ? Mp4Timescale(*mdhd) : 0;
+        if (!tkhd || !stbl || !mediaTs) { why = L"incomplete track"; return false; }
+
+        Mp4Samples s;
+        if (!Mp4ReadSamples(*stbl, s, why)) return false;
+        const size_t n = s.size.size();
+
+        // Existing edit: none, or one plain entry (media_time >= 0, rate 1)
+        int64_t m0Edit = 0;
+        uint64_t segDur = 0;
+        Mp4Box* edts = Mp4Child(trak, Mp4Fcc("edts"));
+        Mp4Box* elst = edts ? Mp4Child(*edts, Mp4Fcc("elst")) : nullptr;
+        if (elst) {
+            Mp4Reader r(elst->data);
+            const uint8_t v = r.u8();
+            r.pos = 4;
+            const uint32_t ec = r.count(v == 1 ? 20 : 12);
+            if (ec > 1) { why = L"multi-entry edit list"; return false; }
+            if (ec == 1) {
+                segDur = v == 1 ? r.u64() : r.u32();
+                m0Edit = v == 1 ? (int64_t)r.u64() : (int64_t)(int32_t)r.u32();
+                const uint32_t rate = r.u32();
+                if (!r.ok || m0Edit < 0 || rate != 0x00010000) { why = L"unsupported edit list"; return false; }
+            }
+        }
+        const int64_t mediaDur = (int64_t)(s.dts[n - 1] + s.delta[n - 1]);
+        int64_t mediaEnd = mediaDur;
+        if (segDur) mediaEnd = (std::min)(mediaEnd, m0Edit + (int64_t)(segDur * mediaTs / movieTs));
+
+        // Kept range in this track's media time
+        const int64_t m0 = m0Edit + t0Ms * (int64_t)mediaTs / 1000;
+        const int64_t m1 = (t1Ms < 0) ? mediaEnd : (std::min)(mediaEnd, m0Edit + t1Ms * (int64_t)mediaTs / 1000);
+        if (m1 <= m0) { why = L"a track ends before the cut"; return false; }
+
+        // a: last sync sample shown at or before m0; b: one past the last sample shown before m1
+        size_t a = n, b = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const int64_t cts = (int64_t)s.dts[i] + s.ctsOff[i];
+            if (s.sync[i] && cts <= m0) a = i;
+            if (cts < m1) b = i + 1;
+        }
+        if (a == n) a = 0;
+        if (b <= a || (int64_t)s.dts[a] > m0 || !s.sync[a]) { why = L"no usable sync sample"; return false; }
+
+        const uint64_t shift = s.dts[a];
+        const int64_t newMediaTime = m0 - (int64_t)shift;
+        const uint64_t newSeg = (uint64_t)(m1 - m0) * movieTs / mediaTs;
+        uint64_t newMediaDur = 0;
+        for (size_t i = a; i < b; ++i) newMediaDur += s.delta[i];
+
+        // Rebuild the sample table in its original box order
+        std::vector<Mp4Box> kids;
+        for (auto& k : stbl->kids) {
+            Mp4Box nb;
+            nb.type = k.type;
+            std::vector<uint8_t>& d = nb.data;
+            if (k.type == Mp4Fcc("stts")) {
+                Mp4Put32(d, 0);
+                const auto runs = Mp4Runs(s.delta, a, b);
+                Mp4Put32(d, (uint32_t)runs.size());
+                for (const auto& r : runs) { Mp4Put32(d, r.first); Mp4Put32(d, r.second); }
+            }
+            else if (k.type == Mp4Fcc("ctts")) {
+                Mp4Put32(d, (uint32_t)s.cttsVersion << 24);
+                const auto runs = Mp4Runs(s.ctsOff, a, b);
+                Mp4Put32(d, (uint32_t)runs.size());
+                for (const auto& r : runs) { Mp4Put32(d, r.first); Mp4Put32(d, (uint32_t)r.second); }
+            }
+            else if (k.type == Mp4Fcc("cslg")) {
+                continue;   // optional summary of ctts; would be stale
+            }
+            else if (k.type == Mp4Fcc("stss")) {
+                Mp4Put32(d, 0);
+                std::vector<uint32_t> idx;
+                for (size_t i = a; i < b; ++i) if (s.sync[i]) idx.push_back((uint32_t)(i - a + 1));
+                Mp4Put32(d, (uint32_t)idx.size());
+                for (uint32_t x : idx) Mp4Put32(d, x);
+            }
+            else if (k.type == Mp4Fcc("stsz")) {
+                Mp4Put32(d, 0);
+                Mp4Put32(d, s.uniformSize);
+                Mp4Put32(d, (uint32_t)(b - a));
+                if (!s.uniformSize) for (size_t i = a; i < b; ++i) Mp4Put32(d, s.size[i]);
+            }
+            else if (k.type == Mp4Fcc("stsc")) {
+                // New chunks: kept samples grouped by their original chunk
+                std::vector<std::pair<uint32_t, uint32_t>> perChunk;    // samples, sdi
+                std::vector<uint64_t> offs;
+                for (size_t i = a; i < b; ++i) {
+                    if (i == a || s.chunk[i] != s.chunk[i - 1]) {
+                        perChunk.push_back({ 0u, s.sdi[i] });
+                        offs.push_back(s.offset[i]);
+                    }
+                    ++perChunk.back().first;
+                    plan.keepLo = (std::min)(plan.keepLo, s.offset[i]);
+                    plan.keepHi = (std::max)(plan.keepHi, s.offset[i] + s.size[i]);
+                }
+                Mp4Put32(d, 0);
+                std::vector<uint8_t> entries;
+                uint32_t count = 0;
+                for (size_t c = 0; c < perChunk.size(); ++c) {
+                    if (c && perChunk[c] == perChunk[c - 1]) continue;
+                    Mp4Put32(entries, (uint32_t)(c + 1));
+                    Mp4Put32(entries, perChunk[c].first);
+                    Mp4Put32(entries, perChunk[c].second);
+                    ++count;
+                }
+                Mp4Put32(d, count);
+                d.insert(d.end(), entries.begin(), entries.end());
+                plan.chunkSrc.push_back(std::move(offs));
+            }
+            else if (k.type == Mp4Fcc("stco") || k.type == Mp4Fcc("co64")) {
+                nb.type = Mp4Fcc("stco");   // filled in by Mp4TrimMoovBytes
+            }
+            else if (k.type == Mp4Fcc("sdtp")) {
+                if (k.data.size() != 4 + n) continue;   // optional; drop if it does not match
+                d.assign(k.data.begin(), k.data.begin() + 4);
+                d.insert(d.end(), k.data.begin() + 4 + a, k.data.begin() + 4 + b);
+            }
+            else if (k.type == Mp4Fcc("sbgp")) {
+                d = k.data;
+                if (!Mp4SliceSbgp(d, n, a, b)) { why = L"bad sbgp"; return false; }
+            }
+            else {
+                nb = k;   // stsd, sgpd
+            }
+            kids.push_back(std::move(nb));
+        }
+        stbl->kids.swap(kids);
+
+        // One edit: skip to the cut, show exactly the kept length
+        Mp4Box nelst;
+        nelst.type = Mp4Fcc("elst");
+        const bool wide = newSeg > 0xFFFFFFFFull || newMediaTime > 0x7FFFFFFF;
+        Mp4Put32(nelst.data, wide ? (1u << 24) : 0u);
+        Mp4Put32(nelst.data, 1);
+        if (wide) { Mp4Put64(nelst.data, newSeg); Mp4Put64(nelst.data, (uint64_t)newMediaTime); }
+        else { Mp4Put32(nelst.data, (uint32_t)newSeg); Mp4Put32(nelst.data, (uint32_t)newMediaTime); }
+        Mp4Put32(nelst.data, 0x00010000);
+        if (elst) *elst = std::move(nelst);
+        else if (edts) edts->kids.push_back(std::move(nelst));
+        else {
+            Mp4Box nedts;
+            nedts.type = Mp4Fcc("edts");
+            nedts.container = true;
+            nedts.kids.push_back(std::move(nelst));
+            size_t at = 0;
+            while (at < trak.kids.size() && trak.kids[at].type != Mp4Fcc("tkhd")) ++at;
+            trak.kids.insert(trak.kids.begin() + (at < trak.kids.size() ? at + 1 : at), std::move(nedts));
+        }
+
+        // tkhd / mdhd pointers are stale if edts was inserted; look them up again
+        Mp4SetTkhdDuration(*Mp4Child(trak, Mp4Fcc("tkhd")), newSeg);
+        Mp4SetHdDuration(*Mp4Child(*Mp4Child(trak, Mp4Fcc("mdia")), Mp4Fcc("mdhd")), newMediaDur);
+        movieDur = (std::max)(movieDur, newSeg);
+    }
+    if (plan.chunkSrc.empty() || plan.keepHi <= plan.keepLo) { why = L"no tracks"; return false; }
+    Mp4SetHdDuration(*Mp4Child(plan.moov, Mp4Fcc("mvhd")), movieDur);
+    return true;
+}
+
+// Serialized moov (with header) for media data starting at file offset payloadStart.
+static std::vector<uint8_t> Mp4TrimMoovBytes(Mp4TrimPlan& plan, uint64_t payloadStart, bool co64) {
+    size_t t = 0;
+    for (auto& trak : plan.moov.kids) {
+        if (trak.type != Mp4Fcc("trak")) continue;
+        Mp4Box& stbl = *Mp4Child(*Mp4Child(*Mp4Child(trak, Mp4Fcc("mdia")), Mp4Fcc("minf")), Mp4Fcc("stbl"));
+        Mp4Box* box = Mp4Child(stbl, Mp4Fcc("stco"));
+        if (!box) box = Mp4Child(stbl, Mp4Fcc("co64"));
+        const std::vector<uint64_t>& offs = plan.chunkSrc[t++];
+        box->type = co64 ? Mp4Fcc("co64") : Mp4Fcc("stco");
+        box->data.clear();
+        Mp4Put32(box->data, 0);
+        Mp4Put32(box->data, (uint32_t)offs.size());
+        for (uint64_t o : offs) {
+            const uint64_t v = o - plan.keepLo + payloadStart;
+            if (co64) Mp4Put64(box->data, v); else Mp4Put32(box->data, (uint32_t)v);
+        }
+    }
+    std::vector<uint8_t> out;
+    Mp4Write(plan.moov, out);
+    return out;
+}
+
+static bool Mp4TrimSupportedExt(const std::wstring& path) {
+    const wchar_t* ext = PathFindExtensionW(path.c_str());
+    return _wcsicmp(ext, L".mp4") == 0 || _wcsicmp(ext, L".m4v") == 0 || _wcsicmp(ext, L".mov") == 0;
+}
+
+static bool Mp4WriteAt(HANDLE h, ULONGLONG offset, const void* p, size_t len) {
+    LARGE_INTEGER li; li.QuadPart = (LONGLONG)offset;
+    if (!SetFilePointerEx(h, li, NULL, FILE_BEGIN)) return false;
+    DWORD wrote = 0;
+    return WriteFile(h, p, (DWORD)len, &wrote, NULL) && wrote == len;
+}
+
+// Source [srcOff, srcOff+len) -> destination at dstOff. Cluster-aligned middle part is cloned when
+// possible (dstOff must then be congruent to srcOff modulo the cluster size).
+static DWORD Mp4CopyRange(HANDLE hSrc, ULONGLONG srcOff, HANDLE hDst, ULONGLONG dstOff, ULONGLONG len,
+    ULONGLONG cloneCluster, const std::atomic<bool>* cancel)
+{
+    ULONGLONG cloneLo = 0, cloneHi = 0;
+    if (cloneCluster) {
+        cloneLo = (srcOff + cloneCluster - 1) / cloneCluster * cloneCluster;
+        cloneHi = (srcOff + len) / cloneCluster * cloneCluster;
+        for (ULONGLONG off = cloneLo; off < cloneHi; off += kCloneChunk) {
+            DUPLICATE_EXTENTS_DATA dup{};
+            dup.FileHandle = hSrc;
+            dup.SourceFileOffset.QuadPart = (LONGLONG)off;
+            dup.TargetFileOffset.QuadPart = (LONGLONG)(off - srcOff + dstOff);
+            dup.ByteCount.QuadPart = (LONGLONG)(std::min)(kCloneChunk, cloneHi - off);
+            DWORD ret = 0;
+            if (!DeviceIoControl(hDst, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &dup, sizeof(dup), NULL, 0, &ret, NULL)) {
+                cloneLo = cloneHi = 0;  // copy it all instead
+                break;
+            }
+        }
+        if (cloneHi <= cloneLo) cloneLo = cloneHi = 0;
+    }
+
+    std::vector<BYTE> buf(4 * 1024 * 1024);
+    auto copy = [&](ULONGLONG from, ULONGLONG to) -> DWORD {
+        for (ULONGLONG at = from; at < to;) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) return ERROR_CANCELLED;
+            const DWORD n = (DWORD)(std::min)((ULONGLONG)buf.size(), to - at);
+            if (!ReadExactAt(hSrc, at, buf.data(), n)) return GetLastError() ? GetLastError() : ERROR_HANDLE_EOF;
+            if (!Mp4WriteAt(hDst, at - srcOff + dstOff, buf.data(), n)) return GetLastError() ? GetLastError() : ERROR_WRITE_FAULT;
+            at += n;
+        }
+        return 0;
+    };
+    if (cloneHi > cloneLo) {
+        DWORD e = copy(srcOff, cloneLo);
+        return e ? e : copy(cloneHi, srcOff + len);
+    }
+    return copy(srcOff, srcOff + len);
+}
+
+// Writes the trimmed file to dst. 0 = done; ERROR_NOT_SUPPORTED (why says what) or any I/O
+// error = nothing usable was written (the caller can fall back to ffmpeg).
+static DWORD Mp4TrimFile(const std::wstring& src, const std::wstring& dst, int64_t t0Ms, int64_t t1Ms,
+    const std::atomic<bool>* cancel, std::wstring& why)
+{
+    HANDLE hSrc = CreateFileW(src.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hSrc == INVALID_HANDLE_VALUE) { why = L"cannot open source"; return GetLastError(); }
+    LARGE_INTEGER fileSize{};
+    GetFileSizeEx(hSrc, &fileSize);
+
+    // Top level: need moov + mdat; ftyp is carried over as-is
+    Mp4TrimPlan plan;
+    std::vector<uint8_t> moovPayload;
+    bool haveMdat = false;
+    DWORD rc = ERROR_NOT_SUPPORTED;
+    for (ULONGLONG pos = 0; pos + 8 <= (ULONGLONG)fileSize.QuadPart;) {
+        BYTE h[16];
+        if (!ReadExactAt(hSrc, pos, h, 8)) break;
+        ULONGLONG size = Mp4Rd32(h);
+        const uint32_t type = Mp4Rd32(h + 4);
+        ULONGLONG hdr = 8;
+        if (size == 1) {
+            if (!ReadExactAt(hSrc, pos + 8, h + 8, 8)) break;
+            size = Mp4Rd64(h + 8);
+            hdr = 16;
+        }
+        else if (size == 0) size = (ULONGLONG)fileSize.QuadPart - pos;
+        if (size < hdr || size > (ULONGLONG)fileSize.QuadPart - pos) { why = L"malformed top-level box"; break; }
+
+        if (type == Mp4Fcc("moof")) { why = L"fragmented file"; moovPayload.clear(); break; }
+        if (type == Mp4Fcc("mdat")) haveMdat = true;
+        if (type == Mp4Fcc("ftyp") || type == Mp4Fcc("moov")) {
+            if (size > 256ull * 1024 * 1024) { why = L"moov too large"; moovPayload.clear(); break; }
+            std::vector<uint8_t> box((size_t)size);
+            if (!ReadExactAt(hSrc, pos, box.data(), (DWORD)size)) { rc = GetLastError(); why = L"read failed"; moovPayload.clear(); break; }
+            if (type == Mp4Fcc("ftyp")) {
+                if (hdr == 16) box.erase(box.begin() + 8, box.begin() + 16);   // 64-bit header -> 32-bit
+                Mp4Set32(box.data(), (uint32_t)box.size());
+                plan.ftyp.swap(box);
+            }
+            else moovPayload.assign(box.begin() + (size_t)hdr, box.end());
+        }
+        pos += size;
+    }
+    if (moovPayload.empty() || !haveMdat) {
+        if (why.empty()) why = L"no moov / mdat";
+        CloseHandle(hSrc);
+        return rc;
+    }
+    if (!Mp4TrimPlanBuild(moovPayload, t0Ms, t1Ms, plan, why)) { CloseHandle(hSrc); return ERROR_NOT_SUPPORTED; }
+    moovPayload.clear();
+
+    // Clone the media range when source and output share a block-cloning volume
+    ULONGLONG cluster = 0;
+    DWORD fsFlags = 0;
+    if (SameVolume(src, dst) && GetVolumeInformationByHandleW(hSrc, NULL, 0, NULL, NULL, &fsFlags, NULL, 0) &&
+        (fsFlags & FILE_SUPPORTS_BLOCK_REFCOUNTING)) {
+        wchar_t root[MAX_PATH]{};
+        DWORD spc = 0, bps = 0, freeC = 0, totalC = 0;
+        if (GetVolumePathNameW(src.c_str(), root, MAX_PATH) && GetDiskFreeSpaceW(root, &spc, &bps, &freeC, &totalC))
+            cluster = (ULONGLONG)spc * bps;
+    }
+
+    // Layout: ftyp, moov, [free pad], mdat (64-bit header), kept bytes. The pad lines the media up
+    // with the source's cluster boundaries so it can be cloned.
+    const ULONGLONG keepLen = plan.keepHi - plan.keepLo;
+    const bool co64 = keepLen + plan.ftyp.size() + Mp4TrimMoovBytes(plan, 0, true).size() + cluster + 32 > 0xFFFFFFFFull;
+    const size_t moovSize = Mp4TrimMoovBytes(plan, 0, co64).size();
+    ULONGLONG head = plan.ftyp.size() + moovSize + 16, pad = 0;
+    if (cluster) {
+        pad = (plan.keepLo % cluster + cluster - head % cluster) % cluster;
+        if (pad && pad < 8) pad += cluster;
+    }
+    const ULONGLONG payloadStart = head + pad;
+    const std::vector<uint8_t> moov = Mp4TrimMoovBytes(plan, payloadStart, co64);
+
+    std::vector<uint8_t> hdrs(plan.ftyp);
+    hdrs.insert(hdrs.end(), moov.begin(), moov.end());
+    if (pad) {
+        Mp4Put32(hdrs, (uint32_t)pad);
+        Mp4Put32(hdrs, Mp4Fcc("free"));
+        hdrs.resize(hdrs.size() + (size_t)pad - 8, 0);
+    }
+    Mp4Put32(hdrs, 1);
+    Mp4Put32(hdrs, Mp4Fcc("mdat"));
+    Mp4Put64(hdrs, 16 + keepLen);
+
+    HANDLE hDst = CreateFileW(dst.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hDst == INVALID_HANDLE_VALUE) { rc = GetLastError(); why = L"cannot create output"; CloseHandle(hSrc); return rc; }
+    FILE_END_OF_FILE_INFO eof{};
+    eof.EndOfFile.QuadPart = (LONGLONG)(payloadStart + keepLen);
+    rc = SetFileInformationByHandle(hDst, FileEndOfFileInfo, &eof, sizeof(eof)) ? 0 : GetLastError();
+    if (!rc && !Mp4WriteAt(hDst, 0, hdrs.data(), hdrs.size())) rc = GetLastError() ? GetLastError() : ERROR_WRITE_FAULT;
+    if (!rc) rc = Mp4CopyRange(hSrc, plan.keepLo, hDst, payloadStart, keepLen, cluster, cancel);
+    CloseHandle(hDst);
+    CloseHandle(hSrc);
+    if (rc) {
+        if (rc != ERROR_CANCELLED) why = L"write failed";
+        DeleteFileW(dst.c_str());
+        return rc;
+    }
+    LogLine(L"[MP4 trim] \"%s\" -> \"%s\": kept %llu of %llu bytes%s", src.c_str(), dst.c_str(),
+        (unsigned long long)keepLen, (unsigned long long)fileSize.QuadPart, cluster ? L" (block-clone volume)" : L"");
+    return 0;
+}
+
+// ---- Display-matrix flip (MP4 / MOV)
+// A horizontal flip is only a change of the video track's tkhd matrix: x' = a*x + c*y + tx
+// becomes its mirror across the displayed width (a, c negated; tx moved). Applying it twice
+// gives the original matrix back. No sample data is read or written.
+
+// First direct child of the given type in p[0, n): payload offset / length.
+static bool Mp4ChildAt(const uint8_t* p, size_t n, uint32_t type, size_t& at, size_t& len, size_t start = 0) {
+    for (size_t pos = start; n - pos >= 8 && pos < n;) {
+        uint64_t size = Mp4Rd32(p + pos);
+        size_t hdr = 8;
+        if (size == 1) { if (n - pos < 16) return false; size = Mp4Rd64(p + pos + 8); hdr = 16; }
+        else if (size == 0) size = n - pos;
+        if (size < hdr || size > n - pos) return false;
+        if (Mp4Rd32(p + pos + 4) == type) { at = pos + hdr; len = (size_t)size - hdr; return true; }
+        pos += (size_t)size;
+    }
+    return false;
+}
+
+// Payload of the top-level moov and its file offset.
+static bool Mp4ReadMoov(HANDLE h, ULONGLONG& payloadAt, std::vector<uint8_t>& moov) {
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(h, &fileSize)) return false;
+    for (ULONGLONG pos = 0; pos + 8 <= (ULONGLONG)fileSize.QuadPart;) {
+        BYTE hb[16];
+        if (!ReadExactAt(h, pos, hb, 8)) return false;
+        ULONGLONG size = Mp4Rd32(hb);
+        ULONGLONG hdr = 8;
+        if (size == 1) {
+            if (!ReadExactAt(h, pos + 8, hb + 8, 8)) return false;
+            size = Mp4Rd64(hb + 8);
+            hdr = 16;
+        }
+        else if (size == 0) size = (ULONGLONG)fileSize.QuadPart - pos;
+        if (size < hdr || size > (ULONGLONG)fileSize.QuadPart - pos) return false;
+        if (Mp4Rd32(hb + 4) != Mp4Fcc("moov")) { pos += size; continue; }
+        if (size > 256ull * 1024 * 1024) return false;
+
+        moov.resize((size_t)(size - hdr));
+        payloadAt = pos + hdr;
+        return ReadExactAt(h, payloadAt, moov.data(), (DWORD)moov.size());
+    }
+    return false;
+}
+
+// File offset and bytes of the first video track's tkhd payload.
+static bool Mp4FindVideoTkhd(HANDLE h, ULONGLONG& tkhdAt, std::vector<uint8_t>& tkhd) {
+    ULONGLONG moovAt = 0;
+    std::vector<uint8_t> moov;
+    if (!Mp4ReadMoov(h, moovAt, moov)) return false;
+    const uint8_t* m = moov.data();
+    size_t tAt = 0, tLen = 0;
+    for (size_t from = 0; Mp4ChildAt(m, moov.size(), Mp4Fcc("trak"), tAt, tLen, from); from = tAt + tLen) {
+        size_t kAt = 0, kLen = 0, dAt = 0, dLen = 0, hAt = 0, hLen = 0;
+        if (!Mp4ChildAt(m + tAt, tLen, Mp4Fcc("tkhd"), kAt, kLen) ||
+            !Mp4ChildAt(m + tAt, tLen, Mp4Fcc("mdia"), dAt, dLen) ||
+            !Mp4ChildAt(m + tAt + dAt, dLen, Mp4Fcc("hdlr"), hAt, hLen) || hLen < 12) continue;
+        if (Mp4Rd32(m + tAt + dAt + hAt + 8) != Mp4Fcc("vide")) continue;
+        tkhdAt = moovAt + tAt + kAt;
+        tkhd.assign(m + tAt + kAt, m + tAt + kAt + kLen);
+        return true;
+    }
+    return false;
+}
+
+static size_t Mp4TkhdMatrixOffset(const std::vector<uint8_t>& tkhd) {
+    const size_t off = (!tkhd.empty() && tkhd[0] == 1) ? 52 : 40;
+    return tkhd.size() >= off + 36 + 8 ? off : 0;    // matrix, then width + height
+}
+
+// True when the track's display matrix mirrors the picture (negative determinant).
+static bool Mp4MatrixMirrored(const std::vector<uint8_t>& tkhd) {
+    const size_t off = Mp4TkhdMatrixOffset(tkhd);
+    if (!off) return false;
+    const int64_t a = (int32_t)Mp4Rd32(&tkhd[off]), b = (int32_t)Mp4Rd32(&tkhd[off + 4]);
+    const int64_t c = (int32_t)Mp4Rd32(&tkhd[off + 12]), d = (int32_t)Mp4Rd32(&tkhd[off + 16]);
+    return a * d - b * c < 0;
+}
+
+static bool Mp4FileMirrored(const std::wstring& path) {
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    ULONGLONG at = 0;
+    std::vector<uint8_t> tkhd;
+    const bool mirrored = Mp4FindVideoTkhd(h, at, tkhd) && Mp4MatrixMirrored(tkhd);
+    CloseHandle(h);
+    return mirrored;
+}
+
+// In-place flip journal: "<file>.meflip" holds the matrix offset and the 36 original bytes while
+// they are rewritten; one left behind by a crash puts them back (see FfTempRecoverList).
+static std::wstring Mp4FlipJournalPath(const std::wstring& path) {
+    return path + L".meflip";
+}
+
+static void Mp4FlipJournalRestore(const std::wstring& journal) {
+    const std::wstring target = journal.substr(0, journal.size() - wcslen(L".meflip"));
+    HANDLE j = CreateFileW(journal.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (j == INVALID_HANDLE_VALUE) return;
+    uint8_t rec[8 + 36];
+    DWORD got = 0;
+    const bool whole = ReadFile(j, rec, sizeof(rec), &got, NULL) && got == sizeof(rec);
+    CloseHandle(j);
+    bool ok = !whole;   // a torn journal was written before the file was touched
+    if (whole) {
+        HANDLE h = CreateFileW(target.c_str(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (h != INVALID_HANDLE_VALUE) {
+            LARGE_INTEGER li; li.QuadPart = (LONGLONG)Mp4Rd64(rec);
+            DWORD wrote = 0;
+            ok = SetFilePointerEx(h, li, NULL, FILE_BEGIN) && WriteFile(h, rec + 8, 36, &wrote, NULL) && wrote == 36;
+            CloseHandle(h);
+        }
+    }
+    if (ok) DeleteFileW(journal.c_str());
+    LogLine(L"[MP4 flip] interrupted in-place flip of \"%s\": %s", target.c_str(), ok ? L"restored" : L"NOT restored");
+}
+
+// Mirrors the video track of 'path' in place (36 bytes written). false = not an MP4 we can edit.
+// journaled: the original bytes are kept in Mp4FlipJournalPath(path) until the write is durable.
+static bool Mp4ToggleHFlip(const std::wstring& path, std::wstring& why, bool journaled = false) {
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) { why = L"cannot open file"; return false; }
+    ULONGLONG at = 0;
+    std::vector<uint8_t> tkhd;
+    size_t off = 0;
+    if (!Mp4FindVideoTkhd(h, at, tkhd) || !(off = Mp4TkhdMatrixOffset(tkhd))) {
+        CloseHandle(h);
+        why = L"no video track header";
+        return false;
+    }
+    uint8_t* mx = &tkhd[off];
+    const std::wstring journal = journaled ? Mp4FlipJournalPath(path) : L"";
+    if (journaled) {
+        uint8_t rec[8 + 36];
+        const ULONGLONG matrixAt = at + off;
+        for (int i = 0; i < 8; ++i) rec[i] = (uint8_t)(matrixAt >> (56 - 8 * i));
+        memcpy(rec + 8, mx, 36);
+        HANDLE j = CreateFileW(journal.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_HIDDEN | FILE_FLAG_WRITE_THROUGH, NULL);
+        DWORD wrote = 0;
+        const bool saved = j != INVALID_HANDLE_VALUE && WriteFile(j, rec, sizeof(rec), &wrote, NULL) && wrote == sizeof(rec);
+        if (j != INVALID_HANDLE_VALUE) CloseHandle(j);
+        if (!saved) {
+            DeleteFileW(journal.c_str());
+            CloseHandle(h);
+            why = L"cannot write the flip journal";
+            return false;
+        }
+    }
+    const double a = (int32_t)Mp4Rd32(mx) / 65536.0, c = (int32_t)Mp4Rd32(mx + 12) / 65536.0;
+    const double tx = (int32_t)Mp4Rd32(mx + 24) / 65536.0;
+    const double w = Mp4Rd32(mx + 36) / 65536.0, hgt = Mp4Rd32(mx + 40) / 65536.0;
+
+    // Horizontal extent of the transformed picture (corners, without tx)
+    const double xs[4] = { 0.0, a * w, c * hgt, a * w + c * hgt };
+    const double lo = (std::min)((std::min)(xs[0], xs[1]), (std::min)(xs[2], xs[3]));
+    const double hi = (std::max)((std::max)(xs[0], xs[1]), (std::max)(xs[2], xs[3]));
+
+    Mp4Set32(mx, (uint32_t)(int32_t)std::llround(-a * 65536.0));
+    Mp4Set32(mx + 12, (uint32_t)(int32_t)std::llround(-c * 65536.0));
+    Mp4Set32(mx + 24, (uint32_t)(int32_t)std::llround((tx + lo + hi) * 65536.0));
+
+    LARGE_INTEGER li; li.QuadPart = (LONGLONG)(at + off);
+    DWORD wrote = 0;
+    const bool ok = SetFilePointerEx(h, li, NULL, FILE_BEGIN) && WriteFile(h, mx, 36, &wrote, NULL) && wrote == 36 &&
+        (!journaled || FlushFileBuffers(h));
+    CloseHandle(h);
+    if (!ok) why = L"write failed";
+    if (journaled) {
+        if (ok) DeleteFileW(journal.c_str());
+        else Mp4FlipJournalRestore(journal);
+    }
+    return ok;
+}
+
+static bool MkvSupportedExt(const std::wstring& path) {
+    const wchar_t* ext = PathFindExtensionW(path.c_str());
+    return _wcsicmp(ext, L".mkv") == 0 || _wcsicmp(ext, L".webm") == 0;
+}
+
+// ----------------------------- FFmpeg task log window + helpers
+
+static LRESULT CALLBACK FfmpegLogProc(HWND h, UINT m, WPARAM w, LPARAM l) {
+    FfmpegTask* task = reinterpret_cast<FfmpegTask*>(GetWindowLongPtrW(h, GWLP_USERDATA));
+    switch (m) {
+    case WM_CREATE: {
+        LPCREATESTRUCT pcs = (LPCREATESTRUCT)l;
+        task = (FfmpegTask*)pcs->lpCreateParams;
+        SetWindowLongPtrW(h, GWLP_USERDATA, (LONG_PTR)task);
+
+        HFONT hf = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
+        RECT rc; GetClientRect(h, &rc);
+
+        HWND hEdit = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"",
+            WS_CHILD | WS_VISIBLE | ES_MULTILINE | ES_AUTOVSCROLL | ES_READONLY | WS_VSCROLL,
+            4, 4, rc.right - 8, rc.bottom - 8, h, (HMENU)101, g_hInst, NULL);
+        SendMessageW(hEdit, WM_SETFONT, (WPARAM)hf, TRUE);
+
+        if (task) task->hEdit = hEdit;
+        return 0;
+    }
+    case WM_SIZE: {
+        if (task && task->hEdit) {
+            RECT rc; GetClientRect(h, &rc);
+            MoveWindow(task->hEdit, 4, 4, rc.right - 8, rc.bottom - 8, TRUE);
+        }
+        return 0;
+    }
+    case WM_CLOSE:
+        ShowWindow(h, SW_HIDE); // hide, don't destroy; keep log available
+        return 0;
+    }
+    return DefWindowProcW(h, m, w, l);
+}
+
+static void EnsureFfmpegLogClass() {
+    static bool reg = false;
+    if (!reg) {
+        WNDCLASSW wc{}; wc.lpfnWndProc = FfmpegLogProc; wc.hInstance = g_hInst;
+        wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+        wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
+        wc.lpszClassName = L"FfmpegLogClass";
+        RegisterClassW(&wc);
+        reg = true;
+    }
+}
+
+static HWND CreateFfmpegLogWindow(FfmpegTask* task) {
+    RECT wa{}; GetWorkAreaForOwner(g_hwndMain, wa);
+    int W = DpiScale(640), H = DpiScale(480);
+    int X = 0, Y = 0; CenterInWorkArea(wa, W, H, X, Y);
+
+    std::wstring title = L"FFmpeg task: ";
+    title += task ? task->title : L"(unknown)";
+
+    HWND hwnd = CreateWindowExW(WS_EX_TOOLWINDOW, L"FfmpegLogClass", title.c_str(),
+        WS_OVERLAPPEDWINDOW | WS_VISIBLE,
+        X, Y, W, H, g_hwndMain, NULL, g_hInst, task);
+
+    if (hwnd && task)
+    {
+        task->hwnd = hwnd;
+
+        if (g_inPlayback)
+        {
+            if (IsWindowVisible(hwnd))
+                ShowWindow(hwnd, SW_HIDE);
+            task->hiddenByPlayback = true;
+        }
+    }
+    return hwnd;
+}
+
+static void PostFfmpegOutput(FfmpegTask* task, const std::wstring& text) {
+    JobPostOutput(JobKind::Ffmpeg, task, text);
+}
+
+static bool FfmpegPlanHasEdits(const FfmpegTask* t) {
+    return t->keepFromMs > 0 || t->keepToMs >= 0 || t->hflip;
+}
+
+// "trim front 12.500 s, trim end 61.000 s, horizontal flip" (log window / log file)
+static std::wstring FfmpegPlanText(const FfmpegTask* t) {
+    std::wstring out;
+    wchar_t b[96];
+    if (t->keepFromMs > 0) {
+        swprintf_s(b, L"trim front %.3f s", (double)t->keepFromMs / 1000.0);
+        out += b;
+    }
+    if (t->keepToMs >= 0) {
+        swprintf_s(b, L"%strim end %.3f s", out.empty() ? L"" : L", ", (double)t->keepToMs / 1000.0);
+        out += b;
+    }
+    if (t->hflip) {
+        out += out.empty() ? L"" : L", ";
+        out += t->bakeFlip ? L"horizontal flip (baked in)" : L"horizontal flip";
+    }
+    return out.empty() ? L"(no edits)" : out;
+}
+
+// Keyframe index (defined with the metadata cache)
+static bool KeyframeIndexGet(const std::wstring& path, std::vector<uint32_t>& kf, bool& allIntra);
+static int64_t KeyframeNearest(const std::vector<uint32_t>& kf, int64_t t);
+static std::string FfconcatFileLine(const std::wstring& path);
+
+// Metadata cache
+static int64_t MetaCacheDurationMs(const std::wstring& path);
+
+// ----------------------------- FFmpeg progress (NEW)
+// Every ffmpeg run gets -nostats -progress pipe:1: about twice a second it prints a block of
+// key=value lines (out_time_us, fps, bitrate, speed, ...) ending in progress=continue|end.
+// Blocks drive the status bar (percent / ETA against the expected output length from the
+// metadata cache); the log only gets one progress line every kFfProgressLogMs.
+static constexpr ULONGLONG kFfProgressLogMs = 10000;
+
+struct FfmpegProgress {
+    int64_t outTimeMs = -1;     // output position (-1 = not known yet)
+    double  fps = 0.0;
+    double  speed = 0.0;        // x realtime (0 = not known yet)
+    std::string bitrate;        // as printed, e.g. "2510.3kbits/s"
+    bool    ended = false;      // progress=end
+};
+
+// cmd (executable first, maybe quoted) with the progress options put right after the executable.
+static std::wstring FfmpegWithProgressArgs(const std::wstring& cmd) {
+    const bool quoted = !cmd.empty() && cmd[0] == L'"';
+    size_t end = quoted ? cmd.find(L'"', 1) : cmd.find(L' ');
+    if (end == std::wstring::npos) return cmd + L" -nostats -progress pipe:1";
+    if (quoted) ++end;
+    return cmd.substr(0, end) + L" -nostats -progress pipe:1" + cmd.substr(end);
+}
+
+// One output line. true = it closed a progress block (p holds the latest values); other = the
+// line is ordinary console output, not a progress key.
+static bool FfmpegProgressFeed(const std::string& raw, FfmpegProgress& p, bool& other) {
+    std::string line = raw;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+    const size_t eq = line.find('=');
+    bool isKey = eq != std::string::npos && eq > 0;
+    for (size_t i = 0; isKey && i < eq; ++i) {
+        const char c = line[i];
+        isKey = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
+    }
+    other = !isKey;
+    if (!isKey) return false;
+
+    const std::string key = line.substr(0, eq), val = line.substr(eq + 1);
+    if (key == "out_time_us" || key == "out_time_ms") {   // both are microseconds
+        const long long us = strtoll(val.c_str(), NULL, 10);
+        if (val != "N/A" && us >= 0) p.outTimeMs = us / 1000;
+    }
+    else if (key == "fps") p.fps = atof(val.c_str());
+    else if (key == "speed") p.speed = atof(val.c_str());   // "3.1x"; "N/A" -> 0
+    else if (key == "bitrate") p.bitrate = val;
+    else if (key == "progress") {
+        p.ended = (val == "end");
+        return true;
+    }
+    return false;
+}
+
+// "42%  3:10 / 7:30  120 fps  3.10x  2510.3kbits/s  ETA 1:24"; percent and ETA need durationMs.
+static std::wstring FfmpegProgressText(const FfmpegProgress& p, int64_t durationMs) {
+    std::wstring t;
+    wchar_t b[64];
+    const int64_t at = (durationMs > 0 && p.outTimeMs > durationMs) ? durationMs : p.outTimeMs;
+    if (durationMs > 0 && at >= 0) {
+        swprintf_s(b, L"%d%%  ", (int)(at * 100 / durationMs));
+        t += b + FormatHMSms(at) + L" / " + FormatHMSms(durationMs);
+    }
+    else if (at >= 0) t += FormatHMSms(at);
+    if (p.fps > 0.0) { swprintf_s(b, L"  %.0f fps", p.fps); t += b; }
+    if (p.speed > 0.0) { swprintf_s(b, L"  %.2fx", p.speed); t += b; }
+    if (!p.bitrate.empty() && p.bitrate != "N/A") t += L"  " + FromUtf8(p.bitrate);
+    if (durationMs > 0 && at >= 0 && p.speed > 0.0 && !p.ended)
+        t += L"  ETA " + FormatHMSms((LONGLONG)((double)(durationMs - at) / p.speed));
+    return t;
+}
+
+// Runs an ffmpeg command line with the progress options added. stdout and stderr share one pipe:
+// progress blocks go to onProgress, other console lines to onLine (either may be empty).
+// hStdin (NULL = none; inheritable only for the spawn) becomes ffmpeg's stdin; *hProcess is set
+// while it runs. Returns the exit code, or (DWORD)-1 if ffmpeg could not be started.
+static DWORD RunFfmpegProgress(const std::wstring& cmd, HANDLE hStdin, HANDLE* hProcess,
+    const std::function<void(const FfmpegProgress&)>& onProgress,
+    const std::function<void(const std::string&)>& onLine)
+{
+    HANDLE hRead = NULL, hWrite = NULL;
+    if (!CreatePipe(&hRead, &hWrite, NULL, 0)) return (DWORD)-1;
+
+    STARTUPINFOW si{};
+    si.cb = sizeof(si);
+    si.dwFlags |= STARTF_USESTDHANDLES;
+    si.hStdInput = hStdin;
+    si.hStdOutput = hWrite;
+    si.hStdError = hWrite;
+
+    const std::wstring full = FfmpegWithProgressArgs(cmd);
+    std::vector<wchar_t> cmdBuf(full.size() + 1);
+    wcscpy_s(cmdBuf.data(), cmdBuf.size(), full.c_str());
+
+    PROCESS_INFORMATION pi{};
+    EnterCriticalSection(&g_spawnLock);
+    SetHandleInformation(hWrite, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+    if (hStdin) SetHandleInformation(hStdin, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+    BOOL ok = CreateProcessW(NULL, cmdBuf.data(), NULL, NULL, TRUE,
+        CREATE_NO_WINDOW | (g_jobChildren ? CREATE_SUSPENDED : 0), NULL, NULL, &si, &pi);
+    CloseHandle(hWrite);
+    if (hStdin) SetHandleInformation(hStdin, HANDLE_FLAG_INHERIT, 0);
+    LeaveCriticalSection(&g_spawnLock);
+    if (!ok) {
+        CloseHandle(hRead);
+        return (DWORD)-1;
+    }
+    if (g_jobChildren) {
+        if (!AssignProcessToJobObject(g_jobChildren, pi.hProcess)) TerminateProcess(pi.hProcess, ERROR_CANCELLED);
+        ResumeThread(pi.hThread);
+    }
+    CloseHandle(pi.hThread);
+    if (hProcess) *hProcess = pi.hProcess;
+
+    FfmpegProgress prog;
+    char buf[4096];
+    DWORD bytes = 0;
+    std::string accum;
+    while (ReadFile(hRead, buf, sizeof(buf), &bytes, NULL) && bytes > 0) {
+        accum.append(buf, buf + bytes);
+        size_t pos = 0, nl = 0;
+        while ((nl = accum.find('\n', pos)) != std::string::npos) {
+            const std::string line = accum.substr(pos, nl - pos + 1);
+            pos = nl + 1;
+            bool other = false;
+            if (FfmpegProgressFeed(line, prog, other)) {
+                if (onProgress) onProgress(prog);
+            }
+            else if (other && onLine) onLine(line);
+        }
+        accum.erase(0, pos);
+    }
+    if (!accum.empty() && onLine) onLine(accum);
+    CloseHandle(hRead);
+
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    DWORD exitCode = 0;
+    GetExitCodeProcess(pi.hProcess, &exitCode);
+    if (hProcess) *hProcess = NULL;
+    CloseHandle(pi.hProcess);
+    return exitCode;
+}
+
+// Runs one ffmpeg command line: console output goes to the task's log window, progress to the
+// status bar (percent / ETA against durationMs, the expected output length; 0 = unknown).
+static DWORD RunFfmpegLogged(FfmpegTask* task, const std::wstring& cmd, int64_t durationMs = 0) {
+    PostFfmpegOutput(task, L"Running command:\r\n");
+    PostFfmpegOutput(task, cmd + L"\r\n\r\n");
+
+    ULONGLONG lastLog = GetTickCount64();
+    const DWORD exitCode = RunFfmpegProgress(cmd, NULL, &task->hProcess,
+        [&](const FfmpegProgress& p) {
+            const std::wstring text = FfmpegProgressText(p, durationMs);
+            if (task->statusId) StatusOpUpdate(task->statusId, task->title + L"  " + text);
+            const ULONGLONG now = GetTickCount64();
+            if (p.ended || now - lastLog >= kFfProgressLogMs) {
+                lastLog = now;
+                PostFfmpegOutput(task, L"[progress] " + text + L"\r\n");
+            }
+        },
+        [&](const std::string& line) {
+            int n = MultiByteToWideChar(CP_ACP, 0, line.c_str(), (int)line.size(), NULL, 0);
+            if (n <= 0) return;
+            std::wstring wline(n, L'\0');
+            MultiByteToWideChar(CP_ACP, 0, line.c_str(), (int)line.size(), &wline[0], n);
+            PostFfmpegOutput(task, wline);
+        });
+    if (exitCode == (DWORD)-1) {
+        PostFfmpegOutput(task, L"ERROR: Failed to start ffmpeg.\r\n");
+        return 5;
+    }
+
+    wchar_t doneMsg[128];
+    swprintf_s(doneMsg, L"\r\n[ffmpeg exited with code %lu]\r\n", exitCode);
+    PostFfmpegOutput(task, doneMsg);
+    return exitCode;
+}
+
+static int FfmpegMajorVersion();
+
+static DWORD FfmpegJobRun(FfmpegTask* task) {
+    LogLine(L"FFmpegTask start: src=\"%s\" outputTemp=\"%s\" plan=%s",
+        task->sourceFull.c_str(), task->outputTemp.c_str(), FfmpegPlanText(task).c_str());
+
+    // Paths should already be filled in, but ensure they're non-empty.
+    if (task->sourceFull.empty() || task->outputTemp.empty()) {
+        PostFfmpegOutput(task, L"ERROR: task paths are not initialized.\r\n");
+        task->exitCode = 2;
+        task->running = false;
+        return task->exitCode;
+    }
+    PostFfmpegOutput(task, L"Edit plan: " + FfmpegPlanText(task) + L"\r\n");
+
+    // trim_mode: keyframe index of the source (cache, else built now)
+    std::vector<uint32_t> kf;
+    bool allIntra = false;
+    bool snapped = false;
+    const bool haveKf = g_cfg.trimMode != 0 && (task->keepFromMs > 0 || task->keepToMs >= 0) &&
+        KeyframeIndexGet(task->sourceFull, kf, allIntra) && !allIntra;
+    if (haveKf && g_cfg.trimMode == 1) {
+        // Cut on keyframes: lossless in every container, no edit list or decoder pre-roll needed
+        const int64_t from = task->keepFromMs > 0 ? KeyframeNearest(kf, task->keepFromMs) : 0;
+        const int64_t to = task->keepToMs >= 0 ? KeyframeNearest(kf, task->keepToMs) : -1;
+        if (to < 0 || to > from) {
+            task->keepFromMs = from;
+            task->keepToMs = to;
+            snapped = true;
+            PostFfmpegOutput(task, L"Snapped to keyframes: " + FfmpegPlanText(task) + L"\r\n");
+        }
+    }
+
+    // MP4 / MOV: rebuild the moov for the trims, then mirror the display matrix; the media bytes
+    // are kept as they are. A flip alone goes to a block clone of the file, else (no cloning on
+    // this volume) into the original itself, journaled; a full copy only if neither works.
+    // ffmpeg only as fallback.
+    const bool trims = task->keepFromMs > 0 || task->keepToMs >= 0;
+    if (Mp4TrimSupportedExt(task->sourceFull) && !task->bakeFlip) {
+        PostFfmpegOutput(task, L"Native MP4 edit (moov rewrite, no re-mux)...\r\n");
+        std::wstring why;
+        DWORD nrc = 0;
+        bool inPlace = false;
+        if (trims) nrc = Mp4TrimFile(task->sourceFull, task->outputTemp, task->keepFromMs, task->keepToMs, &task->cancel, why);
+        else {
+            WIN32_FILE_ATTRIBUTE_DATA fa{};
+            ULONGLONG size = 0;
+            if (GetFileAttributesExW(task->sourceFull.c_str(), GetFileExInfoStandard, &fa))
+                size = ((ULONGLONG)fa.nFileSizeHigh << 32) | fa.nFileSizeLow;
+            if (size && CopyTryBlockClone(task->sourceFull, task->outputTemp, size, fa, true)) {
+                CopyApplyAttributes(task->outputTemp, fa);
+            }
+            else if (task->hflip && Mp4ToggleHFlip(task->sourceFull, why, true)) {
+                inPlace = true;
+                PostFfmpegOutput(task, L"No block cloning here: flipped the original in place (flip again to undo).\r\n");
+            }
+            else if (!CopyFileFast(task->sourceFull, task->outputTemp, &task->cancel, nrc)) why = L"copy failed";
+        }
+        if (nrc == 0 && task->hflip && !inPlace && !Mp4ToggleHFlip(task->outputTemp, why)) nrc = ERROR_NOT_SUPPORTED;
+        if (nrc == 0 || nrc == ERROR_CANCELLED) {
+            PostFfmpegOutput(task, nrc ? L"[cancelled]\r\n" : L"[done]\r\n");
+            if (nrc) DeleteFileW(task->outputTemp.c_str());
+            task->exitCode = nrc;
+            if (nrc == 0 && !inPlace) task->finalWorking = task->outputTemp;
+            task->running = false;
+            task->done = true;
+            LogLine(L"FFmpegTask done (native): src=\"%s\" exitCode=%lu", task->sourceFull.c_str(), nrc);
+            return nrc;
+        }
+        DeleteFileW(task->outputTemp.c_str());
+        PostFfmpegOutput(task, L"Native edit not possible (" + why + L"); using ffmpeg.\r\n\r\n");
+        LogLine(L"[MP4 edit] fallback to ffmpeg for \"%s\": %s (err=%lu)", task->sourceFull.c_str(), why.c_str(), nrc);
+    }
+
+    // 1) One ffmpeg command for the whole plan: read the original, write the temp next to it.
+    //    Matroska takes the flip as a display flag (remux only); elsewhere it is baked in.
+    auto secs = [](int64_t ms) {
+        wchar_t b[64];
+        swprintf_s(b, L"%.3f", (double)ms / 1000.0);
+        return std::wstring(b);
+        };
+    // -display_hflip is an ffmpeg 7 option; older builds reject it, so they bake the flip in
+    bool flipFlag = task->hflip && !task->bakeFlip && MkvSupportedExt(task->sourceFull);
+    if (flipFlag && FfmpegMajorVersion() < 7) {
+        flipFlag = false;
+        PostFfmpegOutput(task, L"ffmpeg older than 7 (no -display_hflip): the flip is baked in.\r\n");
+    }
+    const bool flipBake = task->hflip && !flipFlag;
+
+    // Snapped cuts: index times are whole ms (rounded or truncated), so the seek goes 1 ms past the
+    // keyframe (the input seek then lands on it, not on the one before) and the end 1 ms short of it.
+    const int64_t seekFromMs = task->keepFromMs > 0 && snapped ? task->keepFromMs + 1 : task->keepFromMs;
+    const int64_t seekToMs = task->keepToMs >= 0 && snapped ? task->keepToMs - 1 : task->keepToMs;
+    std::wstring cmd = QuoteArg(g_ffmpegExeW) + L" -y ";
+    if (seekFromMs > 0) cmd += L"-ss " + secs(seekFromMs) + L" ";
+    if (flipFlag) cmd += L"-display_hflip ";
+    cmd += L"-i " + QuoteArg(task->sourceFull) + L" ";
+    if (seekToMs >= 0) cmd += L"-t " + secs(seekToMs - seekFromMs) + L" ";
+    if (flipBake) cmd += L"-vf hflip -c:a copy ";
+    else if (flipFlag) cmd += L"-map 0 -c copy ";
+    else cmd += L"-c copy ";
+    cmd += QuoteArg(task->outputTemp);
+
+    // Expected output length for the progress percent / ETA (0 = not in the metadata cache)
+    const int64_t endMs = task->keepToMs >= 0 ? task->keepToMs : MetaCacheDurationMs(task->sourceFull);
+    const DWORD exitCode = RunFfmpegLogged(task, cmd, endMs > task->keepFromMs ? endMs - task->keepFromMs : 0);
+    task->exitCode = exitCode;
+
+    // On success the temp is the result (published at finalize); otherwise drop the partial output
+    if (exitCode == 0) task->finalWorking = task->outputTemp;
+    else DeleteFileW(task->outputTemp.c_str());
+
+    task->running = false;
+    task->done = true;
+    LogLine(L"FFmpegTask done: src=\"%s\" exitCode=%lu finalWorking=\"%s\"",
+        task->sourceFull.c_str(), exitCode, task->finalWorking.c_str());
+    return exitCode;
+}
+
+static DWORD WINAPI FfmpegJobProc(LPVOID param) {
+    FfmpegTask* task = (FfmpegTask*)param;
+    if (!task) return 0;
+    task->statusId = StatusOpBegin(task->title);
+    const DWORD rc = FfmpegJobRun(task);
+    StatusOpEnd(task->statusId);
+    task->statusId = 0;
+    return rc;
+}
+
+// Closes the open edit plans (all of them, or all but the file still playing) and hands them
+// to the job scheduler. A plan whose edits cancel out is dropped without running anything.
+static void SubmitFfmpegPlans(const std::wstring* stillPlaying) {
+    std::vector<FfmpegTask*> ready;
+    EnterCriticalSection(&g_ffLock);
+    for (FfmpegTask* t : g_ffTasks) {
+        if (!t || t->submitted) continue;
+        if (stillPlaying && _wcsicmp(t->sourceFull.c_str(), stillPlaying->c_str()) == 0) continue;
+        t->submitted = true;
+        ready.push_back(t);
+    }
+    LeaveCriticalSection(&g_ffLock);
+
+    for (FfmpegTask* task : ready) {
+        if (!FfmpegPlanHasEdits(task)) {
+            PostFfmpegOutput(task, L"Nothing to do (the edits cancel out).\r\n");
+            EnterCriticalSection(&g_ffLock);
+            task->done = true;
+            task->exitCode = ERROR_CANCELLED;
+            LeaveCriticalSection(&g_ffLock);
+            continue;
+        }
+
+        // A later visit's plan for the same file waits for the earlier one (one read at a time)
+        std::vector<uint64_t> deps;
+        EnterCriticalSection(&g_ffLock);
+        for (FfmpegTask* t : g_ffTasks) {
+            if (t && t != task && t->running && t->jobId && _wcsicmp(t->sourceFull.c_str(), task->sourceFull.c_str()) == 0)
+                deps.push_back(t->jobId);
+        }
+        task->running = true;
+        LeaveCriticalSection(&g_ffLock);
+
+        LogLine(L"FFmpegTask submit: src=\"%s\" plan=%s", task->sourceFull.c_str(), FfmpegPlanText(task).c_str());
+        const uint64_t jobId = JobSubmit(JobKind::Ffmpeg, JobPriority::Normal, FfmpegJobProc, task, &task->cancel,
+            true, deps);
+        EnterCriticalSection(&g_ffLock);
+        task->jobId = jobId;
+        if (!jobId) {
+            task->running = false;
+            task->done = true;
+            task->exitCode = 3;
+        }
+        LeaveCriticalSection(&g_ffLock);
+        if (!jobId) PostFfmpegOutput(task, L"ERROR: Failed to start background job.\r\n");
+        else if (!deps.empty()) PostFfmpegOutput(task, L"Waiting for the previous edit of this file...\r\n");
+    }
+}
+
+// ----------------------------- Helpers
+static inline bool IsDriveRoot(const std::wstring& p) {
+    return p.size() == 3 &&
+        ((p[0] >= L'A' && p[0] <= L'Z') || (p[0] >= L'a' && p[0] <= L'z')) &&
+        p[1] == L':' && (p[2] == L'\\' || p[2] == L'/');
+}
+static inline std::wstring EnsureSlash(std::wstring p) {
+    if (!p.empty() && p.back() != L'\\' && p.back() != L'/') p.push_back(L'\\');
+    return p;
 }
 static void CollectSelection(std::vector<std::wstring>& outFolders, std::vector<std::wstring>& outFiles) {
     outFolders.clear(); outFiles.clear();
@@ -1344,16 +3644,31 @@ static std::string ToUtf8(const std::wstring& ws) {
     WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), (int)ws.size(), &s[0], n, NULL, NULL);
     return s;
 }
+static std::wstring FromUtf8(const std::string& s) {
+    if (s.empty()) return std::wstring();
+    int n = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), NULL, 0);
+    std::wstring ws(n, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), &ws[0], n);
+    return ws;
+}
 static std::wstring ExtLower(const std::wstring& p) {
     size_t dot = p.find_last_of(L'.'); if (dot == std::wstring::npos) return L"";
     std::wstring e = p.substr(dot); std::transform(e.begin(), e.end(), e.begin(), ::towlower); return e;
 }
+// An edit's ffmpeg output while it is being written (base.metmp-<pid>-<n>-<op>.ext, beside the source)
+static bool IsFfmpegTempName(const std::wstring& path) {
+    const size_t slash = path.find_last_of(L"\\/");
+    std::wstring name = ToLower(slash == std::wstring::npos ? path : path.substr(slash + 1));
+    return name.find(L".metmp-") != std::wstring::npos;
+}
+
+// Edit temps are not videos to list, search, scan or total: they are half-written.
 static bool IsVideoFile(const std::wstring& path) {
     static const wchar_t* exts[] = {
         L".mp4", L".mkv", L".mov", L".avi", L".wmv", L".m4v", L".ts", L".m2ts", L".webm", L".flv", L".rm",
     };
     std::wstring e = ExtLower(path);
-    for (size_t i = 0; i < _countof(exts); ++i) if (e == exts[i]) return true;
+    for (size_t i = 0; i < _countof(exts); ++i) if (e == exts[i]) return !IsFfmpegTempName(path);
     return false;
 }
 
@@ -1423,7 +3738,9 @@ static void SetTitlePlaying() {
     SetWindowTextW(g_hwndMain, t.c_str());
 }
 static std::wstring JoinTermsForTitle() {
-    if (!g_search.active || g_search.termsLower.empty()) return L"";
+    if (!g_search.active) return L"";
+    if (!g_search.groupLabel.empty()) return g_search.groupLabel;
+    if (g_search.termsLower.empty()) return L"";
     std::wstring s = L"\""; s += g_search.termsLower[0]; s += L"\"";
     for (size_t i = 1; i < g_search.termsLower.size(); ++i) {
         s += L" & \""; s += g_search.termsLower[i]; s += L"\"";
@@ -1444,7 +3761,10 @@ static void SetTitleFolderOrDrives() {
 static bool RunFfprobeCommand(const std::wstring& cmdLine, std::vector<std::string>& outLines) {
     outLines.clear();
 
+    // _wpopen makes an inheritable pipe end and spawns cmd.exe with inheritance on
+    EnterCriticalSection(&g_spawnLock);
     FILE* f = _wpopen(cmdLine.c_str(), L"rt");
+    LeaveCriticalSection(&g_spawnLock);
     if (!f) return false;
 
     char buf[512];
@@ -1537,37 +3857,948 @@ static bool GetMediaInfoFromFfprobe(const std::wstring& path,
         gotV = (wTmp > 0 || hTmp > 0 || !codecV.empty());
     }
 
-    // ---------------- Audio stream: codec_name ----------------
-    //
-    // Example line:
-    //   codec_name=aac
-    //
-    std::wstring cmdA = QuoteArg(g_ffprobeExeW) + L" -v error "
-        L"-select_streams a:0 "
-        L"-show_entries stream=codec_name "
-        L"-of default=noprint_wrappers=1 \"";
-    cmdA += path;
-    cmdA += L"\"";
+    // ---------------- Audio stream: codec_name ----------------
+    //
+    // Example line:
+    //   codec_name=aac
+    //
+    std::wstring cmdA = QuoteArg(g_ffprobeExeW) + L" -v error "
+        L"-select_streams a:0 "
+        L"-show_entries stream=codec_name "
+        L"-of default=noprint_wrappers=1 \"";
+    cmdA += path;
+    cmdA += L"\"";
+
+    std::vector<std::string> linesA;
+    if (RunFfprobeCommand(cmdA, linesA)) {
+        std::string codecA;
+        for (const auto& line : linesA) {
+            if (line.empty()) continue;
+            const char* kCodec = "codec_name=";
+            const size_t codecLen = sizeof("codec_name=") - 1;
+            if (line.size() >= codecLen && line.compare(0, codecLen, kCodec) == 0) {
+                codecA = line.substr(codecLen);
+                break;
+            }
+        }
+        if (!codecA.empty()) {
+            outAudioCodec.assign(codecA.begin(), codecA.end());
+            gotA = true;
+        }
+    }
+
+    return gotV || gotA;
+}
+
+// Hidden process with stdout captured as raw bytes (no console flash per file; the _wpopen
+// path above spawns cmd.exe, which is fine for the interactive Ctrl+P but not for a worker).
+// hJob: the process is put in this job object before it runs (so the owner can kill it);
+// by default that is g_jobChildren, killed at shutdown.
+static bool RunHiddenCaptureStdout(const std::wstring& cmdLine, std::string& out, HANDLE hJob = NULL) {
+    out.clear();
+    if (!hJob) hJob = g_jobChildren;
+
+    HANDLE hRead = NULL, hWrite = NULL;
+    if (!CreatePipe(&hRead, &hWrite, NULL, 0)) return false;
+
+    STARTUPINFOW si{};
+    si.cb = sizeof(si);
+    si.dwFlags |= STARTF_USESTDHANDLES;
+    si.hStdOutput = hWrite;
+
+    PROCESS_INFORMATION pi{};
+    std::vector<wchar_t> cmdBuf(cmdLine.begin(), cmdLine.end());
+    cmdBuf.push_back(L'\0');
+
+    EnterCriticalSection(&g_spawnLock);
+    SetHandleInformation(hWrite, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+    BOOL ok = CreateProcessW(NULL, cmdBuf.data(), NULL, NULL, TRUE,
+        CREATE_NO_WINDOW | BELOW_NORMAL_PRIORITY_CLASS | (hJob ? CREATE_SUSPENDED : 0), NULL, NULL, &si, &pi);
+    CloseHandle(hWrite);
+    LeaveCriticalSection(&g_spawnLock);
+    if (!ok) { CloseHandle(hRead); return false; }
+    if (hJob) {
+        if (!AssignProcessToJobObject(hJob, pi.hProcess)) TerminateProcess(pi.hProcess, ERROR_CANCELLED);
+        ResumeThread(pi.hThread);
+    }
+    CloseHandle(pi.hThread);
+
+    char buf[4096];
+    DWORD bytes = 0;
+    while (ReadFile(hRead, buf, sizeof(buf), &bytes, NULL) && bytes > 0) {
+        out.append(buf, buf + bytes);
+    }
+    CloseHandle(hRead);
+
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    DWORD rc = 1;
+    GetExitCodeProcess(pi.hProcess, &rc);
+    CloseHandle(pi.hProcess);
+    return rc == 0;
+}
+
+// "ffmpeg version 7.1..." -> 7; git builds ("N-1234-g...") count as new; 0 = unknown. Run once.
+static int FfmpegMajorVersion() {
+    static std::atomic<int> s_major{ -1 };
+    int v = s_major.load();
+    if (v >= 0) return v;
+    std::string out;
+    RunHiddenCaptureStdout(QuoteArg(g_ffmpegExeW) + L" -hide_banner -version", out);
+    v = 0;
+    const size_t at = out.find("ffmpeg version ");
+    if (at != std::string::npos) {
+        const char* p = out.c_str() + at + 15;
+        if (*p == 'n') ++p; // release tags: "n7.1"
+        if (*p >= '0' && *p <= '9') v = std::atoi(p);
+        else if (*p == 'N') v = 99;
+    }
+    s_major.store(v);
+    LogLine(L"[FFmpeg] major version %d", v);
+    return v;
+}
+
+static bool RunFfprobeHidden(const std::wstring& cmdLine, std::vector<std::string>& outLines) {
+    outLines.clear();
+    std::string accum;
+    bool ok = RunHiddenCaptureStdout(cmdLine, accum);
+
+    size_t pos = 0;
+    while (pos < accum.size()) {
+        size_t nl = accum.find('\n', pos);
+        if (nl == std::string::npos) nl = accum.size();
+        std::string line = accum.substr(pos, nl - pos);
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.pop_back();
+        if (!line.empty()) outLines.push_back(line);
+        pos = nl + 1;
+    }
+    return ok;
+}
+
+// Extended props in ONE ffprobe per file: container + overall bitrate/duration from the
+// format section, codec/size/fps from the first video stream, codec/channels from the first audio.
+// compact=p=0 prints one line per section: "key=val|key=val|..."
+static bool ProbeExtendedMeta(const std::wstring& path, MetaCacheEntry& e) {
+    std::wstring cmd = QuoteArg(g_ffprobeExeW) + L" -v error "
+        L"-show_entries format=format_name,duration,bit_rate"
+        L":stream=codec_type,codec_name,width,height,avg_frame_rate,channels,bit_rate "
+        L"-of compact=p=0 \"";
+    cmd += path;
+    cmd += L"\"";
+
+    std::vector<std::string> lines;
+    if (!RunFfprobeHidden(cmd, lines)) return false;
+
+    bool gotVideo = false, gotAudio = false;
+    ULONGLONG videoBitrate = 0;
+    for (const auto& line : lines) {
+        std::unordered_map<std::string, std::string> kv;
+        size_t pos = 0;
+        while (pos <= line.size()) {
+            size_t bar = line.find('|', pos);
+            if (bar == std::string::npos) bar = line.size();
+            std::string field = line.substr(pos, bar - pos);
+            size_t eq = field.find('=');
+            if (eq != std::string::npos) kv[field.substr(0, eq)] = field.substr(eq + 1);
+            pos = bar + 1;
+        }
+
+        auto num = [&](const char* k) -> ULONGLONG {
+            auto it = kv.find(k);
+            return (it == kv.end()) ? 0 : std::strtoull(it->second.c_str(), nullptr, 10);
+        };
+
+        auto ct = kv.find("codec_type");
+        if (ct == kv.end()) {
+            auto fn = kv.find("format_name");
+            if (fn == kv.end()) continue;
+            // "mov,mp4,m4a,3gp,3g2,mj2" -> prefer the entry matching the extension, else the first
+            std::wstring names = FromUtf8(fn->second);
+            std::wstring ext = ExtLower(path);
+            if (!ext.empty()) ext.erase(0, 1);
+            std::wstring first, match;
+            size_t p0 = 0;
+            while (p0 <= names.size()) {
+                size_t c = names.find(L',', p0);
+                if (c == std::wstring::npos) c = names.size();
+                std::wstring n = names.substr(p0, c - p0);
+                if (first.empty()) first = n;
+                if (!ext.empty() && n == ext) match = n;
+                p0 = c + 1;
+            }
+            e.container = match.empty() ? first : match;
+            e.bitrate = num("bit_rate");
+            if (e.dur == 0) {
+                auto d = kv.find("duration");
+                if (d != kv.end()) e.dur = (ULONGLONG)(std::strtod(d->second.c_str(), nullptr) * 10000000.0);
+            }
+        }
+        else if (ct->second == "video" && !gotVideo) {
+            gotVideo = true;
+            e.vCodec = FromUtf8(kv["codec_name"]);
+            if (e.w <= 0 || e.h <= 0) { e.w = (int)num("width"); e.h = (int)num("height"); }
+            // avg_frame_rate is a ratio like 30000/1001
+            const std::string& fr = kv["avg_frame_rate"];
+            size_t slash = fr.find('/');
+            ULONGLONG n = std::strtoull(fr.c_str(), nullptr, 10);
+            ULONGLONG d = (slash == std::string::npos) ? 1 : std::strtoull(fr.c_str() + slash + 1, nullptr, 10);
+            if (n > 0 && d > 0) e.fpsMilli = (int)((n * 1000ULL + d / 2) / d);
+            videoBitrate = num("bit_rate");
+        }
+        else if (ct->second == "audio" && !gotAudio) {
+            gotAudio = true;
+            e.aCodec = FromUtf8(kv["codec_name"]);
+            e.aChannels = (int)num("channels");
+        }
+    }
+    if (e.bitrate == 0) e.bitrate = videoBitrate; // some containers only report per-stream
+    e.extProbed = true;
+    return gotVideo || gotAudio;
+}
+
+// ----------------------------- Metadata cache helpers (NEW)
+
+static inline ULONGLONG FileTimeToU64(const FILETIME& ft) {
+    return ((ULONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+static bool MetaCacheLookup(const std::wstring& path, ULONGLONG size, ULONGLONG mtime, MetaCacheEntry& out) {
+    bool hit = false;
+    EnterCriticalSection(&g_metaCacheLock);
+    auto it = g_metaCache.find(ToLower(path));
+    if (it != g_metaCache.end() && it->second.size == size && it->second.mtime == mtime) {
+        out = it->second;
+        hit = true;
+    }
+    LeaveCriticalSection(&g_metaCacheLock);
+    return hit;
+}
+
+static void MetaCacheStore(const std::wstring& path, const MetaCacheEntry& e) {
+    EnterCriticalSection(&g_metaCacheLock);
+    MetaCacheEntry& slot = g_metaCache[ToLower(path)];
+    // Different workers fill different fields; keep what the other one found for the same file version.
+    const bool sameFile = (slot.size == e.size && slot.mtime == e.mtime);
+    MetaCacheEntry old;
+    if (sameFile) old = std::move(slot);
+    slot = e;
+    if (slot.thumbKey == 0) slot.thumbKey = old.thumbKey;
+    if (slot.fingerprint.empty()) slot.fingerprint.swap(old.fingerprint);
+    if (slot.partialHash.empty()) slot.partialHash.swap(old.partialHash);
+    if (slot.fullHash.empty()) slot.fullHash.swap(old.fullHash);
+    if (slot.streamSig.empty()) slot.streamSig.swap(old.streamSig);
+    if (!slot.mirrorRead) {
+        slot.mirrorRead = old.mirrorRead;
+        slot.mirrored = old.mirrored;
+    }
+    if (!slot.kfIndexed) {
+        slot.kfIndexed = old.kfIndexed;
+        slot.kfAllIntra = old.kfAllIntra;
+        slot.keyframes.swap(old.keyframes);
+    }
+    g_metaCacheDirty = true;
+    LeaveCriticalSection(&g_metaCacheLock);
+}
+
+static void CopyExtendedToRow(const MetaCacheEntry& e, Row& r) {
+    r.extProbed = e.extProbed;
+    r.vCodec = e.vCodec;
+    r.aCodec = e.aCodec;
+    r.container = e.container;
+    r.bitrate = e.bitrate;
+    r.fpsMilli = e.fpsMilli;
+    r.aChannels = e.aChannels;
+}
+
+// Fill a freshly enumerated row (size + modified already set) from the cache.
+// Returns true on a hit that carried resolution/duration.
+static bool MetaCacheFillRow(Row& r) {
+    MetaCacheEntry e;
+    if (!MetaCacheLookup(r.full, r.size, FileTimeToU64(r.modified), e)) return false;
+    CopyExtendedToRow(e, r);
+    if (e.w <= 0 && e.h <= 0 && e.dur == 0) return false;
+    r.vW = e.w; r.vH = e.h; r.vDur100ns = e.dur;
+    return true;
+}
+
+static bool SearchWantsExtended();
+
+// Row still needs a visit from the metadata worker
+static bool RowNeedsMeta(const Row& r) {
+    if (r.isDir) return false;
+    if (r.vW == 0 && r.vH == 0 && r.vDur100ns == 0) return true;
+    return (g_cfg.extendedColumns || g_metaWantExt.load(std::memory_order_relaxed)) && !r.extProbed;
+}
+
+static std::wstring MetaCacheFilePath() {
+    if (!g_cfg.metaCachePath.empty()) return g_cfg.metaCachePath;
+    wchar_t exePath[MAX_PATH] = {};
+    if (!GetModuleFileNameW(NULL, exePath, MAX_PATH)) return L"";
+    PathRemoveFileSpecW(exePath);
+    return std::wstring(exePath) + L"\\mediaexplorer.metacache";
+}
+
+// File format (UTF-8, one entry per line, tab separated):
+//   MEMC1
+//   <path>\t<size>\t<mtime>\tkey=value\tkey=value...
+// Unknown keys are ignored so newer fields can be appended without a version bump.
+static void MetaCacheLoad() {
+    std::wstring file = MetaCacheFilePath();
+    if (file.empty()) return;
+    FILE* f = _wfopen(file.c_str(), L"rb");
+    if (!f) return;
+
+    size_t loaded = 0;
+    char buf[4096];
+    bool header = true;
+    EnterCriticalSection(&g_metaCacheLock);
+    while (fgets(buf, sizeof(buf), f)) {
+        std::string line = buf;
+        while (!line.empty() && line.back() != '\n' && fgets(buf, sizeof(buf), f)) line += buf;   // long (kf=) lines
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+        if (header) {
+            header = false;
+            if (line != "MEMC1") break; // unknown format -> start empty
+            continue;
+        }
+
+        std::vector<std::string> parts;
+        size_t pos = 0;
+        while (pos <= line.size()) {
+            size_t tab = line.find('\t', pos);
+            if (tab == std::string::npos) tab = line.size();
+            parts.push_back(line.substr(pos, tab - pos));
+            pos = tab + 1;
+        }
+        if (parts.size() < 3 || parts[0].empty()) continue;
+
+        MetaCacheEntry e;
+        e.size = std::strtoull(parts[1].c_str(), nullptr, 10);
+        e.mtime = std::strtoull(parts[2].c_str(), nullptr, 10);
+        for (size_t i = 3; i < parts.size(); ++i) {
+            size_t eq = parts[i].find('=');
+            if (eq == std::string::npos) continue;
+            std::string k = parts[i].substr(0, eq);
+            std::string v = parts[i].substr(eq + 1);
+            if (k == "w") e.w = std::atoi(v.c_str());
+            else if (k == "h") e.h = std::atoi(v.c_str());
+            else if (k == "dur") e.dur = std::strtoull(v.c_str(), nullptr, 10);
+            else if (k == "x") e.extProbed = (v == "1");
+            else if (k == "vc") e.vCodec = FromUtf8(v);
+            else if (k == "ac") e.aCodec = FromUtf8(v);
+            else if (k == "ct") e.container = FromUtf8(v);
+            else if (k == "br") e.bitrate = std::strtoull(v.c_str(), nullptr, 10);
+            else if (k == "fps") e.fpsMilli = std::atoi(v.c_str());
+            else if (k == "ch") e.aChannels = std::atoi(v.c_str());
+            else if (k == "tk") e.thumbKey = std::strtoull(v.c_str(), nullptr, 16);
+            else if (k == "ph") e.partialHash = v;
+            else if (k == "fh") e.fullHash = v;
+            else if (k == "s2") e.streamSig = v;     // "ss" (no level/time base/extradata) is dropped
+            else if (k == "mi") { e.mirrorRead = true; e.mirrored = (v == "1"); }
+            else if (k == "kf") {
+                // "*" = all intra, else deltas in ms: "0,2002,2002,..."
+                e.kfIndexed = true;
+                e.kfAllIntra = (v == "*");
+                const char* q = v.c_str();
+                uint32_t t = 0;
+                while (!e.kfAllIntra && *q) {
+                    char* endp = nullptr;
+                    t += (uint32_t)std::strtoul(q, &endp, 10);
+                    if (!endp || endp == q) break;
+                    e.keyframes.push_back(t);
+                    q = (*endp == ',') ? endp + 1 : endp;
+                }
+            }
+            else if (k == "fs") { // "fp" (fixed sample points) is an older format and is dropped
+                const char* q = v.c_str();
+                while (*q) {
+                    char* endp = nullptr;
+                    e.fingerprint.push_back(std::strtoull(q, &endp, 16));
+                    if (!endp || endp == q) break;
+                    q = (*endp == ',') ? endp + 1 : endp;
+                }
+            }
+        }
+        g_metaCache[ToLower(FromUtf8(parts[0]))] = e;
+        ++loaded;
+    }
+    g_metaCacheDirty = false;
+    LeaveCriticalSection(&g_metaCacheLock);
+    fclose(f);
+
+    LogLine(L"MetaCache: loaded %zu entries from \"%s\"", loaded, file.c_str());
+}
+
+static void MetaCacheSave() {
+    EnterCriticalSection(&g_metaCacheLock);
+    if (!g_metaCacheDirty) { LeaveCriticalSection(&g_metaCacheLock); return; }
+
+    std::wstring file = MetaCacheFilePath();
+    std::wstring tmp = file + L".tmp";
+    FILE* f = file.empty() ? NULL : _wfopen(tmp.c_str(), L"wb");
+    if (!f) { LeaveCriticalSection(&g_metaCacheLock); return; }
+
+    fputs("MEMC1\n", f);
+    for (const auto& kv : g_metaCache) {
+        const MetaCacheEntry& e = kv.second;
+        std::string line = ToUtf8(kv.first);
+        char num[160];
+        sprintf_s(num, "\t%llu\t%llu\tw=%d\th=%d\tdur=%llu",
+            (unsigned long long)e.size, (unsigned long long)e.mtime, e.w, e.h, (unsigned long long)e.dur);
+        line += num;
+        if (e.extProbed) {
+            line += "\tx=1";
+            line += "\tvc=" + ToUtf8(e.vCodec);
+            line += "\tac=" + ToUtf8(e.aCodec);
+            line += "\tct=" + ToUtf8(e.container);
+            sprintf_s(num, "\tbr=%llu\tfps=%d\tch=%d", (unsigned long long)e.bitrate, e.fpsMilli, e.aChannels);
+            line += num;
+        }
+        if (e.thumbKey) {
+            sprintf_s(num, "\ttk=%016llx", (unsigned long long)e.thumbKey);
+            line += num;
+        }
+        for (size_t i = 0; i < e.fingerprint.size(); ++i) {
+            sprintf_s(num, i == 0 ? "\tfs=%llx" : ",%llx", (unsigned long long)e.fingerprint[i]);
+            line += num;
+        }
+        if (!e.partialHash.empty()) line += "\tph=" + e.partialHash;
+        if (!e.fullHash.empty()) line += "\tfh=" + e.fullHash;
+        if (!e.streamSig.empty()) line += "\ts2=" + e.streamSig;
+        if (e.mirrorRead) line += e.mirrored ? "\tmi=1" : "\tmi=0";
+        if (e.kfIndexed && e.kfAllIntra) line += "\tkf=*";
+        else if (e.kfIndexed) {
+            for (size_t i = 0; i < e.keyframes.size(); ++i) {
+                sprintf_s(num, i == 0 ? "\tkf=%u" : ",%u", e.keyframes[i] - (i ? e.keyframes[i - 1] : 0));
+                line += num;
+            }
+        }
+        line += "\n";
+        fputs(line.c_str(), f);
+    }
+    fclose(f);
+    g_metaCacheDirty = false;
+    LeaveCriticalSection(&g_metaCacheLock);
+
+    MoveFileExW(tmp.c_str(), file.c_str(), MOVEFILE_REPLACE_EXISTING);
+}
+
+// ----------------------------- Keyframe index (NEW)
+// Video keyframe times (ms from the start) read from the container's own index: MP4 stss,
+// Matroska Cues; anything else via one ffprobe packet listing (no decoding). Kept in the
+// metadata cache; seeks land on keyframes and trim_mode = keyframe snaps the cuts.
+constexpr int64_t kSeekSnapMaxMs = 3000;   // a seek never moves further than this to reach a keyframe
+
+static void SortUniqueKeyframes(std::vector<uint32_t>& kf) {
+    std::sort(kf.begin(), kf.end());
+    kf.erase(std::unique(kf.begin(), kf.end()), kf.end());
+}
+
+// MP4 / MOV: sync samples of the first video track, with the edit list applied.
+static bool Mp4Keyframes(const std::wstring& path, std::vector<uint32_t>& kf, bool& allIntra) {
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    ULONGLONG moovAt = 0;
+    std::vector<uint8_t> payload;
+    const bool got = Mp4ReadMoov(h, moovAt, payload);
+    CloseHandle(h);
+
+    Mp4Box moov;
+    moov.type = Mp4Fcc("moov");
+    moov.container = true;
+    if (!got || !Mp4Parse(payload.data(), payload.size(), moov.kids)) return false;
+    Mp4Box* mvhd = Mp4Child(moov, Mp4Fcc("mvhd"));
+    const uint32_t movieTs = mvhd ? Mp4Timescale(*mvhd) : 0;
+
+    for (auto& trak : moov.kids) {
+        if (trak.type != Mp4Fcc("trak")) continue;
+        Mp4Box* mdia = Mp4Child(trak, Mp4Fcc("mdia"));
+        Mp4Box* hdlr = mdia ? Mp4Child(*mdia, Mp4Fcc("hdlr")) : nullptr;
+        if (!hdlr || hdlr->data.size() < 12 || Mp4Rd32(&hdlr->data[8]) != Mp4Fcc("vide")) continue;
+        Mp4Box* mdhd = Mp4Child(*mdia, Mp4Fcc("mdhd"));
+        Mp4Box* minf = Mp4Child(*mdia, Mp4Fcc("minf"));
+        Mp4Box* stbl = minf ? Mp4Child(*minf, Mp4Fcc("stbl")) : nullptr;
+        const uint32_t ts = mdhd ? Mp4Timescale(*mdhd) : 0;
+        Mp4Box* stts = stbl ? Mp4Child(*stbl, Mp4Fcc("stts")) : nullptr;
+        if (!stts || !ts) return false;
+        Mp4Box* stss = Mp4Child(*stbl, Mp4Fcc("stss"));
+        if (!stss) { allIntra = true; return true; }
+        Mp4Box* ctts = Mp4Child(*stbl, Mp4Fcc("ctts"));
+
+        // Leading empty edits delay the track; the first real edit skips media time
+        int64_t delayMs = 0, skip = 0;
+        Mp4Box* edts = Mp4Child(trak, Mp4Fcc("edts"));
+        Mp4Box* elst = edts ? Mp4Child(*edts, Mp4Fcc("elst")) : nullptr;
+        if (elst) {
+            Mp4Reader r(elst->data);
+            const uint8_t v = r.u8();
+            r.pos = 4;
+            for (uint32_t e = 0, ec = r.count(v == 1 ? 20 : 12); r.ok && e < ec; ++e) {
+                const uint64_t seg = v == 1 ? r.u64() : r.u32();
+                const int64_t mt = v == 1 ? (int64_t)r.u64() : (int64_t)(int32_t)r.u32();
+                r.u32();
+                if (mt >= 0) { skip = mt; break; }
+                if (movieTs) delayMs += (int64_t)(seg * 1000 / movieTs);
+            }
+        }
+
+        // Decode times from stts, plus the ctts composition offsets
+        std::vector<int64_t> cts;
+        int64_t t = 0;
+        Mp4Reader rt(stts->data, 4);
+        for (uint32_t e = 0, ec = rt.count(8); rt.ok && e < ec; ++e) {
+            const uint32_t cnt = rt.u32(), d = rt.u32();
+            for (uint32_t i = 0; i < cnt && cts.size() < 8u * 1024 * 1024; ++i, t += d) cts.push_back(t);
+        }
+        if (!rt.ok) return false;
+        if (ctts) {
+            const bool signedOff = !ctts->data.empty() && ctts->data[0] == 1;
+            Mp4Reader rc(ctts->data, 4);
+            size_t i = 0;
+            for (uint32_t e = 0, ec = rc.count(8); rc.ok && e < ec; ++e) {
+                const uint32_t cnt = rc.u32(), off = rc.u32();
+                for (uint32_t k = 0; k < cnt && i < cts.size(); ++k) cts[i++] += signedOff ? (int64_t)(int32_t)off : (int64_t)off;
+            }
+        }
+        Mp4Reader rs(stss->data, 4);
+        for (uint32_t e = 0, ec = rs.count(4); rs.ok && e < ec; ++e) {
+            const uint32_t idx = rs.u32();
+            if (idx < 1 || idx > cts.size()) continue;
+            const int64_t ms = delayMs + (cts[idx - 1] - skip) * 1000 / (int64_t)ts;
+            if (ms >= 0 && ms <= UINT32_MAX) kf.push_back((uint32_t)ms);
+        }
+        SortUniqueKeyframes(kf);
+        return !kf.empty();
+    }
+    return false;
+}
+
+// EBML element header at p[pos]: id (length marker kept) and data size (~0 = unknown size).
+static bool EbmlHeader(const uint8_t* p, size_t n, size_t& pos, uint32_t& id, uint64_t& size) {
+    if (pos >= n || !p[pos]) return false;
+    int len = 1;
+    for (uint8_t b = p[pos]; !(b & 0x80); b <<= 1) ++len;
+    if (len > 4 || n - pos < (size_t)len) return false;
+    id = 0;
+    for (int i = 0; i < len; ++i) id = (id << 8) | p[pos + i];
+    pos += len;
+
+    if (pos >= n || !p[pos]) return false;
+    uint8_t mask = 0x80;
+    for (len = 1; !(p[pos] & mask); mask >>= 1) ++len;
+    if (n - pos < (size_t)len) return false;
+    size = p[pos] & (mask - 1);
+    bool unknown = (size == (uint64_t)(mask - 1));
+    for (int i = 1; i < len; ++i) {
+        size = (size << 8) | p[pos + i];
+        if (p[pos + i] != 0xFF) unknown = false;
+    }
+    pos += len;
+    if (unknown) size = ~0ull;
+    return true;
+}
+
+static uint64_t EbmlUint(const uint8_t* p, size_t size) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < size && i < 8; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+// Calls f(id, data, size) for each child element in p[0, n).
+template <class F>
+static void EbmlForEach(const uint8_t* p, size_t n, F f) {
+    for (size_t pos = 0; pos < n;) {
+        uint32_t id = 0;
+        uint64_t size = 0;
+        if (!EbmlHeader(p, n, pos, id, size) || size > n - pos) return;
+        f(id, p + pos, (size_t)size);
+        pos += (size_t)size;
+    }
+}
+
+// Matroska / WebM: CuePoints of the video track (Cues before the clusters, or found via SeekHead).
+static bool MkvKeyframes(const std::wstring& path, std::vector<uint32_t>& kf) {
+    constexpr uint32_t kEbml = 0x1A45DFA3, kSegment = 0x18538067, kSeekHead = 0x114D9B74, kInfo = 0x1549A966,
+        kTracks = 0x1654AE6B, kCues = 0x1C53BB6B, kCluster = 0x1F43B675;
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER li{};
+    GetFileSizeEx(h, &li);
+    const ULONGLONG fileSize = (ULONGLONG)li.QuadPart;
+
+    auto element = [&](ULONGLONG at, uint32_t& id, uint64_t& size, ULONGLONG& dataAt) {
+        BYTE hb[12] = {};
+        if (at >= fileSize) return false;
+        const DWORD want = (DWORD)(std::min)((ULONGLONG)sizeof(hb), fileSize - at);
+        size_t pos = 0;
+        if (!ReadExactAt(h, at, hb, want) || !EbmlHeader(hb, want, pos, id, size)) return false;
+        dataAt = at + pos;
+        return true;
+        };
+    auto load = [&](ULONGLONG at, uint64_t size, std::vector<uint8_t>& out) {
+        if (size > 64ull * 1024 * 1024 || at + size > fileSize) return false;
+        out.resize((size_t)size);
+        return ReadExactAt(h, at, out.data(), (DWORD)size);
+        };
+
+    uint32_t id = 0;
+    uint64_t size = 0;
+    ULONGLONG dataAt = 0;
+    std::vector<uint8_t> cues, buf;
+    uint64_t scaleNs = 1000000, videoTrack = 0;
+    if (element(0, id, size, dataAt) && id == kEbml && size != ~0ull &&
+        element(dataAt + size, id, size, dataAt) && id == kSegment) {
+        const ULONGLONG segStart = dataAt;
+        const ULONGLONG segEnd = (size == ~0ull) ? fileSize : (std::min)(fileSize, segStart + size);
+        ULONGLONG cuesAt = 0;
+        for (ULONGLONG at = segStart; at < segEnd && element(at, id, size, dataAt) && size != ~0ull; at = dataAt + size) {
+            if (id == kCluster) break;   // Cues after the media come through the SeekHead
+            if (id == kCues) { load(dataAt, size, cues); continue; }
+            if (id != kSeekHead && id != kInfo && id != kTracks) continue;
+            if (!load(dataAt, size, buf)) continue;
+            if (id == kSeekHead) {
+                EbmlForEach(buf.data(), buf.size(), [&](uint32_t sid, const uint8_t* d, size_t n) {
+                    if (sid != 0x4DBB) return;   // Seek
+                    uint64_t target = 0, where = 0;
+                    EbmlForEach(d, n, [&](uint32_t k, const uint8_t* v, size_t vn) {
+                        if (k == 0x53AB) target = EbmlUint(v, vn);        // SeekID
+                        else if (k == 0x53AC) where = EbmlUint(v, vn);    // SeekPosition
+                        });
+                    if (target == kCues && !cuesAt) cuesAt = segStart + where;
+                    });
+            }
+            else if (id == kInfo) {
+                EbmlForEach(buf.data(), buf.size(), [&](uint32_t k, const uint8_t* v, size_t vn) {
+                    if (k == 0x2AD7B1 && EbmlUint(v, vn)) scaleNs = EbmlUint(v, vn);   // TimestampScale
+                    });
+            }
+            else {
+                EbmlForEach(buf.data(), buf.size(), [&](uint32_t k, const uint8_t* d, size_t n) {
+                    if (k != 0xAE || videoTrack) return;   // TrackEntry
+                    uint64_t num = 0, type = 0;
+                    EbmlForEach(d, n, [&](uint32_t f, const uint8_t* v, size_t vn) {
+                        if (f == 0xD7) num = EbmlUint(v, vn);        // TrackNumber
+                        else if (f == 0x83) type = EbmlUint(v, vn);  // TrackType (1 = video)
+                        });
+                    if (type == 1) videoTrack = num;
+                    });
+            }
+        }
+        if (cues.empty() && cuesAt && element(cuesAt, id, size, dataAt) && id == kCues) load(dataAt, size, cues);
+    }
+    CloseHandle(h);
+
+    EbmlForEach(cues.data(), cues.size(), [&](uint32_t k, const uint8_t* d, size_t n) {
+        if (k != 0xBB) return;   // CuePoint
+        uint64_t t = 0;
+        bool video = false;
+        EbmlForEach(d, n, [&](uint32_t f, const uint8_t* v, size_t vn) {
+            if (f == 0xB3) t = EbmlUint(v, vn);   // CueTime
+            else if (f == 0xB7) {                 // CueTrackPositions
+                EbmlForEach(v, vn, [&](uint32_t g, const uint8_t* x, size_t xn) {
+                    if (g == 0xF7 && (!videoTrack || EbmlUint(x, xn) == videoTrack)) video = true;   // CueTrack
+                    });
+            }
+            });
+        const uint64_t ms = t * scaleNs / 1000000;
+        if (video && ms <= UINT32_MAX) kf.push_back((uint32_t)ms);
+        });
+    SortUniqueKeyframes(kf);
+    return !kf.empty();
+}
+
+// Any container: packet list of the first video stream (flags "K" = keyframe), relative to its first pts.
+static bool FfprobeKeyframes(const std::wstring& path, std::vector<uint32_t>& kf) {
+    if (!g_cfg.ffprobeAvailable) return false;
+    std::wstring cmd = QuoteArg(g_ffprobeExeW) + L" -v error -select_streams v:0 "
+        L"-show_entries packet=pts_time,flags -of csv=p=0 " + QuoteArg(path);
+    std::vector<std::string> lines;
+    if (!RunFfprobeHidden(cmd, lines)) return false;
+
+    double first = -1.0;
+    std::vector<double> keys;
+    for (const auto& line : lines) {
+        const size_t comma = line.find(',');
+        if (comma == std::string::npos || line.compare(0, 3, "N/A") == 0) continue;
+        const double t = std::strtod(line.c_str(), nullptr);
+        if (first < 0.0 || t < first) first = t;
+        if (line.find('K', comma) != std::string::npos) keys.push_back(t);
+    }
+    for (double t : keys) kf.push_back((uint32_t)((t - first) * 1000.0 + 0.5));
+    SortUniqueKeyframes(kf);
+    return !kf.empty();
+}
+
+static void MetaCacheSetKeyframes(const std::wstring& path, ULONGLONG size, ULONGLONG mtime,
+    const std::vector<uint32_t>& kf, bool allIntra)
+{
+    EnterCriticalSection(&g_metaCacheLock);
+    MetaCacheEntry& slot = g_metaCache[ToLower(path)];
+    if (slot.size != size || slot.mtime != mtime) {
+        slot = MetaCacheEntry();
+        slot.size = size;
+        slot.mtime = mtime;
+    }
+    slot.kfIndexed = true;
+    slot.kfAllIntra = allIntra;
+    slot.keyframes = kf;
+    g_metaCacheDirty = true;
+    LeaveCriticalSection(&g_metaCacheLock);
+}
+
+static bool FileSizeAndTime(const std::wstring& path, ULONGLONG& size, ULONGLONG& mtime) {
+    WIN32_FILE_ATTRIBUTE_DATA fad{};
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &fad)) return false;
+    size = ((ULONGLONG)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+    mtime = FileTimeToU64(fad.ftLastWriteTime);
+    return true;
+}
+
+// Duration of the file as it is now, from the metadata cache; 0 = not known.
+static int64_t MetaCacheDurationMs(const std::wstring& path) {
+    ULONGLONG size = 0, mtime = 0;
+    MetaCacheEntry e;
+    if (!FileSizeAndTime(path, size, mtime) || !MetaCacheLookup(path, size, mtime, e)) return 0;
+    return (int64_t)(e.dur / 10000ULL);
+}
+
+// Cached index for the file as it is now (size + modified time still match).
+static bool KeyframesCached(const std::wstring& path, std::vector<uint32_t>& kf, bool& allIntra) {
+    ULONGLONG size = 0, mtime = 0;
+    MetaCacheEntry e;
+    if (!FileSizeAndTime(path, size, mtime) || !MetaCacheLookup(path, size, mtime, e) || !e.kfIndexed) return false;
+    kf.swap(e.keyframes);
+    allIntra = e.kfAllIntra;
+    return true;
+}
+
+// Cached index, or build and cache it now (workers only: may run ffprobe over the whole file).
+static bool KeyframeIndexGet(const std::wstring& path, std::vector<uint32_t>& kf, bool& allIntra) {
+    kf.clear();
+    allIntra = false;
+    if (KeyframesCached(path, kf, allIntra)) return true;
+    ULONGLONG size = 0, mtime = 0;
+    if (!FileSizeAndTime(path, size, mtime)) return false;
+
+    bool ok = Mp4TrimSupportedExt(path) && Mp4Keyframes(path, kf, allIntra);
+    if (!ok && MkvSupportedExt(path)) { kf.clear(); ok = MkvKeyframes(path, kf); }
+    if (!ok) { kf.clear(); allIntra = false; ok = FfprobeKeyframes(path, kf); }
+    if (ok) MetaCacheSetKeyframes(path, size, mtime, kf, allIntra);
+    return ok;
+}
+
+// ---- MP4 / MOV mirror flag for playback (reading the moov can be slow: cached, read by a job)
+constexpr UINT WM_APP_MIRROR = WM_APP + 130;   // lParam: new std::wstring (path found mirrored)
+
+static bool Mp4MirroredCached(const std::wstring& path, bool& mirrored) {
+    ULONGLONG size = 0, mtime = 0;
+    MetaCacheEntry e;
+    if (!FileSizeAndTime(path, size, mtime) || !MetaCacheLookup(path, size, mtime, e) || !e.mirrorRead) return false;
+    mirrored = e.mirrored;
+    return true;
+}
+
+static DWORD WINAPI Mp4MirrorJobProc(LPVOID param) {
+    std::wstring* path = (std::wstring*)param;
+    ULONGLONG size = 0, mtime = 0;
+    if (FileSizeAndTime(*path, size, mtime)) {
+        const bool mirrored = Mp4FileMirrored(*path);
+        EnterCriticalSection(&g_metaCacheLock);
+        MetaCacheEntry& slot = g_metaCache[ToLower(*path)];
+        if (slot.size != size || slot.mtime != mtime) {
+            slot = MetaCacheEntry();
+            slot.size = size;
+            slot.mtime = mtime;
+        }
+        slot.mirrorRead = true;
+        slot.mirrored = mirrored;
+        g_metaCacheDirty = true;
+        LeaveCriticalSection(&g_metaCacheLock);
+        if (mirrored && PostMessageW(g_hwndMain, WM_APP_MIRROR, 0, (LPARAM)path)) return 0;
+    }
+    delete path;
+    return 0;
+}
+
+// Playback: read the flag in the background unless the cache has it (false = not known yet).
+static bool Mp4MirroredForPlayback(const std::wstring& path) {
+    bool mirrored = false;
+    if (!Mp4TrimSupportedExt(path) || Mp4MirroredCached(path, mirrored)) return mirrored;
+    std::wstring* param = new std::wstring(path);
+    if (!JobSubmit(JobKind::Meta, JobPriority::High, Mp4MirrorJobProc, param, nullptr, false)) delete param;
+    return false;
+}
+
+CRITICAL_SECTION          g_kfLock;      // protects g_kfPending
+std::vector<std::wstring> g_kfPending;   // lower-cased paths with an index job queued
+
+static DWORD WINAPI KeyframeJobProc(LPVOID param) {
+    std::wstring* path = (std::wstring*)param;
+    std::vector<uint32_t> kf;
+    bool allIntra = false;
+    const bool ok = KeyframeIndexGet(*path, kf, allIntra);
+    LogLine(L"[Keyframes] \"%s\": %s, %zu keyframe(s)", path->c_str(),
+        ok ? (allIntra ? L"all intra" : L"indexed") : L"no index", kf.size());
+
+    EnterCriticalSection(&g_kfLock);
+    auto it = std::find(g_kfPending.begin(), g_kfPending.end(), ToLower(*path));
+    if (it != g_kfPending.end()) g_kfPending.erase(it);
+    LeaveCriticalSection(&g_kfLock);
+    delete path;
+    return 0;
+}
 
-    std::vector<std::string> linesA;
-    if (RunFfprobeCommand(cmdA, linesA)) {
-        std::string codecA;
-        for (const auto& line : linesA) {
-            if (line.empty()) continue;
-            const char* kCodec = "codec_name=";
-            const size_t codecLen = sizeof("codec_name=") - 1;
-            if (line.size() >= codecLen && line.compare(0, codecLen, kCodec) == 0) {
-                codecA = line.substr(codecLen);
-                break;
-            }
-        }
-        if (!codecA.empty()) {
-            outAudioCodec.assign(codecA.begin(), codecA.end());
-            gotA = true;
-        }
+// Playback: index the file in the background unless the cache already has it.
+static void KeyframeIndexRequest(const std::wstring& path) {
+    std::vector<uint32_t> kf;
+    bool allIntra = false;
+    if (KeyframesCached(path, kf, allIntra)) return;
+
+    const std::wstring key = ToLower(path);
+    EnterCriticalSection(&g_kfLock);
+    const bool queued = std::find(g_kfPending.begin(), g_kfPending.end(), key) != g_kfPending.end();
+    if (!queued) g_kfPending.push_back(key);
+    LeaveCriticalSection(&g_kfLock);
+    if (queued) return;
+
+    std::wstring* param = new std::wstring(path);
+    if (!JobSubmit(JobKind::Meta, JobPriority::Low, KeyframeJobProc, param, nullptr, false)) {
+        delete param;
+        EnterCriticalSection(&g_kfLock);
+        g_kfPending.erase(std::find(g_kfPending.begin(), g_kfPending.end(), key));
+        LeaveCriticalSection(&g_kfLock);
+    }
+}
+
+// Last keyframe at or before t / first at or after t (-1 = none).
+static int64_t KeyframeAtOrBefore(const std::vector<uint32_t>& kf, int64_t t) {
+    auto it = std::upper_bound(kf.begin(), kf.end(), (uint32_t)(std::max)(t, (int64_t)0));
+    return (it == kf.begin() || t < 0) ? -1 : (int64_t)*(it - 1);
+}
+
+static int64_t KeyframeAtOrAfter(const std::vector<uint32_t>& kf, int64_t t) {
+    if (t < 0) return kf.empty() ? -1 : (int64_t)kf.front();
+    if (t > (int64_t)UINT32_MAX) return -1;
+    auto it = std::lower_bound(kf.begin(), kf.end(), (uint32_t)t);
+    return it == kf.end() ? -1 : (int64_t)*it;
+}
+
+static int64_t KeyframeNearest(const std::vector<uint32_t>& kf, int64_t t) {
+    const int64_t a = KeyframeAtOrBefore(kf, t), b = KeyframeAtOrAfter(kf, t);
+    if (a < 0) return b < 0 ? t : b;
+    if (b < 0) return a;
+    return (t - a <= b - t) ? a : b;
+}
+
+// Seek target moved onto a nearby keyframe, so decoding starts right there instead of running
+// up from the previous one. A keyed seek keeps its direction (never lands on or behind 'from').
+static libvlc_time_t SnapSeekToKeyframe(const std::wstring& path, libvlc_time_t from, libvlc_time_t target) {
+    std::vector<uint32_t> kf;
+    bool allIntra = false;
+    if (!KeyframesCached(path, kf, allIntra) || allIntra || kf.empty()) return target;
+    int64_t a = KeyframeAtOrBefore(kf, target), b = KeyframeAtOrAfter(kf, target);
+    if (target > from && a <= from) a = -1;
+    if (target < from && b >= from) b = -1;
+    int64_t best = -1;
+    if (a >= 0 && (b < 0 || target - a <= b - target)) best = a;
+    else if (b >= 0) best = b;
+    if (best < 0 || (std::max)(best - target, target - best) > kSeekSnapMaxMs) return target;
+    return (libvlc_time_t)best;
+}
+
+// Stream parameters that must agree for a stream-copy concat, one entry per video/audio stream:
+// "v,h264,High,1920x1080,yuv420p,1:1,30000/1001,41,1/15360,CRC32:...;a,aac,LC,48000,2,1/48000,CRC32:...".
+// Level, time base and a hash of the codec extradata (SPS/PPS, AudioSpecificConfig) are included:
+// parts that agree on everything else but carry different headers do not decode once joined.
+// Cached; "" = could not probe.
+static std::string StreamSignatureOf(const std::wstring& path) {
+    ULONGLONG size = 0, mtime = 0;
+    MetaCacheEntry e;
+    const bool known = FileSizeAndTime(path, size, mtime);
+    if (known && MetaCacheLookup(path, size, mtime, e) && !e.streamSig.empty()) return e.streamSig;
+    if (!known || !g_cfg.ffprobeAvailable) return "";
+
+    std::wstring cmd = QuoteArg(g_ffprobeExeW) + L" -v error -show_entries "
+        L"stream=codec_type,codec_name,profile,level,width,height,pix_fmt,sample_aspect_ratio,r_frame_rate,"
+        L"sample_rate,channels,time_base,extradata_hash -show_data_hash CRC32 -of compact=p=0 " + QuoteArg(path);
+    std::vector<std::string> lines;
+    if (!RunFfprobeHidden(cmd, lines)) return "";
+
+    std::string sig;
+    for (const auto& line : lines) {
+        std::unordered_map<std::string, std::string> kv;
+        size_t pos = 0;
+        while (pos <= line.size()) {
+            size_t bar = line.find('|', pos);
+            if (bar == std::string::npos) bar = line.size();
+            std::string field = line.substr(pos, bar - pos);
+            size_t eq = field.find('=');
+            if (eq != std::string::npos) kv[field.substr(0, eq)] = field.substr(eq + 1);
+            pos = bar + 1;
+        }
+        const std::string& type = kv["codec_type"];
+        std::string one;
+        if (type == "video") {
+            one = "v," + kv["codec_name"] + "," + kv["profile"] + "," + kv["width"] + "x" + kv["height"] + "," +
+                kv["pix_fmt"] + "," + kv["sample_aspect_ratio"] + "," + kv["r_frame_rate"] + "," + kv["level"] + "," +
+                kv["time_base"] + "," + kv["extradata_hash"];
+        }
+        else if (type == "audio") {
+            one = "a," + kv["codec_name"] + "," + kv["profile"] + "," + kv["sample_rate"] + "," + kv["channels"] + "," +
+                kv["time_base"] + "," + kv["extradata_hash"];
+        }
+        else continue;
+        sig += (sig.empty() ? "" : ";") + one;
+    }
+    if (sig.empty()) return "";
+
+    EnterCriticalSection(&g_metaCacheLock);
+    MetaCacheEntry& slot = g_metaCache[ToLower(path)];
+    if (slot.size != size || slot.mtime != mtime) {
+        slot = MetaCacheEntry();
+        slot.size = size;
+        slot.mtime = mtime;
+    }
+    slot.streamSig = sig;
+    g_metaCacheDirty = true;
+    LeaveCriticalSection(&g_metaCacheLock);
+    return sig;
+}
+
+// One "file '...'" line of an ffconcat list (UTF-8; a quote inside the path becomes '\'').
+static std::string FfconcatFileLine(const std::wstring& path) {
+    std::string out = "file '";
+    for (char c : ToUtf8(path)) {
+        if (c == '\'') out += "'\\''";
+        else out += c;
+    }
+    return out + "'\n";
+}
+
+// Column text for the extended columns (6..11)
+static std::wstring ExtendedColumnText(const Row& r, int col) {
+    if (r.isDir || !r.extProbed) return L"";
+    wchar_t buf[64];
+    switch (col) {
+    case 6: return r.vCodec;
+    case 7:
+        if (r.bitrate == 0) return L"";
+        swprintf_s(buf, L"%llu kb/s", (unsigned long long)(r.bitrate / 1000ULL));
+        return buf;
+    case 8:
+        if (r.fpsMilli <= 0) return L"";
+        if (r.fpsMilli % 1000 == 0) swprintf_s(buf, L"%d", r.fpsMilli / 1000);
+        else swprintf_s(buf, L"%.2f", r.fpsMilli / 1000.0);
+        return buf;
+    case 9: return r.aCodec;
+    case 10:
+        if (r.aChannels <= 0) return L"";
+        swprintf_s(buf, L"%d", r.aChannels);
+        return buf;
+    case 11: return r.container;
     }
-
-    return gotV || gotA;
+    return L"";
 }
 
 // Show MessageBox with media properties for the currently playing item
@@ -1675,6 +4906,7 @@ static void LoadConfigFromIni() {
     }
 
     std::wstring line;
+    bool trimModeSmart = false;     // retired value, reported once logging is up
     while (std::getline(in, line)) {
         line = Trim(line);
         if (line.empty()) continue;
@@ -1740,6 +4972,55 @@ static void LoadConfigFromIni() {
             g_cfg.ffprobeAvailable =
                 (v == L"1" || v == L"true" || v == L"yes" || v == L"on" || v == L"y");
         }
+        else if (key == L"extendedcolumns") {
+            std::wstring v = ToLower(val);
+            g_cfg.extendedColumns =
+                (v == L"1" || v == L"true" || v == L"yes" || v == L"on" || v == L"y");
+        }
+        else if (key == L"metacache_path" || key == L"metacachepath") {
+            g_cfg.metaCachePath = val;
+        }
+        else if (key == L"thumbnails") {
+            std::wstring v = ToLower(val);
+            g_cfg.thumbnails =
+                (v == L"1" || v == L"true" || v == L"yes" || v == L"on" || v == L"y");
+        }
+        else if (key == L"thumbcache_path" || key == L"thumbcachepath") {
+            g_cfg.thumbCachePath = val;
+        }
+        else if (key == L"thumbnail_workers" || key == L"thumbnailworkers") {
+            g_cfg.thumbWorkers = _wtoi(val.c_str());
+        }
+        else if (key == L"copy_files_in_flight" || key == L"copyfilesinflight") {
+            g_cfg.copyFilesInFlight = _wtoi(val.c_str());
+        }
+        else if (key == L"io_tasks_per_device" || key == L"iotasksperdevice") {
+            g_cfg.ioTasksPerDevice = _wtoi(val.c_str());
+        }
+        else if (key == L"job_workers" || key == L"jobworkers") {
+            g_cfg.jobWorkers = _wtoi(val.c_str());
+        }
+        else if (key == L"trim_mode" || key == L"trimmode") {
+            std::wstring v = ToLower(val);
+            if (v == L"keyframe" || v == L"keyframes" || v == L"snap") g_cfg.trimMode = 1;
+            else if (v == L"smart") { g_cfg.trimMode = 1; trimModeSmart = true; }
+            else g_cfg.trimMode = 0;
+        }
+        else if (key == L"combine_scratch" || key == L"combinescratch") {
+            g_cfg.combineScratch = val;
+        }
+        else if (key == L"copy_verify" || key == L"copyverify") {
+            std::wstring v = ToLower(val);
+            if (v == L"flush") g_cfg.copyVerify = 2;
+            else if (v == L"reread" || v == L"1" || v == L"true" || v == L"yes" || v == L"on" || v == L"y")
+                g_cfg.copyVerify = 1;
+            else g_cfg.copyVerify = 0;
+        }
+        else if (key == L"copy_unbuffered" || key == L"copyunbuffered") {
+            std::wstring v = ToLower(val);
+            g_cfg.copyUnbuffered =
+                (v == L"1" || v == L"true" || v == L"yes" || v == L"on" || v == L"y");
+        }
     }
     // after the while(...) loop
     InitLoggingFromConfig();
@@ -1760,7 +5041,25 @@ static void LoadConfigFromIni() {
             g_cfg.ffmpegPath.c_str(),
             g_cfg.ffprobePath.c_str());
         LogLine(L"Config: vlc_hwaccel=\"%s\"", g_cfg.vlcHwAccel.c_str());
-
+        LogLine(L"Config: extendedColumns=%d metacache_path=\"%s\"",
+            g_cfg.extendedColumns ? 1 : 0, g_cfg.metaCachePath.c_str());
+        LogLine(L"Config: thumbnails=%d thumbcache_path=\"%s\" thumbnail_workers=%d",
+            g_cfg.thumbnails ? 1 : 0, g_cfg.thumbCachePath.c_str(), g_cfg.thumbWorkers);
+        LogLine(L"Config: copy_files_in_flight=%d copy_unbuffered=%d io_tasks_per_device=%d",
+            g_cfg.copyFilesInFlight, g_cfg.copyUnbuffered ? 1 : 0, g_cfg.ioTasksPerDevice);
+        LogLine(L"Config: job_workers=%d copy_verify=%d trim_mode=%d", g_cfg.jobWorkers, g_cfg.copyVerify, g_cfg.trimMode);
+        if (trimModeSmart) LogLine(L"Config: trim_mode=smart is no longer supported; using keyframe");
+        LogLine(L"Config: combine_scratch=\"%s\"", g_cfg.combineScratch.c_str());
+
+    }
+    // Extended columns are filled by ffprobe; without it there is nothing to show.
+    if (g_cfg.extendedColumns && !g_cfg.ffprobeAvailable) {
+        LogLine(L"Config: extendedColumns ignored (ffprobeAvailable=0)");
+        g_cfg.extendedColumns = false;
+    }
+    if (g_cfg.thumbnails && !g_cfg.ffmpegAvailable) {
+        LogLine(L"Config: thumbnails ignored (ffmpegAvailable=0)");
+        g_cfg.thumbnails = false;
     }
     // Derive libVLC hardware-decoding arg from config.
     // Accepts: d3d11va | dxva2 | any | none
@@ -1807,6 +5106,18 @@ static void ShowHelp() {
         L"  ffmpegAvailable  = 0|1  (enable FFmpeg tools: trim / flip)\n"
         L"  ffprobeAvailable = 0|1  (enable ffprobe-based details)\n\n";
     msg += L"  vlc_hwaccel      = d3d11va|dxva2|any|none (default d3d11va; set none to disable HW decode)\n";
+    msg += L"  extendedColumns  = 0|1  (Codec/Bitrate/FPS/Audio/Channels/Container columns; needs ffprobe)\n"
+        L"  metacache_path   = D:\\cache\\mediaexplorer.metacache (optional; default next to the exe)\n"
+        L"  thumbnails       = 0|1  (start with thumbnail column on; needs ffmpeg)\n"
+        L"  thumbcache_path  = D:\\cache\\mediaexplorer.thumbs (optional; default next to the exe)\n"
+        L"  thumbnail_workers = N   (parallel ffmpeg extractions; default half the cores, max 4)\n"
+        L"  copy_files_in_flight = N (files copied at once by paste/Topaz; default 4)\n"
+        L"  copy_unbuffered  = 0|1  (bypass the file cache when copying files >= 256 MB; default 1)\n"
+        L"  copy_verify      = off|reread|flush (SHA-256 while copying, then re-read the copy or trust the flush)\n"
+        L"  io_tasks_per_device = N (bulk file tasks running at once per physical disk/server; default 1)\n"
+        L"  job_workers      = N   (background job threads: file ops, ffmpeg, combine, probing, thumbnails, folder totals; default cores, 4..8)\n"
+        L"  trim_mode        = exact|keyframe (keyframe: snap trims to keyframes; the old 'smart' value means keyframe)\n"
+        L"  combine_scratch  = S:\\scratch (optional; combine intermediates go here, default beside the output)\n\n";
 
 
     msg += L"FILE BROWSER (list)\n"
@@ -1816,9 +5127,18 @@ static void ShowHelp() {
         L"  Ctrl+A               : Select all videos in current view\n"
         L"  Ctrl+P               : Play selected videos\n"
         L"  Ctrl+F               : Search (recursive). In Search view: refine (AND/intersection)\n"
+        L"                         field:value filters metadata, e.g. vcodec:hevc acodec:aac fps:60\n"
+        L"                         ch:6 container:mkv (fields: vcodec acodec container fps ch res)\n"
         L"  Ctrl+Up/Down         : Move selected row up/down (single selection)\n"
         L"  Ctrl+U               : Submit selected videos to Topaz queue (writes .json jobs (no tracking))\n";
 
+    if (g_cfg.ffmpegAvailable) {
+        msg += L"  Ctrl+T               : Toggle thumbnail column (keyframe per video, cached)\n";
+        msg += L"  Ctrl+S               : Find similar videos (selection / folder / drives / search results)\n"
+            L"                         Results are grouped in sets; Ctrl+A selects all but one per set\n";
+    }
+    msg += L"  Ctrl+D               : Find exact duplicate videos (same scope and grouped view as Ctrl+S)\n";
+
     if (g_cfg.ffmpegAvailable) {
         msg += L"  Ctrl+Plus            : Combine selected files into one video (background)\n";
     }
@@ -1855,9 +5175,12 @@ static void ShowHelp() {
         if (g_cfg.ffmpegAvailable) {
             msg += L"                           Trim front to current time (FFmpeg)\n"
                 L"                           Trim end at current time (FFmpeg)\n"
-                L"                           Horizontal flip (FFmpeg)\n";
+                L"                           Horizontal flip (no re-encode: MP4/MOV display matrix, MKV flag)\n"
+                L"                           Horizontal flip baked in (FFmpeg re-encode, for players that ignore the flag)\n";
         }
         msg += L"\n"
+            L"  Edits of one video are collected and run as a single pass\n"
+            L"  once playback moves to another file or ends.\n"
             L"  At end of playback, if FFmpeg tasks are still running,\n"
             L"  the title bar shows \"waiting on N task(s)\" until they all complete.\n";
     }
@@ -1901,7 +5224,33 @@ static void LV_ResetColumns()
     c.pszText = const_cast<wchar_t*>(L"Modified");   c.cx = 240; c.iSubItem = 3; ListView_InsertColumn(g_hwndList, 3, &c);
     c.pszText = const_cast<wchar_t*>(L"Resolution"); c.cx = 140; c.iSubItem = 4; ListView_InsertColumn(g_hwndList, 4, &c);
     c.pszText = const_cast<wchar_t*>(L"Duration");   c.cx = 140; c.iSubItem = 5; ListView_InsertColumn(g_hwndList, 5, &c);
+
+    // NEW: extended columns (ffprobe via metadata worker)
+    if (g_cfg.extendedColumns) {
+        c.pszText = const_cast<wchar_t*>(L"Codec");     c.cx = 90;  c.iSubItem = 6;  ListView_InsertColumn(g_hwndList, 6, &c);
+        c.pszText = const_cast<wchar_t*>(L"Bitrate");   c.cx = 110; c.iSubItem = 7;  ListView_InsertColumn(g_hwndList, 7, &c);
+        c.pszText = const_cast<wchar_t*>(L"FPS");       c.cx = 70;  c.iSubItem = 8;  ListView_InsertColumn(g_hwndList, 8, &c);
+        c.pszText = const_cast<wchar_t*>(L"Audio");     c.cx = 80;  c.iSubItem = 9;  ListView_InsertColumn(g_hwndList, 9, &c);
+        c.pszText = const_cast<wchar_t*>(L"Channels");  c.cx = 80;  c.iSubItem = 10; ListView_InsertColumn(g_hwndList, 10, &c);
+        c.pszText = const_cast<wchar_t*>(L"Container"); c.cx = 90;  c.iSubItem = 11; ListView_InsertColumn(g_hwndList, 11, &c);
+    }
+}
+
+// Columns 6..11 (only present when extendedColumns is on)
+static void LV_SetExtendedCells(int rowIndex, const Row& r) {
+    if (!g_cfg.extendedColumns) return;
+    for (int col = 6; col <= 11; ++col) {
+        std::wstring t = ExtendedColumnText(r, col);
+        ListView_SetItemText(g_hwndList, rowIndex, col, const_cast<wchar_t*>(t.c_str()));
+    }
+}
+// Type column: "Folder" / "Video", plus the recursive video count or the finder set number
+static const wchar_t* RowTypeText(const Row& r, wchar_t (&buf)[32]) {
+    if (r.groupId > 0) { swprintf_s(buf, L"Set %d", r.groupId); return buf; }
+    if (r.isDir && r.aggDone) { swprintf_s(buf, r.aggPartial ? L"Folder (%u+)" : L"Folder (%u)", r.aggVideos); return buf; }
+    return r.isDir ? L"Folder" : L"Video";
 }
+
 static void LV_Add(int rowIndex, const Row& r)
 {
     // Drives view: col0=Remote, col1=Drive
@@ -1924,12 +5273,18 @@ static void LV_Add(int rowIndex, const Row& r)
     LVITEMW it; ZeroMemory(&it, sizeof(it));
     it.mask = LVIF_TEXT | LVIF_PARAM; it.iItem = rowIndex;
     it.pszText = const_cast<wchar_t*>(r.name.c_str()); it.lParam = rowIndex;
+    if (g_thumbsOn) {
+        // NEW: thumbnail column (image arrives later via WM_APP_THUMB unless already loaded)
+        auto th = g_thumbImageOfPath.find(ToLower(r.full));
+        it.mask |= LVIF_IMAGE;
+        it.iImage = (th != g_thumbImageOfPath.end()) ? th->second : I_IMAGENONE;
+    }
     ListView_InsertItem(g_hwndList, &it);
 
-    const wchar_t* type = r.isDir ? L"Folder" : L"Video";
-    ListView_SetItemText(g_hwndList, rowIndex, 1, const_cast<wchar_t*>(type));
+    wchar_t typeBuf[32];
+    ListView_SetItemText(g_hwndList, rowIndex, 1, const_cast<wchar_t*>(RowTypeText(r, typeBuf)));
 
-    if (!r.isDir) {
+    if (!r.isDir || r.aggDone) {
         std::wstring s = FormatSize(r.size);
         ListView_SetItemText(g_hwndList, rowIndex, 2, const_cast<wchar_t*>(s.c_str()));
     }
@@ -1941,10 +5296,11 @@ static void LV_Add(int rowIndex, const Row& r)
         wchar_t buf[64]; swprintf_s(buf, L"%dx%d", r.vW, r.vH);
         ListView_SetItemText(g_hwndList, rowIndex, 4, buf);
     }
-    if (!r.isDir && r.vDur100ns > 0) {
+    if ((!r.isDir || r.aggDone) && r.vDur100ns > 0) {
         std::wstring ds = FormatDuration100ns(r.vDur100ns);
         ListView_SetItemText(g_hwndList, rowIndex, 5, const_cast<wchar_t*>(ds.c_str()));
     }
+    if (!r.isDir && r.extProbed) LV_SetExtendedCells(rowIndex, r);
 }
 static void LV_Rebuild() {
     ListView_DeleteAllItems(g_hwndList);
@@ -1953,20 +5309,25 @@ static void LV_Rebuild() {
 
 // Update an existing ListView row from g_rows[i] without rebuilding the whole list.
 static void LV_UpdateRow(int rowIndex, const Row& r) {
-    // Column 0: Name
+    // Column 0: Name (+ thumbnail)
     LVITEMW it{};
     it.mask = LVIF_TEXT;
     it.iItem = rowIndex;
     it.iSubItem = 0;
     it.pszText = const_cast<wchar_t*>(r.name.c_str());
+    if (g_thumbsOn) {
+        auto th = g_thumbImageOfPath.find(ToLower(r.full));
+        it.mask |= LVIF_IMAGE;
+        it.iImage = (th != g_thumbImageOfPath.end()) ? th->second : I_IMAGENONE;
+    }
     ListView_SetItem(g_hwndList, &it);
 
-    // Column 1: Type
-    const wchar_t* type = r.isDir ? L"Folder" : L"Video";
-    ListView_SetItemText(g_hwndList, rowIndex, 1, const_cast<wchar_t*>(type));
+    // Column 1: Type ("Set N" in grouped views, "Folder (N)" once aggregated, "Folder (N+)" while walking)
+    wchar_t typeBuf[32];
+    ListView_SetItemText(g_hwndList, rowIndex, 1, const_cast<wchar_t*>(RowTypeText(r, typeBuf)));
 
-    // Column 2: Size
-    if (!r.isDir && r.size > 0) {
+    // Column 2: Size (recursive total for aggregated folders)
+    if ((!r.isDir || r.aggDone) && r.size > 0) {
         std::wstring s = FormatSize(r.size);
         ListView_SetItemText(g_hwndList, rowIndex, 2, const_cast<wchar_t*>(s.c_str()));
     }
@@ -1993,52 +5354,78 @@ static void LV_UpdateRow(int rowIndex, const Row& r) {
         ListView_SetItemText(g_hwndList, rowIndex, 4, const_cast<wchar_t*>(L""));
     }
 
-    // Column 5: Duration
-    if (!r.isDir && r.vDur100ns > 0) {
+    // Column 5: Duration (summed for aggregated folders)
+    if ((!r.isDir || r.aggDone) && r.vDur100ns > 0) {
         std::wstring ds = FormatDuration100ns(r.vDur100ns);
         ListView_SetItemText(g_hwndList, rowIndex, 5, const_cast<wchar_t*>(ds.c_str()));
     }
     else {
         ListView_SetItemText(g_hwndList, rowIndex, 5, const_cast<wchar_t*>(L""));
     }
+
+    // Columns 6..11: extended props
+    LV_SetExtendedCells(rowIndex, r);
 }
 
 // ----------------------------- Sorting (dirs first)
+// Shared comparator for SortRows / SortRowsVector
+static bool RowLessForSort(const Row& A, const Row& B, int col, bool asc) {
+    if (A.isDir != B.isDir) return A.isDir && !B.isDir; // dirs first
+    if (A.groupId != B.groupId) return A.groupId < B.groupId; // grouped views keep sets together
+    switch (col) {
+    case 0: return asc ? (_wcsicmp(A.name.c_str(), B.name.c_str()) < 0) : (_wcsicmp(A.name.c_str(), B.name.c_str()) > 0);
+    case 1: {
+        int ta = A.isDir ? 0 : 1, tb = B.isDir ? 0 : 1;
+        if (ta != tb) return ta < tb;
+        return asc ? (_wcsicmp(A.name.c_str(), B.name.c_str()) < 0) : (_wcsicmp(A.name.c_str(), B.name.c_str()) > 0);
+    }
+    case 2:
+        if (A.size != B.size) return asc ? (A.size < B.size) : (A.size > B.size);
+        return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
+    case 3: {
+        ULONGLONG a = ((ULONGLONG)A.modified.dwHighDateTime << 32) | A.modified.dwLowDateTime;
+        ULONGLONG b = ((ULONGLONG)B.modified.dwHighDateTime << 32) | B.modified.dwLowDateTime;
+        if (a != b) return asc ? (a < b) : (a > b);
+        return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
+    }
+    case 4: {
+        ULONGLONG aa = (ULONGLONG)A.vW * (ULONGLONG)A.vH;
+        ULONGLONG bb = (ULONGLONG)B.vW * (ULONGLONG)B.vH;
+        if (aa != bb) return asc ? (aa < bb) : (aa > bb);
+        if (A.vW != B.vW) return asc ? (A.vW < B.vW) : (A.vW > B.vW);
+        return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
+    }
+    case 5:
+        if (A.vDur100ns != B.vDur100ns) return asc ? (A.vDur100ns < B.vDur100ns) : (A.vDur100ns > B.vDur100ns);
+        return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
+    // extended columns: strings compare case-insensitively, unknown values sort first
+    case 6:
+    case 9:
+    case 11: {
+        const std::wstring& a = (col == 6) ? A.vCodec : (col == 9) ? A.aCodec : A.container;
+        const std::wstring& b = (col == 6) ? B.vCodec : (col == 9) ? B.aCodec : B.container;
+        int c = _wcsicmp(a.c_str(), b.c_str());
+        if (c != 0) return asc ? (c < 0) : (c > 0);
+        return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
+    }
+    case 7:
+        if (A.bitrate != B.bitrate) return asc ? (A.bitrate < B.bitrate) : (A.bitrate > B.bitrate);
+        return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
+    case 8:
+        if (A.fpsMilli != B.fpsMilli) return asc ? (A.fpsMilli < B.fpsMilli) : (A.fpsMilli > B.fpsMilli);
+        return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
+    case 10:
+        if (A.aChannels != B.aChannels) return asc ? (A.aChannels < B.aChannels) : (A.aChannels > B.aChannels);
+        return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
+    default:
+        return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
+    }
+}
+
 static void SortRows(int col, bool asc) {
     g_sortCol = col; g_sortAsc = asc;
     std::sort(g_rows.begin(), g_rows.end(),
-        [col, asc](const Row& A, const Row& B) {
-            if (A.isDir != B.isDir) return A.isDir && !B.isDir; // dirs first
-            switch (col) {
-            case 0: return asc ? (_wcsicmp(A.name.c_str(), B.name.c_str()) < 0) : (_wcsicmp(A.name.c_str(), B.name.c_str()) > 0);
-            case 1: {
-                int ta = A.isDir ? 0 : 1, tb = B.isDir ? 0 : 1;
-                if (ta != tb) return ta < tb;
-                return asc ? (_wcsicmp(A.name.c_str(), B.name.c_str()) < 0) : (_wcsicmp(A.name.c_str(), B.name.c_str()) > 0);
-            }
-            case 2:
-                if (A.size != B.size) return asc ? (A.size < B.size) : (A.size > B.size);
-                return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
-            case 3: {
-                ULONGLONG a = ((ULONGLONG)A.modified.dwHighDateTime << 32) | A.modified.dwLowDateTime;
-                ULONGLONG b = ((ULONGLONG)B.modified.dwHighDateTime << 32) | B.modified.dwLowDateTime;
-                if (a != b) return asc ? (a < b) : (a > b);
-                return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
-            }
-            case 4: {
-                ULONGLONG aa = (ULONGLONG)A.vW * (ULONGLONG)A.vH;
-                ULONGLONG bb = (ULONGLONG)B.vW * (ULONGLONG)B.vH;
-                if (aa != bb) return asc ? (aa < bb) : (aa > bb);
-                if (A.vW != B.vW) return asc ? (A.vW < B.vW) : (A.vW > B.vW);
-                return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
-            }
-            case 5:
-                if (A.vDur100ns != B.vDur100ns) return asc ? (A.vDur100ns < B.vDur100ns) : (A.vDur100ns > B.vDur100ns);
-                return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
-            default:
-                return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
-            }
-        });
+        [col, asc](const Row& A, const Row& B) { return RowLessForSort(A, B, col, asc); });
     LV_Rebuild();
 }
 
@@ -2051,38 +5438,7 @@ static void CancelBackgroundFolderReload() {
 
 static void SortRowsVector(std::vector<Row>& rows, int col, bool asc) {
     std::sort(rows.begin(), rows.end(),
-        [col, asc](const Row& A, const Row& B) {
-            if (A.isDir != B.isDir) return A.isDir && !B.isDir; // dirs first
-            switch (col) {
-            case 0: return asc ? (_wcsicmp(A.name.c_str(), B.name.c_str()) < 0) : (_wcsicmp(A.name.c_str(), B.name.c_str()) > 0);
-            case 1: {
-                int ta = A.isDir ? 0 : 1, tb = B.isDir ? 0 : 1;
-                if (ta != tb) return ta < tb;
-                return asc ? (_wcsicmp(A.name.c_str(), B.name.c_str()) < 0) : (_wcsicmp(A.name.c_str(), B.name.c_str()) > 0);
-            }
-            case 2:
-                if (A.size != B.size) return asc ? (A.size < B.size) : (A.size > B.size);
-                return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
-            case 3: {
-                ULONGLONG a = ((ULONGLONG)A.modified.dwHighDateTime << 32) | A.modified.dwLowDateTime;
-                ULONGLONG b = ((ULONGLONG)B.modified.dwHighDateTime << 32) | B.modified.dwLowDateTime;
-                if (a != b) return asc ? (a < b) : (a > b);
-                return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
-            }
-            case 4: {
-                ULONGLONG aa = (ULONGLONG)A.vW * (ULONGLONG)A.vH;
-                ULONGLONG bb = (ULONGLONG)B.vW * (ULONGLONG)B.vH;
-                if (aa != bb) return asc ? (aa < bb) : (aa > bb);
-                if (A.vW != B.vW) return asc ? (A.vW < B.vW) : (A.vW > B.vW);
-                return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
-            }
-            case 5:
-                if (A.vDur100ns != B.vDur100ns) return asc ? (A.vDur100ns < B.vDur100ns) : (A.vDur100ns > B.vDur100ns);
-                return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
-            default:
-                return _wcsicmp(A.name.c_str(), B.name.c_str()) < 0;
-            }
-        });
+        [col, asc](const Row& A, const Row& B) { return RowLessForSort(A, B, col, asc); });
 }
 
 static void BuildFolderRowsForReload(const std::wstring& folder,
@@ -2118,6 +5474,7 @@ static void BuildFolderRowsForReload(const std::wstring& folder,
 
         if (r.isDir) {
             r.full += L'\\';
+            DirAggFillRow(r);
             dirs.push_back(std::move(r));
         }
         else if (IsVideoFile(r.full)) {
@@ -2126,7 +5483,7 @@ static void BuildFolderRowsForReload(const std::wstring& folder,
             uli.LowPart = fd.nFileSizeLow;
             r.size = uli.QuadPart;
 
-            if (!GetVideoPropsFastCached(r.full, r.vW, r.vH, r.vDur100ns)) {
+            if (!MetaCacheFillRow(r) && !GetVideoPropsFastCached(r.full, r.vW, r.vH, r.vDur100ns)) {
                 r.vW = r.vH = 0;
                 r.vDur100ns = 0;
             }
@@ -2193,58 +5550,761 @@ static void StartBackgroundFolderReload(const std::wstring& folder) {
 }
 
 // ----------------------------- Async metadata worker
-static DWORD WINAPI MetaThreadProc(LPVOID) {
+// One job at a time drains g_metaTodoPaths; it stays alive across navigations (each batch is
+// tagged with the gen it was taken under) and exits only when it finds the list empty.
+static DWORD WINAPI MetaJobProc(LPVOID) {
     CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
-    const uint32_t myGen = g_metaGen.load(std::memory_order_relaxed);
 
     for (;;) {
-        std::wstring path;
+        // Take a batch per lock; results for the batch go to the UI in one message
+        std::vector<std::wstring> paths;
         EnterCriticalSection(&g_metaLock);
-        if (!g_metaTodoPaths.empty()) {
-            path = g_metaTodoPaths.back();
+        const uint32_t myGen = g_metaGen.load(std::memory_order_relaxed); // bumped under this lock
+        while (!g_metaTodoPaths.empty() && paths.size() < kMetaBatch) {
+            paths.push_back(g_metaTodoPaths.back());
             g_metaTodoPaths.pop_back();
         }
+        if (paths.empty()) g_metaJobActive = false; // decided under the lock, so a kick never strands work
         LeaveCriticalSection(&g_metaLock);
 
-        if (path.empty()) break;
-        if (myGen != g_metaGen.load(std::memory_order_relaxed)) break;
+        if (paths.empty()) break;
+
+        std::vector<MetaResult>* batch = new std::vector<MetaResult>();
+        batch->reserve(paths.size());
+        for (const auto& path : paths) {
+            if (myGen != g_metaGen.load(std::memory_order_relaxed)) break;
+
+            WIN32_FILE_ATTRIBUTE_DATA fad{};
+            if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &fad)) continue;
+            ULARGE_INTEGER uli{};
+            uli.HighPart = fad.nFileSizeHigh;
+            uli.LowPart = fad.nFileSizeLow;
+
+            MetaCacheEntry e;
+            bool hit = MetaCacheLookup(path, uli.QuadPart, FileTimeToU64(fad.ftLastWriteTime), e);
+            bool changed = false;
+            if (!hit) {
+                e.size = uli.QuadPart;
+                e.mtime = FileTimeToU64(fad.ftLastWriteTime);
+            }
+            // One ffprobe per file covers all extended columns and resolution / duration;
+            // the shell property read is only for files ffprobe is not asked about (or failed on)
+            if ((g_cfg.extendedColumns || g_metaWantExt.load(std::memory_order_relaxed)) && !e.extProbed) {
+                ProbeExtendedMeta(path, e);
+                changed = true;
+            }
+            if (e.w == 0 && e.h == 0 && e.dur == 0) {
+                GetVideoProps(path, e.w, e.h, e.dur); // heavy; OK in worker
+                changed = true;
+            }
+            if (myGen != g_metaGen.load(std::memory_order_relaxed)) break; // navigated away / shutting down
+            if (changed) MetaCacheStore(path, e);
+
+            MetaResult r{ path, e.w, e.h, e.dur, myGen, e.extProbed,
+                e.vCodec, e.aCodec, e.container, e.bitrate, e.fpsMilli, e.aChannels };
+            batch->push_back(std::move(r));
+        }
+        if (batch->empty()) { delete batch; continue; }
+        PostMessageW(g_hwndMain, WM_APP_META, 0, (LPARAM)batch);
+    }
+
+    CoUninitialize();
+    return 0;
+}
+// Caller holds g_metaLock
+static void StartMetaWorkerLocked() {
+    if (g_metaJobActive || g_metaTodoPaths.empty()) return;
+    // High: the rows on screen wait for it, so it must not queue behind combines and finders
+    g_metaJobActive = JobSubmit(JobKind::Meta, JobPriority::High, MetaJobProc, NULL, nullptr, false) != 0;
+}
+static void CancelMetaWorkAndClearTodo() {
+    EnterCriticalSection(&g_metaLock);
+    g_metaGen.fetch_add(1, std::memory_order_relaxed);
+    g_metaTodoPaths.clear();
+    LeaveCriticalSection(&g_metaLock);
+}
+
+// After (re)building g_rows + ListView, queue any videos still missing props:
+static void QueueMissingPropsAndKickWorker() {
+    g_metaWantExt.store(g_cfg.ffprobeAvailable && SearchWantsExtended(), std::memory_order_relaxed);
+    EnterCriticalSection(&g_metaLock);
+    for (const auto& r : g_rows) {
+        if (RowNeedsMeta(r)) {
+            g_metaTodoPaths.push_back(r.full);
+        }
+    }
+    StartMetaWorkerLocked();
+    LeaveCriticalSection(&g_metaLock);
+}
+
+// ----------------------------- Thumbnail pipeline (NEW)
+
+static std::wstring ThumbCacheFilePath() {
+    if (!g_cfg.thumbCachePath.empty()) return g_cfg.thumbCachePath;
+    wchar_t exePath[MAX_PATH] = {};
+    if (!GetModuleFileNameW(NULL, exePath, MAX_PATH)) return L"";
+    PathRemoveFileSpecW(exePath);
+    return std::wstring(exePath) + L"\\mediaexplorer.thumbs";
+}
+
+// Packed file = sequence of records: header + kThumbBytes pixels. Only headers are read at load.
+struct ThumbRecordHeader {
+    uint32_t magic;            // 'MTHB'
+    uint16_t w, h;
+    uint32_t bytes;
+    uint64_t key;
+};
+constexpr uint32_t kThumbMagic = 0x4248544D;
+
+static bool ThumbReadAt(ULONGLONG off, void* dst, DWORD len) {
+    LARGE_INTEGER li; li.QuadPart = (LONGLONG)off;
+    if (!SetFilePointerEx(g_thumbFile, li, NULL, FILE_BEGIN)) return false;
+    DWORD got = 0;
+    return ReadFile(g_thumbFile, dst, len, &got, NULL) && got == len;
+}
+
+static void ThumbCacheOpen() {
+    std::wstring file = ThumbCacheFilePath();
+    if (file.empty()) return;
+    g_thumbFile = CreateFileW(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+        NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (g_thumbFile == INVALID_HANDLE_VALUE) {
+        LogLine(L"ThumbCache: cannot open \"%s\" (err=%lu)", file.c_str(), GetLastError());
+        return;
+    }
+
+    LARGE_INTEGER size{};
+    GetFileSizeEx(g_thumbFile, &size);
+    ULONGLONG off = 0;
+    while (off + sizeof(ThumbRecordHeader) <= (ULONGLONG)size.QuadPart) {
+        ThumbRecordHeader hdr{};
+        if (!ThumbReadAt(off, &hdr, sizeof(hdr)) || hdr.magic != kThumbMagic) break;
+        ULONGLONG next = off + sizeof(hdr) + hdr.bytes;
+        if (next > (ULONGLONG)size.QuadPart) break; // torn append from a crash
+        if (hdr.w == kThumbW && hdr.h == kThumbH && hdr.bytes == kThumbBytes) g_thumbIndex[hdr.key] = off;
+        off = next;
+    }
+    g_thumbFileEnd = off;
+    if (off != (ULONGLONG)size.QuadPart) {
+        // drop the damaged tail so the next append starts on a record boundary
+        LARGE_INTEGER li; li.QuadPart = (LONGLONG)off;
+        SetFilePointerEx(g_thumbFile, li, NULL, FILE_BEGIN);
+        SetEndOfFile(g_thumbFile);
+    }
+    LogLine(L"ThumbCache: %zu thumbnails in \"%s\"", g_thumbIndex.size(), file.c_str());
+}
+
+static void ThumbCacheClose() {
+    if (g_thumbFile != INVALID_HANDLE_VALUE) { CloseHandle(g_thumbFile); g_thumbFile = INVALID_HANDLE_VALUE; }
+}
+
+// Content key: FNV-1a over size + first/last 64 KB. Survives renames/moves/copies; a rewrite changes it.
+static ULONGLONG ThumbContentKey(const std::wstring& path, ULONGLONG size) {
+    HANDLE f = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (f == INVALID_HANDLE_VALUE) return 0;
+
+    ULONGLONG hash = 1469598103934665603ULL;
+    auto mix = [&hash](const BYTE* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) { hash ^= p[i]; hash *= 1099511628211ULL; }
+    };
+    mix((const BYTE*)&size, sizeof(size));
+
+    std::vector<BYTE> buf(64 * 1024);
+    DWORD got = 0;
+    if (ReadFile(f, buf.data(), (DWORD)buf.size(), &got, NULL)) mix(buf.data(), got);
+    if (size > buf.size() * 2) {
+        LARGE_INTEGER li; li.QuadPart = (LONGLONG)(size - buf.size());
+        if (SetFilePointerEx(f, li, NULL, FILE_BEGIN) && ReadFile(f, buf.data(), (DWORD)buf.size(), &got, NULL))
+            mix(buf.data(), got);
+    }
+    CloseHandle(f);
+    return hash ? hash : 1;
+}
+
+// Only touches thumbKey so it never clobbers what the metadata worker stored.
+static void MetaCacheSetThumbKey(const std::wstring& path, ULONGLONG size, ULONGLONG mtime, ULONGLONG key) {
+    EnterCriticalSection(&g_metaCacheLock);
+    MetaCacheEntry& slot = g_metaCache[ToLower(path)];
+    if (slot.size != size || slot.mtime != mtime) {
+        slot = MetaCacheEntry();
+        slot.size = size;
+        slot.mtime = mtime;
+    }
+    slot.thumbKey = key;
+    g_metaCacheDirty = true;
+    LeaveCriticalSection(&g_metaCacheLock);
+}
+
+// Input-side -ss seeks to the keyframe at/before t and -skip_frame nokey makes the decoder
+// ignore everything else, so ffmpeg decodes exactly one frame per file. The ffmpeg runs in
+// g_thumbJob; a cancel (gen bump) kills it and skips the retry.
+static bool ExtractThumbnailFfmpeg(const std::wstring& path, ULONGLONG dur100ns, std::vector<BYTE>& out,
+    uint32_t myGen) {
+    // ~10% in (skips black intros/logos), capped at 5 minutes; 3s if the duration is unknown
+    double t = dur100ns ? (double)dur100ns / 1e7 * 0.10 : 3.0;
+    if (t > 300.0) t = 300.0;
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (myGen != g_thumbGen.load(std::memory_order_relaxed)) break;
+        wchar_t tBuf[32];
+        swprintf_s(tBuf, L"%.3f", attempt == 0 ? t : 0.0);
+        wchar_t vf[160];
+        swprintf_s(vf, L"scale=%d:%d:force_original_aspect_ratio=decrease,pad=%d:%d:(ow-iw)/2:(oh-ih)/2",
+            kThumbW, kThumbH, kThumbW, kThumbH);
+
+        std::wstring cmd = QuoteArg(g_ffmpegExeW) + L" -v error -nostdin -ss ";
+        cmd += tBuf;
+        cmd += L" -skip_frame nokey -i \"";
+        cmd += path;
+        cmd += L"\" -map 0:v:0 -frames:v 1 -an -sn -vf \"";
+        cmd += vf;
+        cmd += L"\" -pix_fmt bgr24 -f rawvideo pipe:1";
+
+        std::string raw;
+        RunHiddenCaptureStdout(cmd, raw, g_thumbJob);
+        if (raw.size() == kThumbBytes) {
+            out.assign(raw.begin(), raw.end());
+            return true;
+        }
+        // seek past the end (bad duration) gives no frame -> retry from the start
+    }
+    return false;
+}
+
+static int ThumbWorkerLimit() {
+    if (g_cfg.thumbWorkers > 0) return g_cfg.thumbWorkers;
+    SYSTEM_INFO si{};
+    GetSystemInfo(&si);
+    int n = (int)si.dwNumberOfProcessors / 2;
+    return n < 1 ? 1 : (n > 4 ? 4 : n);
+}
+
+static DWORD WINAPI ThumbJobProc(LPVOID) {
+    CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+
+    for (;;) {
+        std::wstring path;
+        uint32_t myGen = 0;
+        EnterCriticalSection(&g_thumbLock);
+        if (g_thumbTodo.empty()) {
+            --g_thumbWorkers; // decided under the lock, so a concurrent kick never strands work
+            LeaveCriticalSection(&g_thumbLock);
+            break;
+        }
+        path = g_thumbTodo.back();
+        g_thumbTodo.pop_back();
+        myGen = g_thumbGen.load(std::memory_order_relaxed);
+        LeaveCriticalSection(&g_thumbLock);
+
+        WIN32_FILE_ATTRIBUTE_DATA fad{};
+        if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &fad)) continue;
+        ULARGE_INTEGER uli{};
+        uli.HighPart = fad.nFileSizeHigh;
+        uli.LowPart = fad.nFileSizeLow;
+        const ULONGLONG mtime = FileTimeToU64(fad.ftLastWriteTime);
+
+        MetaCacheEntry e;
+        MetaCacheLookup(path, uli.QuadPart, mtime, e);
+        ULONGLONG key = e.thumbKey;
+        if (!key) {
+            key = ThumbContentKey(path, uli.QuadPart);
+            if (!key) continue;
+            MetaCacheSetThumbKey(path, uli.QuadPart, mtime, key);
+        }
+
+        ThumbResult* res = new ThumbResult();
+        res->path = path;
+        res->gen = myGen;
+
+        bool have = false;
+        EnterCriticalSection(&g_thumbLock);
+        auto it = g_thumbIndex.find(key);
+        if (it != g_thumbIndex.end() && g_thumbFile != INVALID_HANDLE_VALUE) {
+            res->bgr.resize(kThumbBytes);
+            have = ThumbReadAt(it->second + sizeof(ThumbRecordHeader), res->bgr.data(), kThumbBytes);
+        }
+        LeaveCriticalSection(&g_thumbLock);
+
+        if (!have) {
+            if (myGen != g_thumbGen.load(std::memory_order_relaxed)) { delete res; continue; }
+
+            ULONGLONG dur = e.dur;
+            if (!dur) { int w = 0, h = 0; GetVideoPropsFastCached(path, w, h, dur); }
+            if (!ExtractThumbnailFfmpeg(path, dur, res->bgr, myGen)) {
+                if (myGen != g_thumbGen.load(std::memory_order_relaxed)) { delete res; continue; }
+                LogLine(L"Thumb: extraction failed for \"%s\"", path.c_str());
+                delete res;
+                continue;
+            }
+
+            EnterCriticalSection(&g_thumbLock);
+            if (g_thumbFile != INVALID_HANDLE_VALUE && g_thumbIndex.find(key) == g_thumbIndex.end()) {
+                ThumbRecordHeader hdr{ kThumbMagic, (uint16_t)kThumbW, (uint16_t)kThumbH, kThumbBytes, key };
+                LARGE_INTEGER li; li.QuadPart = (LONGLONG)g_thumbFileEnd;
+                DWORD wr1 = 0, wr2 = 0;
+                if (SetFilePointerEx(g_thumbFile, li, NULL, FILE_BEGIN) &&
+                    WriteFile(g_thumbFile, &hdr, sizeof(hdr), &wr1, NULL) &&
+                    WriteFile(g_thumbFile, res->bgr.data(), kThumbBytes, &wr2, NULL) &&
+                    wr1 == sizeof(hdr) && wr2 == kThumbBytes) {
+                    g_thumbIndex[key] = g_thumbFileEnd;
+                    g_thumbFileEnd += sizeof(hdr) + kThumbBytes;
+                }
+            }
+            LeaveCriticalSection(&g_thumbLock);
+        }
+
+        PostMessageW(g_hwndMain, WM_APP_THUMB, 0, (LPARAM)res);
+    }
+
+    CoUninitialize();
+    return 0;
+}
+
+// Caller holds g_thumbLock. Thumbnail jobs are High like metadata probing (rows on screen wait
+// for them), but leave two workers of the pool to the probe job and the file ops.
+static void KickThumbWorkersLocked() {
+    int limit = ThumbWorkerLimit();
+    if (limit > JobWorkerCount() - 2) limit = JobWorkerCount() - 2;
+    if (limit < 1) limit = 1;
+    while (g_thumbWorkers < limit && (int)g_thumbTodo.size() > g_thumbWorkers) {
+        // exits when the todo list is empty; JobShutdown joins it
+        if (!JobSubmit(JobKind::Meta, JobPriority::High, ThumbJobProc, NULL, nullptr, false)) break;
+        ++g_thumbWorkers;
+    }
+}
+
+// Navigation: drop pending work, kill the extractions in flight and the image list
+// (indices belong to the old view)
+static void CancelThumbWorkAndClearTodo() {
+    g_thumbGen.fetch_add(1, std::memory_order_relaxed);
+    EnterCriticalSection(&g_thumbLock);
+    g_thumbTodo.clear();
+    LeaveCriticalSection(&g_thumbLock);
+    if (g_thumbJob) TerminateJobObject(g_thumbJob, ERROR_CANCELLED);
+
+    g_thumbImageOfPath.clear();
+    if (g_thumbImages) ImageList_Remove(g_thumbImages, -1);
+}
+
+// Move the rows currently on screen to the back of the todo list (workers pop from the back)
+static void ThumbPrioritizeVisible() {
+    if (!g_thumbsOn || g_view == ViewKind::Drives) return;
+    int top = ListView_GetTopIndex(g_hwndList);
+    int count = ListView_GetCountPerPage(g_hwndList) + 1;
+    if (top < 0) top = 0;
+
+    std::unordered_map<std::wstring, int> visible;
+    for (int i = top; i < top + count && i < (int)g_rows.size(); ++i) {
+        if (!g_rows[i].isDir) visible[ToLower(g_rows[i].full)] = i;
+    }
+    if (visible.empty()) return;
+
+    EnterCriticalSection(&g_thumbLock);
+    std::stable_partition(g_thumbTodo.begin(), g_thumbTodo.end(),
+        [&visible](const std::wstring& p) { return visible.find(ToLower(p)) == visible.end(); });
+    LeaveCriticalSection(&g_thumbLock);
+}
+
+static void QueueThumbsAndKickWorkers() {
+    if (!g_thumbsOn || g_view == ViewKind::Drives) return;
+
+    EnterCriticalSection(&g_thumbLock);
+    // reverse order so the top of the list comes out first
+    for (int i = (int)g_rows.size() - 1; i >= 0; --i) {
+        const Row& r = g_rows[i];
+        if (r.isDir) continue;
+        if (g_thumbImageOfPath.find(ToLower(r.full)) != g_thumbImageOfPath.end()) continue;
+        g_thumbTodo.push_back(r.full);
+    }
+    LeaveCriticalSection(&g_thumbLock);
+
+    ThumbPrioritizeVisible();
+
+    EnterCriticalSection(&g_thumbLock);
+    KickThumbWorkersLocked();
+    LeaveCriticalSection(&g_thumbLock);
+}
+
+// Ctrl+T: show/hide the thumbnail column (the image list makes report rows thumbnail-tall)
+static void ToggleThumbnails() {
+    if (!g_cfg.ffmpegAvailable) return;
+    g_thumbsOn = !g_thumbsOn;
+
+    CancelThumbWorkAndClearTodo();
+    if (g_thumbsOn) {
+        if (!g_thumbImages) g_thumbImages = ImageList_Create(kThumbW, kThumbH, ILC_COLOR24, 64, 64);
+        ListView_SetImageList(g_hwndList, g_thumbImages, LVSIL_SMALL);
+    }
+    else {
+        ListView_SetImageList(g_hwndList, NULL, LVSIL_SMALL);
+    }
+
+    if (g_view != ViewKind::Drives) {
+        SendMessageW(g_hwndList, WM_SETREDRAW, FALSE, 0);
+        LV_ResetColumns();
+        LV_Rebuild();
+        SendMessageW(g_hwndList, WM_SETREDRAW, TRUE, 0);
+        InvalidateRect(g_hwndList, NULL, TRUE);
+        QueueThumbsAndKickWorkers();
+    }
+}
+
+// ----------------------------- Scan engine (NEW)
+// Worker-safe: no UI, no title updates. Used by the folder aggregator and the finder tasks.
+struct ScanFile {
+    std::wstring path;
+    ULONGLONG size = 0;
+    ULONGLONG mtime = 0;
+};
+
+// One directory level: video files, sub-directories (reparse points skipped to avoid loops)
+// and, optionally, the byte total of every file in the level.
+static void ScanDirectoryLevel(const std::wstring& folder, std::vector<ScanFile>& videos,
+    std::vector<std::wstring>* subdirs, ULONGLONG* allBytes)
+{
+    std::wstring base = EnsureSlash(folder);
+    WIN32_FIND_DATAW fd; ZeroMemory(&fd, sizeof(fd));
+    HANDLE h = FindFirstFileExW((base + L"*").c_str(), FindExInfoBasic, &fd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (h == INVALID_HANDLE_VALUE) return;
+
+    do {
+        if (wcscmp(fd.cFileName, L".") == 0 || wcscmp(fd.cFileName, L"..") == 0) continue;
+        std::wstring full = base + fd.cFileName;
+
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+            if (subdirs) subdirs->push_back(full + L'\\');
+            continue;
+        }
+        ULARGE_INTEGER uli; uli.HighPart = fd.nFileSizeHigh; uli.LowPart = fd.nFileSizeLow;
+        if (allBytes) *allBytes += uli.QuadPart;
+        if (IsVideoFile(full)) {
+            ScanFile f;
+            f.path = full;
+            f.size = uli.QuadPart;
+            f.mtime = FileTimeToU64(fd.ftLastWriteTime);
+            videos.push_back(std::move(f));
+        }
+    } while (FindNextFileW(h, &fd));
+
+    FindClose(h);
+}
+
+static void ScanVideosRecursive(const std::wstring& folder, std::vector<ScanFile>& out,
+    const std::atomic<bool>& cancel)
+{
+    if (cancel.load(std::memory_order_relaxed)) return;
+    std::vector<std::wstring> subdirs;
+    ScanDirectoryLevel(folder, out, &subdirs, nullptr);
+    for (const auto& d : subdirs) ScanVideosRecursive(d, out, cancel);
+}
+
+// Folders are recursed, files are stat'ed; duplicates (same path twice in scope) are dropped.
+static void ScanScope(const std::vector<std::wstring>& folders, const std::vector<std::wstring>& files,
+    std::vector<ScanFile>& out, const std::atomic<bool>& cancel)
+{
+    out.clear();
+    for (const auto& f : files) {
+        WIN32_FILE_ATTRIBUTE_DATA fa{};
+        if (!GetFileAttributesExW(f.c_str(), GetFileExInfoStandard, &fa)) continue;
+        if (fa.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        ScanFile s;
+        s.path = f;
+        ULARGE_INTEGER uli; uli.HighPart = fa.nFileSizeHigh; uli.LowPart = fa.nFileSizeLow;
+        s.size = uli.QuadPart;
+        s.mtime = FileTimeToU64(fa.ftLastWriteTime);
+        out.push_back(std::move(s));
+    }
+    for (const auto& d : folders) ScanVideosRecursive(d, out, cancel);
+
+    std::unordered_map<std::wstring, bool> seen;
+    seen.reserve(out.size() * 2);
+    std::vector<ScanFile> uniq;
+    uniq.reserve(out.size());
+    for (auto& s : out) {
+        if (seen.emplace(ToLower(s.path), true).second) uniq.push_back(std::move(s));
+    }
+    out.swap(uniq);
+}
+
+// ----------------------------- Folder aggregates (NEW)
+// Folder rows get recursive totals: bytes (all files), video count and summed video duration.
+// Every directory walked keeps a memo entry: its own level (bytes, videos, duration sum), the
+// child levels it lists and the totals of its subtree. A pass reads each directory's last-write
+// time and lists the level again only when that changed (an entry was added, removed or
+// renamed), some duration was still unknown, or the listing is older than kDirAggRevalidateMs
+// (files rewritten in place do not touch the directory). A re-listed level adds the difference
+// to its own values to its totals and every ancestor's (child -> parent deltas); a child level
+// that is gone takes its subtree totals with it. Nothing is re-summed, and no tree is too big:
+// a folder row shows running totals ("Folder (n+)") while its walk is under way.
+static constexpr int       kDirAggMaxDepth = 64;                   // deeper levels are not walked
+static constexpr size_t    kDirAggMaxEntries = 200000;             // memo entries kept in memory
+static constexpr ULONGLONG kDirAggRevalidateMs = 10 * 60 * 1000;
+static constexpr ULONGLONG kDirAggPostMs = 500;                    // running totals per row at most this often
+
+struct DirAggMemo {
+    std::wstring parent;                // key of the level that lists this one ("" = not linked)
+    std::vector<std::wstring> subdirs;  // child levels as listed (full paths with trailing '\')
+    ULONGLONG mtime = 0;                // directory last-write time the listing belongs to
+    ULONGLONG listedAt = 0;             // GetTickCount64 of the listing, 0 = never listed
+    ULONGLONG sig = 0;                  // signature of the level's videos ownDur belongs to
+    ULONGLONG ownBytes = 0, ownDur = 0;
+    uint32_t  ownVideos = 0;
+    bool      durComplete = false;      // no video with unknown (0) duration
+    ULONGLONG totBytes = 0, totDur = 0; // own values + the totals of every linked child
+    uint32_t  totVideos = 0;
+    bool      walked = false;           // the last walk of this subtree ran to the end
+};
+
+struct DirAggResult {
+    std::wstring path;
+    uint32_t gen;
+    ULONGLONG bytes, dur;
+    uint32_t videos;
+    bool partial;                       // walk still under way (or cut at kDirAggMaxDepth)
+};
+
+constexpr UINT WM_APP_DIRAGG = WM_APP + 120;
+
+static CRITICAL_SECTION g_dirAggLock;
+static std::unordered_map<std::wstring, DirAggMemo> g_dirAgg; // lower-case path with trailing '\'
+static std::atomic<uint32_t> g_dirAggGen{ 1 };
+
+static std::wstring DirAggKey(const std::wstring& dir) { return ToLower(EnsureSlash(dir)); }
+
+static ULONGLONG DirAggSignature(const std::vector<ScanFile>& videos) {
+    ULONGLONG hash = 1469598103934665603ULL;
+    auto mix = [&hash](const void* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) { hash ^= ((const BYTE*)p)[i]; hash *= 1099511628211ULL; }
+    };
+    for (const auto& v : videos) {
+        mix(v.path.data(), v.path.size() * sizeof(wchar_t));
+        mix(&v.size, sizeof(v.size));
+        mix(&v.mtime, sizeof(v.mtime));
+    }
+    return hash;
+}
+
+// Caller holds g_dirAggLock. Adds the delta to key's totals and every linked ancestor's;
+// unsigned wrap-around makes "negative" deltas work.
+static void DirAggAddLocked(std::wstring key, ULONGLONG bytes, ULONGLONG dur, uint32_t videos) {
+    while (!key.empty()) {
+        auto it = g_dirAgg.find(key);
+        if (it == g_dirAgg.end()) break;
+        it->second.totBytes += bytes;
+        it->second.totDur += dur;
+        it->second.totVideos += videos;
+        key = it->second.parent;
+    }
+}
+
+// Caller holds g_dirAggLock. Drops key and everything linked under it (totals untouched).
+static void DirAggEraseLocked(const std::wstring& key) {
+    auto it = g_dirAgg.find(key);
+    if (it == g_dirAgg.end()) return;
+    std::vector<std::wstring> subs;
+    subs.swap(it->second.subdirs);
+    g_dirAgg.erase(it);
+    for (const auto& s : subs) {
+        const std::wstring k = DirAggKey(s);
+        auto c = g_dirAgg.find(k);
+        if (c != g_dirAgg.end() && c->second.parent == key) DirAggEraseLocked(k);
+    }
+}
+
+// Lists one level and folds the change into the memo; returns false when cancelled (the memo
+// is then left as it was). subdirs receives the child levels.
+static bool DirAggRelist(const std::wstring& dir, const std::wstring& key, ULONGLONG mtime, uint32_t gen,
+    std::vector<std::wstring>& subdirs)
+{
+    std::vector<ScanFile> videos;
+    ULONGLONG bytes = 0;
+    subdirs.clear();
+    ScanDirectoryLevel(dir, videos, &subdirs, &bytes);
+    const ULONGLONG sig = DirAggSignature(videos);
+
+    ULONGLONG dur = 0;
+    bool complete = true, reuse = false;
+    EnterCriticalSection(&g_dirAggLock);
+    auto it = g_dirAgg.find(key);
+    if (it != g_dirAgg.end() && it->second.durComplete && it->second.sig == sig) {
+        dur = it->second.ownDur;
+        reuse = true;
+    }
+    LeaveCriticalSection(&g_dirAggLock);
+
+    if (!reuse) {
+        for (const auto& v : videos) {
+            if (gen != g_dirAggGen.load(std::memory_order_relaxed)) return false;
+            MetaCacheEntry e;
+            ULONGLONG d = 0;
+            if (MetaCacheLookup(v.path, v.size, v.mtime, e) && e.dur) d = e.dur;
+            else { int w = 0, h = 0; GetVideoPropsFastCached(v.path, w, h, d); }
+            if (!d) complete = false; // not probed yet: the level is listed again next pass
+            dur += d;
+        }
+    }
+
+    std::unordered_map<std::wstring, bool> now;
+    for (const auto& s : subdirs) now[DirAggKey(s)] = true;
+
+    EnterCriticalSection(&g_dirAggLock);
+    DirAggMemo& m = g_dirAgg[key]; // references survive inserts and erases of other entries
+    const uint32_t videoCount = (uint32_t)videos.size();
+    DirAggAddLocked(key, bytes - m.ownBytes, dur - m.ownDur, videoCount - m.ownVideos);
+    m.ownBytes = bytes;
+    m.ownDur = dur;
+    m.ownVideos = videoCount;
+    // child levels that are gone take their subtree with them
+    for (const auto& old : m.subdirs) {
+        const std::wstring k = DirAggKey(old);
+        if (now.find(k) != now.end()) continue;
+        auto c = g_dirAgg.find(k);
+        if (c == g_dirAgg.end() || c->second.parent != key) continue;
+        DirAggAddLocked(key, 0 - c->second.totBytes, 0 - c->second.totDur, 0u - c->second.totVideos);
+        DirAggEraseLocked(k);
+    }
+    // new ones are linked; one already in the memo (an earlier folder row) brings its totals
+    for (const auto& s : subdirs) {
+        const std::wstring k = DirAggKey(s);
+        auto c = g_dirAgg.find(k);
+        if (c == g_dirAgg.end()) { g_dirAgg[k].parent = key; continue; }
+        if (c->second.parent == key) continue;
+        c->second.parent = key;
+        DirAggAddLocked(key, c->second.totBytes, c->second.totDur, c->second.totVideos);
+    }
+    m.subdirs = subdirs;
+    m.mtime = mtime;
+    m.listedAt = GetTickCount64();
+    m.sig = sig;
+    m.durComplete = complete;
+    LeaveCriticalSection(&g_dirAggLock);
+    return true;
+}
+
+// One folder row's walk
+struct DirAggWalk {
+    uint32_t gen = 0;
+    std::wstring rowPath, rowKey;
+    ULONGLONG lastPost = 0;
+    int cutoffs = 0;                    // levels left out at kDirAggMaxDepth
+};
+
+static void DirAggPost(DirAggWalk& w, bool partial) {
+    DirAggResult* res = new DirAggResult{ w.rowPath, w.gen, 0, 0, 0, partial };
+    EnterCriticalSection(&g_dirAggLock);
+    auto it = g_dirAgg.find(w.rowKey);
+    if (it != g_dirAgg.end()) {
+        res->bytes = it->second.totBytes;
+        res->dur = it->second.totDur;
+        res->videos = it->second.totVideos;
+    }
+    LeaveCriticalSection(&g_dirAggLock);
+    PostMessageW(g_hwndMain, WM_APP_DIRAGG, 0, (LPARAM)res);
+    w.lastPost = GetTickCount64();
+}
+
+// Returns false when cancelled.
+static bool DirAggVisit(DirAggWalk& w, const std::wstring& dir, int depth) {
+    if (w.gen != g_dirAggGen.load(std::memory_order_relaxed)) return false;
+    if (depth > kDirAggMaxDepth) { ++w.cutoffs; return true; }
+    const int cutoffsBefore = w.cutoffs;
+    const std::wstring key = DirAggKey(dir);
 
-        int w = 0, h = 0; ULONGLONG d = 0;
-        GetVideoProps(path, w, h, d); // heavy; OK in worker
-        MetaResult* r = new MetaResult{ path, w, h, d, myGen };
-        PostMessageW(g_hwndMain, WM_APP_META, 0, (LPARAM)r);
+    WIN32_FILE_ATTRIBUTE_DATA fad{};
+    const ULONGLONG mtime = GetFileAttributesExW(dir.c_str(), GetFileExInfoStandard, &fad)
+        ? FileTimeToU64(fad.ftLastWriteTime) : 0;
+
+    std::vector<std::wstring> subdirs;
+    bool relist = true;
+    EnterCriticalSection(&g_dirAggLock);
+    auto it = g_dirAgg.find(key);
+    if (it != g_dirAgg.end() && it->second.listedAt && mtime && it->second.mtime == mtime &&
+        it->second.durComplete && GetTickCount64() - it->second.listedAt < kDirAggRevalidateMs) {
+        subdirs = it->second.subdirs;
+        relist = false;
+    }
+    LeaveCriticalSection(&g_dirAggLock);
+
+    if (relist) {
+        if (!DirAggRelist(dir, key, mtime, w.gen, subdirs)) return false;
+        if (GetTickCount64() - w.lastPost >= kDirAggPostMs) DirAggPost(w, true);
+    }
+    for (const auto& sub : subdirs) {
+        if (!DirAggVisit(w, sub, depth + 1)) return false;
+    }
+
+    EnterCriticalSection(&g_dirAggLock);
+    it = g_dirAgg.find(key);
+    if (it != g_dirAgg.end()) it->second.walked = (w.cutoffs == cutoffsBefore);
+    LeaveCriticalSection(&g_dirAggLock);
+    return true;
+}
+
+// Show last known totals right away (the worker confirms or corrects them).
+static void DirAggFillRow(Row& r) {
+    if (!r.isDir) return;
+    EnterCriticalSection(&g_dirAggLock);
+    auto it = g_dirAgg.find(DirAggKey(r.full));
+    if (it != g_dirAgg.end() && it->second.listedAt) {
+        r.size = it->second.totBytes;
+        r.vDur100ns = it->second.totDur;
+        r.aggVideos = it->second.totVideos;
+        r.aggDone = true;
+        r.aggPartial = !it->second.walked;
+    }
+    LeaveCriticalSection(&g_dirAggLock);
+}
+
+struct DirAggTask {
+    uint32_t gen;
+    std::vector<std::wstring> dirs;
+};
+
+static DWORD WINAPI DirAggJobProc(LPVOID param) {
+    DirAggTask* task = (DirAggTask*)param;
+    CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+    // over the cap: start over (only between walks, so no subtree is left half-linked)
+    EnterCriticalSection(&g_dirAggLock);
+    if (g_dirAgg.size() > kDirAggMaxEntries) g_dirAgg.clear();
+    LeaveCriticalSection(&g_dirAggLock);
+    for (const auto& dir : task->dirs) {
+        DirAggWalk w;
+        w.gen = task->gen;
+        w.rowPath = dir;
+        w.rowKey = DirAggKey(dir);
+        w.lastPost = GetTickCount64();
+        if (!DirAggVisit(w, dir, 0)) break; // newer pass or shutdown
+        DirAggPost(w, w.cutoffs != 0);
     }
-
     CoUninitialize();
+    delete task;
     return 0;
 }
-static void StartMetaWorker() {
-    if (g_metaThread) { CloseHandle(g_metaThread); g_metaThread = NULL; } // let old thread exit on gen bump
-    g_metaThread = CreateThread(NULL, 0, MetaThreadProc, NULL, 0, NULL);
-}
-static void CancelMetaWorkAndClearTodo() {
-    g_metaGen.fetch_add(1, std::memory_order_relaxed);
-    EnterCriticalSection(&g_metaLock);
-    g_metaTodoPaths.clear();
-    LeaveCriticalSection(&g_metaLock);
+
+static void CancelDirAggWork() {
+    g_dirAggGen.fetch_add(1, std::memory_order_relaxed);
 }
 
-// After (re)building g_rows + ListView, queue any videos still missing props:
-static void QueueMissingPropsAndKickWorker() {
-    EnterCriticalSection(&g_metaLock);
-    for (const auto& r : g_rows) {
-        if (!r.isDir && r.vW == 0 && r.vH == 0 && r.vDur100ns == 0) {
-            g_metaTodoPaths.push_back(r.full);
-        }
-    }
-    LeaveCriticalSection(&g_metaLock);
-    if (!g_metaTodoPaths.empty()) StartMetaWorker();
+// Folder view only (Search has no folder rows, Drives has its own columns)
+static void QueueDirAggregates() {
+    if (g_view != ViewKind::Folder) return;
+    DirAggTask* task = new DirAggTask();
+    task->gen = g_dirAggGen.load(std::memory_order_relaxed);
+    for (const auto& r : g_rows) if (r.isDir) task->dirs.push_back(r.full);
+    if (task->dirs.empty()) { delete task; return; }
+
+    // Low: a deep tree walk must not hold up pastes or probing; an older walk stops at the gen bump
+    if (!JobSubmit(JobKind::Meta, JobPriority::Low, DirAggJobProc, task, nullptr, false)) delete task;
 }
 
 // ----------------------------- Populate views
 static void ShowDrives() {
     CancelBackgroundFolderReload(); // NEW
     CancelMetaWorkAndClearTodo();
+    CancelThumbWorkAndClearTodo();
+    CancelDirAggWork();
 
     g_view = ViewKind::Drives; g_folder.clear(); g_rows.clear();
 
@@ -2287,6 +6347,8 @@ static void ShowDrives() {
 static void ShowFolder(std::wstring abs) {
     CancelBackgroundFolderReload(); // NEW
     CancelMetaWorkAndClearTodo();
+    CancelThumbWorkAndClearTodo();
+    CancelDirAggWork();
 
     if (abs.size() == 2 && abs[1] == L':') abs += L'\\';
     abs = EnsureSlash(abs);
@@ -2339,14 +6401,15 @@ static void ShowFolder(std::wstring abs) {
 
         if (r.isDir) {
             r.full += L'\\';
+            DirAggFillRow(r);
             dirs.push_back(r);
         }
         else if (IsVideoFile(r.full)) {
             ULARGE_INTEGER uli; uli.HighPart = fd.nFileSizeHigh; uli.LowPart = fd.nFileSizeLow;
             r.size = uli.QuadPart;
 
-            // FAST cached try first (cheap)
-            if (!GetVideoPropsFastCached(r.full, r.vW, r.vH, r.vDur100ns)) {
+            // FAST cached try first (cheap): our metadata cache, then the shell's
+            if (!MetaCacheFillRow(r) && !GetVideoPropsFastCached(r.full, r.vW, r.vH, r.vDur100ns)) {
                 r.vW = r.vH = 0; r.vDur100ns = 0; // mark for async
             }
             vids.push_back(r);
@@ -2379,16 +6442,68 @@ static void ShowFolder(std::wstring abs) {
 
     // Queue remaining metadata and kick worker
     QueueMissingPropsAndKickWorker();
+    QueueThumbsAndKickWorkers();
+    QueueDirAggregates();
 
     // End cleanly on space / remove spinner by restoring normal title
     SetTitleFolderOrDrives();
 }
 
 // ----------------------------- Search (recursive, case-insensitive, AND terms)
+// NEW: "field:value" terms filter on metadata instead of the name (':' cannot appear in a file name).
+static bool SplitFieldTerm(const std::wstring& term, std::wstring& field, std::wstring& value) {
+    size_t colon = term.find(L':');
+    if (colon == std::wstring::npos || colon == 0) return false;
+    field = term.substr(0, colon);
+    value = term.substr(colon + 1);
+    return field == L"vcodec" || field == L"codec" || field == L"acodec" || field == L"audio" ||
+        field == L"container" || field == L"fps" || field == L"ch" || field == L"channels" || field == L"res";
+}
 static bool NameContainsAllTerms(const std::wstring& full, const std::vector<std::wstring>& termsLower) {
     const wchar_t* base = wcsrchr(full.c_str(), L'\\'); base = base ? base + 1 : full.c_str();
     std::wstring bl = ToLower(base);
-    for (size_t i = 0; i < termsLower.size(); ++i) if (bl.find(termsLower[i]) == std::wstring::npos) return false;
+    std::wstring field, value;
+    for (size_t i = 0; i < termsLower.size(); ++i) {
+        if (SplitFieldTerm(termsLower[i], field, value)) continue; // checked by RowMatchesFieldTerms
+        if (bl.find(termsLower[i]) == std::wstring::npos) return false;
+    }
+    return true;
+}
+// The current search has a codec / fps / channel / container term.
+static bool SearchWantsExtended() {
+    if (g_view != ViewKind::Search || !g_search.active) return false;
+    std::wstring field, value;
+    for (const auto& t : g_search.termsLower)
+        if (SplitFieldTerm(t, field, value) && field != L"res") return true;
+    return false;
+}
+
+// Substring match against the same text the columns show, using what the row already has
+// (metadata cache / shell). A row whose value is not known yet passes for now: the metadata
+// worker probes it and WM_APP_META drops it if it then fails. Never probes on this thread.
+static bool RowMatchesFieldTerms(Row& r, const std::vector<std::wstring>& termsLower) {
+    std::wstring field, value;
+    for (size_t i = 0; i < termsLower.size(); ++i) {
+        if (!SplitFieldTerm(termsLower[i], field, value)) continue;
+
+        std::wstring text;
+        if (field == L"res") {
+            if (r.vW > 0 || r.vH > 0) {
+                wchar_t buf[64]; swprintf_s(buf, L"%dx%d", r.vW, r.vH);
+                text = buf;
+            }
+            else if (r.vDur100ns == 0) continue;   // props not read yet
+        }
+        else {
+            if (!r.extProbed && g_cfg.ffprobeAvailable) continue;   // queued for the worker
+            int col = (field == L"vcodec" || field == L"codec") ? 6
+                : (field == L"fps") ? 8
+                : (field == L"acodec" || field == L"audio") ? 9
+                : (field == L"ch" || field == L"channels") ? 10 : 11;
+            text = ToLower(ExtendedColumnText(r, col));
+        }
+        if (text.empty() || text.find(value) == std::wstring::npos) return false;
+    }
     return true;
 }
 static void SearchRecurseFolder(const std::wstring& folder,
@@ -2422,9 +6537,11 @@ static void SearchRecurseFolder(const std::wstring& folder,
                 r.size = uli.QuadPart;
 
                 // FAST cached only here; deep props deferred to worker
-                GetVideoPropsFastCached(r.full, r.vW, r.vH, r.vDur100ns);
+                if (!MetaCacheFillRow(r))
+                    GetVideoPropsFastCached(r.full, r.vW, r.vH, r.vDur100ns);
 
-                out.push_back(r);
+                if (RowMatchesFieldTerms(r, terms))
+                    out.push_back(r);
             }
         }
     } while (FindNextFileW(h, &fd));
@@ -2456,8 +6573,10 @@ static void RunSearchFromOrigin(std::vector<Row>& outResults) {
                 uli.LowPart = fad.nFileSizeLow;
                 r.size = uli.QuadPart;
 
-                GetVideoPropsFastCached(r.full, r.vW, r.vH, r.vDur100ns); // cheap, deep fill is async later
-                outResults.push_back(std::move(r));
+                if (!MetaCacheFillRow(r))
+                    GetVideoPropsFastCached(r.full, r.vW, r.vH, r.vDur100ns); // cheap, deep fill is async later
+                if (RowMatchesFieldTerms(r, g_search.termsLower))
+                    outResults.push_back(std::move(r));
             }
         }
 
@@ -2487,6 +6606,8 @@ static void RunSearchFromOrigin(std::vector<Row>& outResults) {
 static void ShowSearchResults(const std::vector<Row>& results) {
     CancelBackgroundFolderReload(); // NEW
     CancelMetaWorkAndClearTodo();
+    CancelThumbWorkAndClearTodo();
+    CancelDirAggWork();
 
     g_view = ViewKind::Search;
     g_rows = results; // copy
@@ -2505,6 +6626,7 @@ static void ShowSearchResults(const std::vector<Row>& results) {
 
     // Queue remaining metadata and kick worker
     QueueMissingPropsAndKickWorker();
+    QueueThumbsAndKickWorkers();
 }
 static void ExitSearchToOrigin() {
     if (!g_search.active) return;
@@ -2513,6 +6635,83 @@ static void ExitSearchToOrigin() {
     g_search = SearchState(); // reset
 }
 
+// NEW: grouped finder results (similar / duplicates) reuse the Search view; Backspace returns
+// to where the finder was started.
+static void ShowGroupedResults(const std::vector<Row>& rows, const std::wstring& label,
+    ViewKind originView, const std::wstring& originFolder)
+{
+    if (rows.empty()) {
+        StatusBarSetText(label + L" - nothing found");
+        return;
+    }
+    g_search = SearchState();
+    g_search.active = true;
+    g_search.originView = originView;
+    g_search.originFolder = originFolder;
+    g_search.groupLabel = label;
+    ShowSearchResults(rows);
+}
+
+// Grouped view refresh: drop members that vanished (e.g. deleted) and sets left with one file.
+static void RefreshGroupedResults() {
+    std::unordered_map<int, int> alive;
+    std::vector<Row> kept;
+    kept.reserve(g_rows.size());
+    for (const Row& r : g_rows) {
+        if (GetFileAttributesW(r.full.c_str()) == INVALID_FILE_ATTRIBUTES) continue;
+        ++alive[r.groupId];
+        kept.push_back(r);
+    }
+    std::vector<Row> out;
+    out.reserve(kept.size());
+    for (Row& r : kept) if (alive[r.groupId] > 1) out.push_back(std::move(r));
+    ShowSearchResults(out);
+}
+
+// Drops the rows of deleted files from the current view in place (no folder rescan).
+// Grouped views also drop sets that are down to one file.
+static void RemoveRowsForPaths(const std::vector<std::wstring>& paths) {
+    if (paths.empty() || g_rows.empty() || g_view == ViewKind::Drives) return;
+    std::unordered_map<std::wstring, bool> gone;
+    for (const auto& p : paths) gone[ToLower(p)] = true;
+
+    if (g_view == ViewKind::Search && g_search.active && !g_search.groupLabel.empty()) {
+        std::unordered_map<int, int> alive;
+        std::vector<Row> kept;
+        kept.reserve(g_rows.size());
+        for (const Row& r : g_rows) {
+            if (!r.isDir && gone.count(ToLower(r.full))) continue;
+            ++alive[r.groupId];
+            kept.push_back(r);
+        }
+        if (kept.size() == g_rows.size()) return;
+        std::vector<Row> out;
+        out.reserve(kept.size());
+        for (Row& r : kept) if (alive[r.groupId] > 1) out.push_back(std::move(r));
+        ShowSearchResults(out);
+        return;
+    }
+
+    SendMessageW(g_hwndList, WM_SETREDRAW, FALSE, 0);
+    for (int i = (int)g_rows.size() - 1; i >= 0; --i) {
+        if (g_rows[i].isDir || !gone.count(ToLower(g_rows[i].full))) continue;
+        g_rows.erase(g_rows.begin() + i);
+        ListView_DeleteItem(g_hwndList, i);
+    }
+    SendMessageW(g_hwndList, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(g_hwndList, NULL, TRUE);
+}
+
+// Ctrl+A in a grouped view: everything except the first row of each set (current sort order),
+// so Del keeps exactly one copy per set.
+static void SelectAllButFirstPerGroup() {
+    std::unordered_map<int, bool> seen;
+    for (int i = 0; i < (int)g_rows.size(); ++i) {
+        const bool first = seen.emplace(g_rows[i].groupId, true).second;
+        ListView_SetItemState(g_hwndList, i, first ? 0 : LVIS_SELECTED, LVIS_SELECTED);
+    }
+}
+
 // ----------------------------- File operations (browser)
 static void Browser_CopySelectedToClipboard(ClipMode mode) {
     g_clipFiles.clear();
@@ -2565,6 +6764,74 @@ static std::wstring UniqueName(const std::wstring& folder, const std::wstring& b
     return target;
 }
 
+// ---- Destination name planner for batches (paste / Topaz submit / combine)
+// The destination folder is listed once; every name in the batch is then resolved in memory
+// ("name (1).ext", ...) instead of probing the share per attempt. Names handed out are taken
+// too, since a batch copies concurrently. The plan can go stale, so the final create uses
+// create-new semantics and a collision just takes the next free name.
+struct NamePlan {
+    std::wstring folder;                              // ends with '\'
+    std::unordered_map<std::wstring, bool> taken;     // lower-case names listed or handed out
+    bool listed = false;                              // listing failed: probe the file system instead
+};
+
+static void NamePlanBegin(NamePlan& np, const std::wstring& folder) {
+    np.folder = EnsureSlash(folder);
+    np.taken.clear();
+    WIN32_FIND_DATAW fd{};
+    HANDLE h = FindFirstFileExW((np.folder + L"*").c_str(), FindExInfoBasic, &fd, FindExSearchNameMatch, NULL,
+        FIND_FIRST_EX_LARGE_FETCH);
+    if (h == INVALID_HANDLE_VALUE) {
+        np.listed = (GetLastError() == ERROR_FILE_NOT_FOUND);
+        return;
+    }
+    do {
+        np.taken[ToLower(fd.cFileName)] = true;
+    } while (FindNextFileW(h, &fd));
+    FindClose(h);
+    np.listed = true;
+}
+
+static bool NamePlanIsFree(const NamePlan& np, const std::wstring& name) {
+    if (np.taken.count(ToLower(name))) return false;
+    return np.listed || !PathFileExistsW((np.folder + name).c_str());
+}
+
+// Marks a name as present (e.g. a file found at create time that the listing missed).
+static void NamePlanMark(NamePlan& np, const std::wstring& name) {
+    np.taken[ToLower(name)] = true;
+}
+
+// Next free "base[ (n)]ext" whose sidecars (same stem, other extensions) are free too; all are taken.
+static std::wstring NamePlanTake(NamePlan& np, const std::wstring& base, const std::wstring& ext,
+    const std::vector<std::wstring>& sidecarExts = {})
+{
+    for (int i = 0; i < 10000; ++i) {
+        std::wstring stem = base;
+        if (i > 0) {
+            wchar_t buf[32]; swprintf_s(buf, L" (%d)", i);
+            stem += buf;
+        }
+        bool free = NamePlanIsFree(np, stem + ext);
+        for (size_t k = 0; free && k < sidecarExts.size(); ++k) free = NamePlanIsFree(np, stem + sidecarExts[k]);
+        if (!free) continue;
+        NamePlanMark(np, stem + ext);
+        for (const auto& e : sidecarExts) NamePlanMark(np, stem + e);
+        return np.folder + stem + ext;
+    }
+    return np.folder + base + ext;
+}
+
+// Base name and extension of a path, as NamePlanTake wants them.
+static void SplitBaseExt(const std::wstring& path, std::wstring& base, std::wstring& ext) {
+    const wchar_t* name = wcsrchr(path.c_str(), L'\\');
+    name = name ? name + 1 : path.c_str();
+    wchar_t fname[_MAX_FNAME] = {}, fext[_MAX_EXT] = {};
+    _wsplitpath_s(name, NULL, 0, NULL, 0, fname, _MAX_FNAME, fext, _MAX_EXT);
+    base = fname;
+    ext = fext;
+}
+
 // ----------------------------- DPI helpers
 typedef UINT(WINAPI* GetDpiForWindow_t)(HWND);
 static int DpiScale(int px) {
@@ -2901,6 +7168,20 @@ static bool PromptCombinedOutputName(const std::wstring& baseFolder,
 // Combine selected files using external video_combine.exe in background thread.
 // Combine selected files using external video_combine.exe in background thread.
 // Now supports Folder view AND Search view.
+static void FfTempListSave();
+
+// Combine output while ffmpeg writes it: beside the final "<stem>_combined<ext>", hidden from
+// listings and in the temp list (a crash leaves nothing behind); the ext stays last for the muxer.
+static std::wstring CombineOutputTemp(const std::wstring& combinedFull) {
+    std::wstring stem, ext;
+    SplitBaseExt(combinedFull, stem, ext);
+    std::wstring dir = combinedFull.substr(0, combinedFull.size() - (stem.size() + ext.size()));
+    static unsigned s_tempSeq = 0;
+    wchar_t tag[64];
+    swprintf_s(tag, L"_combined.metmp-%lu-%u-combine", GetCurrentProcessId(), ++s_tempSeq);
+    return dir + stem + tag + ext;
+}
+
 static void Browser_CombineSelected() {
     if (!g_cfg.ffmpegAvailable) {
         MessageBoxW(g_hwndMain,
@@ -2967,7 +7248,7 @@ static void Browser_CombineSelected() {
     std::wstring combinedFull;
     if (!PromptCombinedOutputName(baseFolder, defaultName, combinedFull)) return;
 
-    // Working dir under the chosen base folder
+    // Working dir for intermediates: combine_scratch if set, else under the chosen base folder
     std::wstring folderWithSlash = EnsureSlash(baseFolder);
 
     const wchar_t* baseOut = wcsrchr(combinedFull.c_str(), L'\\');
@@ -2976,12 +7257,17 @@ static void Browser_CombineSelected() {
     size_t dotPos = baseOutName.find_last_of(L'.');
     std::wstring outStem = (dotPos == std::wstring::npos) ? baseOutName : baseOutName.substr(0, dotPos);
 
-    std::wstring copyDir = folderWithSlash + outStem + L"\\";
+    // Always a fresh subfolder: never a folder that may already hold the user's files
+    wchar_t uniq[48];
+    swprintf_s(uniq, L"-%lu-%llu\\", GetCurrentProcessId(), (unsigned long long)GetTickCount64());
+    std::wstring workDir = (g_cfg.combineScratch.empty() ? folderWithSlash : EnsureSlash(g_cfg.combineScratch)) +
+        outStem + uniq;
 
     CombineTask* task = new CombineTask();
-    task->workingDir = copyDir;
+    task->workingDir = workDir;
     task->srcFiles = srcFiles;
     task->combinedFull = combinedFull;
+    task->outputTemp = CombineOutputTemp(combinedFull);
     task->title = baseOutName;
     task->running = true;
 
@@ -2998,28 +7284,29 @@ static void Browser_CombineSelected() {
     EnterCriticalSection(&g_combineLock);
     g_combineTasks.push_back(task);
     LeaveCriticalSection(&g_combineLock);
+    FfTempListSave();   // before ffmpeg can create the temp
 
-    HANDLE hThread = CreateThread(NULL, 0, CombineThreadProc, task, 0, NULL);
-    if (!hThread) {
+    // Low priority: a combine runs for a long time and must not hold back file ops
+    task->jobId = JobSubmit(JobKind::Combine, JobPriority::Low, CombineJobProc, task, &task->cancel, true);
+    if (!task->jobId) {
         EnterCriticalSection(&g_combineLock);
         auto it = std::find(g_combineTasks.begin(), g_combineTasks.end(), task);
         if (it != g_combineTasks.end()) g_combineTasks.erase(it);
         LeaveCriticalSection(&g_combineLock);
+        FfTempListSave();
 
         if (IsWindow(task->hwnd)) DestroyWindow(task->hwnd);
         delete task;
 
-        MessageBoxW(g_hwndMain, L"Failed to start background thread for video combine.",
+        MessageBoxW(g_hwndMain, L"Failed to start background job for video combine.",
             L"Combine videos", MB_OK);
         return;
     }
 
-    task->hThread = hThread;
-
     std::wstring startMsg = L"Starting combine for ";
     wchar_t buf2[64]; swprintf_s(buf2, L"%zu", task->srcFiles.size());
     startMsg += buf2;
-    startMsg += L" file(s)...\r\nWorking directory: ";
+    startMsg += L" file(s)...\r\nWorking directory (intermediates): ";
     startMsg += task->workingDir;
     startMsg += L"\r\n";
     PostCombineOutput(task, startMsg);
@@ -3070,9 +7357,10 @@ struct VideoToolsCtx {
     HWND btn1 = NULL; // upscale
     HWND btn2 = NULL; // trim front
     HWND btn3 = NULL; // trim end
-    HWND btn4 = NULL; // hflip
+    HWND btn4 = NULL; // hflip (display matrix)
+    HWND btn5 = NULL; // hflip baked in (re-encode)
     bool accepted = false;
-    int  choice = 0;  // 1..4
+    int  choice = 0;  // 1..5
     bool canUpscale = false;
     bool canFfmpeg = false;
 };
@@ -3118,23 +7406,30 @@ static LRESULT CALLBACK VideoToolsProc(HWND h, UINT m, WPARAM w, LPARAM l) {
             SendMessageW(g_vtools.btn3, WM_SETFONT, (WPARAM)hf, TRUE);
             y += btnH + DpiScale(6);
 
-            g_vtools.btn4 = CreateWindowExW(0, L"BUTTON", L"Horizontal flip (ffmpeg)",
+            g_vtools.btn4 = CreateWindowExW(0, L"BUTTON", L"Horizontal flip (display flag, no re-encode)",
                 WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON | BS_LEFT,
                 margin, y, btnW, btnH, h, (HMENU)4004, g_hInst, NULL);
             SendMessageW(g_vtools.btn4, WM_SETFONT, (WPARAM)hf, TRUE);
             y += btnH + DpiScale(6);
+
+            g_vtools.btn5 = CreateWindowExW(0, L"BUTTON", L"Horizontal flip, baked in (ffmpeg re-encode)",
+                WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON | BS_LEFT,
+                margin, y, btnW, btnH, h, (HMENU)4005, g_hInst, NULL);
+            SendMessageW(g_vtools.btn5, WM_SETFONT, (WPARAM)hf, TRUE);
+            y += btnH + DpiScale(6);
         }
 
         return 0;
     }
     case WM_COMMAND: {
         int id = LOWORD(w);
-        if (id >= 4001 && id <= 4004) {
+        if (id >= 4001 && id <= 4005) {
             g_vtools.accepted = true;
             if (id == 4001) g_vtools.choice = 1;
             else if (id == 4002) g_vtools.choice = 2;
             else if (id == 4003) g_vtools.choice = 3;
             else if (id == 4004) g_vtools.choice = 4;
+            else if (id == 4005) g_vtools.choice = 5;
             DestroyWindow(h);
             return 0;
         }
@@ -3162,6 +7457,10 @@ static LRESULT CALLBACK VideoToolsProc(HWND h, UINT m, WPARAM w, LPARAM l) {
             SendMessageW(h, WM_COMMAND, 4004, 0);
             return 0;
         }
+        if (w == '5' && g_vtools.canFfmpeg) {
+            SendMessageW(h, WM_COMMAND, 4005, 0);
+            return 0;
+        }
         break;
     case WM_CLOSE:
         g_vtools.accepted = false;
@@ -3203,7 +7502,7 @@ static int PromptVideoToolsChoice(bool canUpscale, bool canFfmpeg) {
     GetMonitorInfoW(hm, &mi);
     RECT wa = mi.rcWork;
 
-    int W = DpiScale(420), H = DpiScale(220);
+    int W = DpiScale(420), H = DpiScale(256);
     int X = wa.left + ((wa.right - wa.left) - W) / 2;
     int Y = wa.top + ((wa.bottom - wa.top) - H) / 2;
 
@@ -3319,6 +7618,17 @@ static bool PromptKeyword(std::wstring& out) {
 }
 
 // ----------------------------- Playback
+static bool PathInList(const std::vector<std::wstring>& list, const std::wstring& path) {
+    for (const auto& p : list) if (_wcsicmp(p.c_str(), path.c_str()) == 0) return true;
+    return false;
+}
+
+static std::wstring DeleteBatchTitle(const std::vector<std::wstring>& files) {
+    if (files.size() != 1) return L"Delete " + std::to_wstring(files.size()) + L" files";
+    const wchar_t* base = wcsrchr(files[0].c_str(), L'\\');
+    return std::wstring(L"Delete: ") + (base ? base + 1 : files[0].c_str());
+}
+
 static void ApplyPostActionsAndRefresh(bool hadFfmpegTasks) {
     // We no longer rebuild the folder/search view here.
     // We return immediately to the existing list (cached), then (optionally)
@@ -3327,17 +7637,21 @@ static void ApplyPostActionsAndRefresh(bool hadFfmpegTasks) {
     const bool inFolderView = (g_view == ViewKind::Folder && !g_folder.empty());
     int fileOpsScheduled = 0;
 
-    // Count how many background file ops we will schedule (DeleteFile + CopyToPath)
+    // Count how many background file ops we will schedule (all deletes are one task, one per CopyToPath)
+    std::vector<std::wstring> doomed;
+    int copiesScheduled = 0;
     for (const auto& a : g_post) {
-        if (a.type == ActionType::DeleteFile) ++fileOpsScheduled;
-        else if (a.type == ActionType::CopyToPath) ++fileOpsScheduled;
+        if (a.type == ActionType::DeleteFile) doomed.push_back(a.src);
+        else if (a.type == ActionType::CopyToPath) ++copiesScheduled;
         // RenameFile is synchronous (MoveFileEx) in your current design
     }
+    fileOpsScheduled = copiesScheduled + (doomed.empty() ? 0 : 1);
 
     // Decide if we want a folder reload at all:
     // - Only for Folder view
-    // - Only if something likely changed (ffmpeg ran, rename ran, or we scheduled playback-exit file ops)
-    bool wantsFolderReload = inFolderView && (hadFfmpegTasks || fileOpsScheduled > 0);
+    // - Only if something likely changed (ffmpeg ran, rename ran, or we scheduled playback-exit copies)
+    // Deletes alone need no reload: their completion removes the rows itself.
+    bool wantsFolderReload = inFolderView && (hadFfmpegTasks || copiesScheduled > 0);
 
     // If we scheduled file ops, we wait for them to finish before background reload.
     uint32_t batchGen = 0;
@@ -3349,23 +7663,31 @@ static void ApplyPostActionsAndRefresh(bool hadFfmpegTasks) {
         batchGen = g_pbExitBatchActive;
     }
 
+    // One bulk delete for every file marked during playback; it starts once the copies of the
+    // same files are done (they may wait for a device slot, the delete takes none).
+    // Mark as playback-exit so OnFileOpDone won't do an expensive foreground refresh.
+    PlaybackExitDelete* pendingDelete = nullptr;
+    if (!doomed.empty()) {
+        pendingDelete = new PlaybackExitDelete();
+        pendingDelete->files = doomed;
+        pendingDelete->gen = batchGen;
+        for (const auto& a : g_post) {
+            if (a.type == ActionType::CopyToPath && PathInList(doomed, a.src)) ++pendingDelete->copiesLeft;
+        }
+        if (pendingDelete->copiesLeft == 0) {
+            ScheduleDeleteFilesAsync(doomed, DeleteBatchTitle(doomed), true, batchGen);
+            delete pendingDelete;
+            pendingDelete = nullptr;
+        }
+    }
+
     // Run post actions:
     for (size_t i = 0; i < g_post.size(); ++i) {
         const PostAction& a = g_post[i];
         switch (a.type) {
-        case ActionType::DeleteFile: {
-            std::vector<std::wstring> one{ a.src };
-
-            const wchar_t* base = wcsrchr(a.src.c_str(), L'\\');
-            base = base ? base + 1 : a.src.c_str();
-
-            std::wstring title = L"Delete: ";
-            title += base;
+        case ActionType::DeleteFile:
+            break; // scheduled above
 
-            // Mark as playback-exit so WM_APP_FILEOP_DONE won't do an expensive foreground refresh.
-            ScheduleDeleteFilesAsync(one, title, true, batchGen);
-            break;
-        }
         case ActionType::RenameFile: {
             // Synchronous (as you already do)
             BOOL ok = MoveFileExW(a.src.c_str(), a.param.c_str(),
@@ -3385,17 +7707,18 @@ static void ApplyPostActionsAndRefresh(bool hadFfmpegTasks) {
             std::wstring title = L"Copy: ";
             title += base;
 
-            // Mark as playback-exit so WM_APP_FILEOP_DONE won't do an expensive foreground refresh.
-            ScheduleCopyToPathAsync(a.src, a.param, title, true, batchGen);
+            // Mark as playback-exit so OnFileOpDone won't do an expensive foreground refresh.
+            ScheduleCopyToPathAsync(a.src, a.param, title, true, batchGen,
+                pendingDelete && PathInList(doomed, a.src) ? pendingDelete : nullptr);
             break;
         }
         }
     }
     g_post.clear();
 
-    // If we want a folder reload but did NOT schedule any async file ops,
-    // do it immediately in the background (still only if we're still on same folder later).
-    if (wantsFolderReload && fileOpsScheduled == 0) {
+    // If we want a folder reload but no batch waits for file ops (none scheduled, or only
+    // deletes, which drop their own rows), do it now in the background.
+    if (wantsFolderReload && batchGen == 0) {
         StartBackgroundFolderReload(g_folder);
     }
 
@@ -3403,6 +7726,26 @@ static void ApplyPostActionsAndRefresh(bool hadFfmpegTasks) {
     // That is what was causing the slow, synchronous disk rebuild on ESC.
 }
 
+// libVLC 3 takes only the rotation out of an MP4 display matrix, so a mirrored matrix plays
+// as a 180-degree turn; a vertical flip on top of that shows the intended mirror image.
+// startMs > 0 reopens the file there (mirror flag found after playback started).
+static void PlayLoadMedia(const std::wstring& path, bool mirrored, libvlc_time_t startMs) {
+    std::string u8 = ToUtf8(path);
+    libvlc_media_t* m = libvlc_media_new_path(g_vlc, u8.c_str());
+    if (mirrored) {
+        libvlc_media_add_option(m, ":video-filter=transform");
+        libvlc_media_add_option(m, ":transform-type=vflip");
+    }
+    if (startMs > 0) {
+        char opt[64];
+        sprintf_s(opt, ":start-time=%.3f", (double)startMs / 1000.0);
+        libvlc_media_add_option(m, opt);
+    }
+    libvlc_media_player_set_media(g_mp, m);
+    libvlc_media_release(m);
+    libvlc_media_player_play(g_mp);
+}
+
 static void PlayIndex(size_t idx) {
     if (!g_vlc) {
         const char* args[] = { g_vlcHwArgA.c_str(), "--no-video-title-show" };
@@ -3419,14 +7762,12 @@ static void PlayIndex(size_t idx) {
 
     g_playlistIndex = idx;
     g_lastLenForRange = -1;
+    SubmitFfmpegPlans(&g_playlist[g_playlistIndex]);   // edits of the file we left run now
+    KeyframeIndexRequest(g_playlist[g_playlistIndex]);  // seeks snap to keyframes once it is there
     SendMessageW(g_hwndSeek, TBM_SETRANGEMAX, TRUE, 0);
     SendMessageW(g_hwndSeek, TBM_SETPOS, TRUE, 0);
 
-    std::string u8 = ToUtf8(g_playlist[g_playlistIndex]);
-    libvlc_media_t* m = libvlc_media_new_path(g_vlc, u8.c_str());
-    libvlc_media_player_set_media(g_mp, m);
-    libvlc_media_release(m);
-    libvlc_media_player_play(g_mp);
+    PlayLoadMedia(g_playlist[g_playlistIndex], Mp4MirroredForPlayback(g_playlist[g_playlistIndex]), 0);
 }
 
 static void ToggleFullscreen() {
@@ -3459,76 +7800,149 @@ static void ToggleFullscreen() {
     }
 }
 
-static void FinalizeAllFfmpegTasks() {
-    // Move processed files up a directory and then delete video_process dirs.
-    std::vector<std::wstring> dirsToDelete;
+// ---- In-flight ffmpeg temps
+// ffmpeg writes next to the source, so a crash can leave temps in any folder. Their paths are
+// kept in <exe dir>\mediaexplorer.<pid>.fftemps while tasks exist, one list per running
+// instance; startup deletes the temps of lists whose process is gone (the original is never
+// touched, so an orphan is always safe to drop) and leaves other live instances' lists alone.
+static std::wstring FfTempListDir() {
+    wchar_t exePath[MAX_PATH] = {};
+    if (!GetModuleFileNameW(NULL, exePath, MAX_PATH)) return L"";
+    PathRemoveFileSpecW(exePath);
+    return std::wstring(exePath) + L"\\";
+}
+
+static std::wstring FfTempListPath() {
+    const std::wstring dir = FfTempListDir();
+    if (dir.empty()) return L"";
+    return dir + L"mediaexplorer." + std::to_wstring(GetCurrentProcessId()) + L".fftemps";
+}
+
+static bool ProcessIsRunning(DWORD pid) {
+    HANDLE h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!h) return GetLastError() == ERROR_ACCESS_DENIED; // exists, just not ours to query
+    DWORD code = 0;
+    const bool alive = GetExitCodeProcess(h, &code) && code == STILL_ACTIVE;
+    CloseHandle(h);
+    return alive;
+}
+
+// Rewrites the list from g_ffTasks and g_combineTasks (UI thread; empty list = file removed).
+static void FfTempListSave() {
+    const std::wstring path = FfTempListPath();
+    if (path.empty()) return;
+    std::string out;
+    EnterCriticalSection(&g_ffLock);
+    for (FfmpegTask* t : g_ffTasks) {
+        if (t && !t->outputTemp.empty()) out += ToUtf8(t->outputTemp) + "\n";
+        if (t && Mp4TrimSupportedExt(t->sourceFull)) out += ToUtf8(Mp4FlipJournalPath(t->sourceFull)) + "\n";
+    }
+    LeaveCriticalSection(&g_ffLock);
+    EnterCriticalSection(&g_combineLock);
+    for (CombineTask* t : g_combineTasks) {
+        if (t && !t->outputTemp.empty()) out += ToUtf8(t->outputTemp) + "\n";
+    }
+    LeaveCriticalSection(&g_combineLock);
+
+    if (out.empty()) { DeleteFileW(path.c_str()); return; }
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH, NULL);
+    if (h == INVALID_HANDLE_VALUE) return;
+    DWORD wrote = 0;
+    WriteFile(h, out.data(), (DWORD)out.size(), &wrote, NULL);
+    CloseHandle(h);
+}
 
+static void FfTempRecoverList(const std::wstring& path) {
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return;
+    std::string data;
+    char buf[4096];
+    DWORD got = 0;
+    while (ReadFile(h, buf, sizeof(buf), &got, NULL) && got > 0) data.append(buf, got);
+    CloseHandle(h);
+
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t nl = data.find('\n', pos);
+        if (nl == std::string::npos) nl = data.size();
+        const std::wstring temp = FromUtf8(data.substr(pos, nl - pos));
+        pos = nl + 1;
+        if (temp.empty() || GetFileAttributesW(temp.c_str()) == INVALID_FILE_ATTRIBUTES) continue;
+        if (temp.size() > 7 && _wcsicmp(temp.c_str() + temp.size() - 7, L".meflip") == 0) {
+            Mp4FlipJournalRestore(temp);    // an in-place flip was cut short: put the matrix back
+            continue;
+        }
+        const BOOL ok = DeleteFileW(temp.c_str());
+        LogLine(L"[FFmpeg] orphaned temp from an earlier run: \"%s\" %s", temp.c_str(), ok ? L"deleted" : L"NOT deleted");
+    }
+    DeleteFileW(path.c_str());
+}
+
+// Lists of instances that are still running belong to them (mediaexplorer.fftemps without a
+// pid is the old single list and always an orphan).
+static void FfTempRecoverOrphans() {
+    const std::wstring dir = FfTempListDir();
+    if (dir.empty()) return;
+    WIN32_FIND_DATAW fd{};
+    HANDLE h = FindFirstFileW((dir + L"mediaexplorer*.fftemps").c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE) return;
+    std::vector<std::wstring> orphans;
+    do {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        const DWORD pid = (DWORD)wcstoul(fd.cFileName + wcslen(L"mediaexplorer."), NULL, 10);
+        if (pid && (pid == GetCurrentProcessId() || ProcessIsRunning(pid))) continue;
+        orphans.push_back(dir + fd.cFileName);
+    } while (FindNextFileW(h, &fd));
+    FindClose(h);
+
+    for (const auto& path : orphans) FfTempRecoverList(path);
+}
+
+static void FinalizeAllFfmpegTasks() {
+    // Publish each result beside its source as "base (n).ext" with a same-directory rename
+    // (atomic, never overwrites); failed tasks have already dropped their temps.
     EnterCriticalSection(&g_ffLock);
     for (FfmpegTask* t : g_ffTasks) {
         if (!t) continue;
 
-        // If success and we have a finalWorking file, move it up one directory.
         if (t->exitCode == 0 && !t->finalWorking.empty()) {
-            std::wstring src = t->finalWorking;
-
-            // Parent directory is one level up from workingDir
-            std::wstring parent = t->workingDir;
-            if (!parent.empty() && (parent.back() == L'\\' || parent.back() == L'/')) parent.pop_back();
+            std::wstring parent = t->sourceFull;
             PathRemoveFileSpecW(&parent[0]);
             parent = parent.c_str();
             parent = EnsureSlash(parent);
 
-            const wchar_t* base = wcsrchr(src.c_str(), L'\\');
-            base = base ? base + 1 : src.c_str();
-
-            wchar_t fname[_MAX_FNAME] = {}, ext[_MAX_EXT] = {};
-            _wsplitpath_s(base, NULL, 0, NULL, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
+            std::wstring fname, ext;
+            SplitBaseExt(t->sourceFull, fname, ext);
 
-            std::wstring dst = UniqueName(parent, fname, ext);
-            MoveFileExW(src.c_str(), dst.c_str(),
-                MOVEFILE_COPY_ALLOWED | MOVEFILE_REPLACE_EXISTING);
+            BOOL moved = FALSE;
+            std::wstring dst;
+            for (int attempt = 0; !moved && attempt < 3; ++attempt) {
+                dst = UniqueName(parent, fname, ext);
+                moved = MoveFileExW(t->finalWorking.c_str(), dst.c_str(), 0);
+                if (!moved && GetLastError() != ERROR_ALREADY_EXISTS && GetLastError() != ERROR_FILE_EXISTS) break;
+            }
+            const DWORD err = moved ? 0 : GetLastError();
+            LogLine(L"FFmpegTask publish: \"%s\" -> \"%s\" %s err=%lu", t->finalWorking.c_str(), dst.c_str(),
+                moved ? L"OK" : L"FAILED", err);
         }
-
-        // Collect workingDir for later deletion
-        if (!t->workingDir.empty())
-            dirsToDelete.push_back(t->workingDir);
-    }
-    LeaveCriticalSection(&g_ffLock);
-
-    // Delete video_process directories (best-effort).
-    std::sort(dirsToDelete.begin(), dirsToDelete.end());
-    dirsToDelete.erase(std::unique(dirsToDelete.begin(), dirsToDelete.end()), dirsToDelete.end());
-
-    for (const auto& dir : dirsToDelete) {
-        std::wstring pattern = EnsureSlash(dir) + L"*";
-        WIN32_FIND_DATAW fd{};
-        HANDLE h = FindFirstFileW(pattern.c_str(), &fd);
-        if (h != INVALID_HANDLE_VALUE) {
-            do {
-                if (wcscmp(fd.cFileName, L".") == 0 || wcscmp(fd.cFileName, L"..") == 0) continue;
-                std::wstring full = EnsureSlash(dir) + fd.cFileName;
-                if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-                    // best effort, skip nested dirs for now
-                    continue;
-                }
-                DeleteFileW(full.c_str());
-            } while (FindNextFileW(h, &fd));
-            FindClose(h);
+        else if (!t->outputTemp.empty()) {
+            DeleteFileW(t->outputTemp.c_str());
         }
-        RemoveDirectoryW(dir.c_str());
     }
+    LeaveCriticalSection(&g_ffLock);
 
     // Clean up task objects
     EnterCriticalSection(&g_ffLock);
     for (FfmpegTask* t : g_ffTasks) {
         if (!t) continue;
         if (t->hProcess) CloseHandle(t->hProcess);
-        if (t->hThread) CloseHandle(t->hThread);
 //        if (t->hwnd && IsWindow(t->hwnd)) DestroyWindow(t->hwnd);
         delete t;
     }
     g_ffTasks.clear();
     LeaveCriticalSection(&g_ffLock);
+    FfTempListSave();
 }
 
 static void WaitForFfmpegTasksAndFinalize() {
@@ -3537,6 +7951,7 @@ static void WaitForFfmpegTasksAndFinalize() {
     bool anyTasks = !g_ffTasks.empty();
     LeaveCriticalSection(&g_ffLock);
     if (!anyTasks) return;
+    SubmitFfmpegPlans(nullptr);
 
     auto countRunning = []() -> int {
         int c = 0;
@@ -3568,7 +7983,7 @@ static void WaitForFfmpegTasksAndFinalize() {
         }
     }
 
-    // All tasks done; finalize (move outputs, delete video_process dirs, close windows)
+    // All tasks done; finalize (publish outputs, drop failed temps)
     FinalizeAllFfmpegTasks();
 }
 
@@ -3598,7 +8013,29 @@ static void ExitPlayback() {
     RECT rc; GetClientRect(g_hwndMain, &rc);
     MoveWindow(g_hwndList, 0, 0, rc.right, rc.bottom, TRUE);
 
+    // A finder scan that finished meanwhile: its groups, less the files deleted meanwhile (a
+    // group left with one file is no group)
+    FinderResultInPlayback finder;
+    std::swap(finder, g_finderResultInPlayback);
+    if (finder.have && !g_rowsDeletedInPlayback.empty()) {
+        std::unordered_map<std::wstring, bool> gone;
+        for (const auto& p : g_rowsDeletedInPlayback) gone[ToLower(p)] = true;
+        finder.rows.erase(std::remove_if(finder.rows.begin(), finder.rows.end(), [&](const Row& r) {
+            return gone.count(ToLower(r.full)) != 0;
+            }), finder.rows.end());
+        std::unordered_map<int, int> members;
+        for (const Row& r : finder.rows) ++members[r.groupId];
+        finder.rows.erase(std::remove_if(finder.rows.begin(), finder.rows.end(), [&](const Row& r) {
+            return members[r.groupId] < 2;
+            }), finder.rows.end());
+    }
+
+    if (!g_rowsDeletedInPlayback.empty()) {
+        RemoveRowsForPaths(g_rowsDeletedInPlayback);
+        g_rowsDeletedInPlayback.clear();
+    }
     ApplyPostActionsAndRefresh(hadFfmpegTasks);
+    if (finder.have) ShowGroupedResults(finder.rows, finder.label, finder.originView, finder.originFolder);
     SetTitleFolderOrDrives();
     LogLine(L"ExitPlayback finished");
     // NEW: bring back any log windows we hid when playback started
@@ -3818,9 +8255,7 @@ static HWND CreateCombineLogWindow(CombineTask* task) {
 }
 
 static void PostCombineOutput(CombineTask* task, const std::wstring& text) {
-    if (!task) return;
-    std::wstring* p = new std::wstring(text);
-    PostMessageW(g_hwndMain, WM_APP_COMBINE_OUTPUT, (WPARAM)task, (LPARAM)p);
+    JobPostOutput(JobKind::Combine, task, text);
 }
 
 // ----------------------------- File-op log window + background thread
@@ -3920,9 +8355,7 @@ static HWND CreateFileOpLogWindow(FileOpTask* task) {
 }
 
 static void PostFileOpOutput(FileOpTask* task, const std::wstring& text) {
-    if (!task) return;
-    std::wstring* p = new std::wstring(text);
-    PostMessageW(g_hwndMain, WM_APP_FILEOP_OUTPUT, (WPARAM)task, (LPARAM)p);
+    JobPostOutput(JobKind::FileOp, task, text);
 }
 
 // ---- FileOp status-bar-first helpers (place AFTER PostFileOpOutput)
@@ -3939,7 +8372,7 @@ static void FileOpAppendBuffer(FileOpTask* task, const std::wstring& text)
 }
 
 // Emit file-op text:
-// - If we have a window: route through WM_APP_FILEOP_OUTPUT (UI thread updates)
+// - If we have a window: route through WM_APP_JOB_OUTPUT (UI thread updates)
 // - If no window: buffer it so we can dump it if the task fails/cancels
 static void FileOpEmit(FileOpTask* task, const std::wstring& text)
 {
@@ -3957,20 +8390,58 @@ static void FileOpEmit(FileOpTask* task, const std::wstring& text)
     }
 }
 
-// Handle completion on the UI thread (called from WM_APP_FILEOP_DONE)
+// One playback-exit file op of batch gen finished: reload the folder when the last one is done.
+static void PlaybackExitBatchStep(uint32_t gen) {
+    if (gen == 0 || gen != g_pbExitBatchActive) return;
+    if (g_pbExitPending > 0) --g_pbExitPending;
+
+    if (g_pbExitPending <= 0 && g_pbExitWantsReload) {
+        if (!g_inPlayback &&
+            g_view == ViewKind::Folder &&
+            _wcsicmp(g_folder.c_str(), g_pbExitFolder.c_str()) == 0)
+        {
+            StartBackgroundFolderReload(g_pbExitFolder);
+        }
+
+        g_pbExitWantsReload = false;
+        g_pbExitBatchActive = 0;
+        g_pbExitPending = 0;
+        g_pbExitFolder.clear();
+    }
+}
+
+// A copy the playback-exit delete waits for is over (or never started). A failed copy keeps its
+// source: that file is dropped from the delete. The last one starts the delete.
+static void PlaybackExitDeleteRelease(FileOpTask* task, bool copied) {
+    PlaybackExitDelete* d = task->deleteAfter;
+    if (!d) return;
+    task->deleteAfter = nullptr;
+    if (!copied) {
+        d->files.erase(std::remove_if(d->files.begin(), d->files.end(), [&](const std::wstring& f) {
+            return _wcsicmp(f.c_str(), task->srcSingle.c_str()) == 0;
+            }), d->files.end());
+        LogLine(L"[PostAction] copy of \"%s\" failed; the file is not deleted", task->srcSingle.c_str());
+    }
+    if (--d->copiesLeft > 0) return;
+    if (!d->files.empty()) ScheduleDeleteFilesAsync(d->files, DeleteBatchTitle(d->files), true, d->gen);
+    else PlaybackExitBatchStep(d->gen); // the delete was counted in the batch
+    delete d;
+}
+
+// Handle completion on the UI thread (called from WM_APP_JOB_DONE)
 static void OnFileOpDone(FileOpTask* task, DWORD rc)
 {
     if (!task) return;
 
-    // Close thread handle
-    if (task->hThread) {
-        CloseHandle(task->hThread);
-        task->hThread = NULL;
-    }
+    // A bulk delete waiting for this copy may start now
+    PlaybackExitDeleteRelease(task, rc == 0);
 
     const bool isPlaybackExitTask = task->fromPlaybackExit;
     const uint32_t gen = task->playbackExitGen;
 
+    // Free this task's device slots (queued tasks are started at the end)
+    IoRelease(task);
+
     // End status-bar op
     if (task->statusId) {
         StatusOpEnd(task->statusId);
@@ -3991,66 +8462,507 @@ static void OnFileOpDone(FileOpTask* task, DWORD rc)
         }
         if (task->hCancel) EnableWindow(task->hCancel, FALSE);
 
-        if (wnd) {
-            ShowWindow(wnd, SW_SHOWNOACTIVATE);
-            SetWindowPos(wnd, HWND_TOP, 0, 0, 0, 0,
-                SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+        if (wnd) {
+            ShowWindow(wnd, SW_SHOWNOACTIVATE);
+            SetWindowPos(wnd, HWND_TOP, 0, 0, 0, 0,
+                SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+        }
+    }
+
+    // Finder tasks: show their groups (the task is deleted just below)
+    const bool isFinderTask = (task->kind == FileOpKind::FindSimilar || task->kind == FileOpKind::FindDuplicates);
+    if (isFinderTask && rc == 0 && !g_inPlayback) {
+        ShowGroupedResults(task->resultRows, task->resultLabel, task->scanOriginView, task->scanOriginFolder);
+    }
+    else if (isFinderTask && rc == 0) {
+        // The list is hidden behind the video: keep the groups for ExitPlayback
+        FinderResultInPlayback& r = g_finderResultInPlayback;
+        r.have = true;
+        r.rows = std::move(task->resultRows);
+        r.label = task->resultLabel;
+        r.originView = task->scanOriginView;
+        r.originFolder = task->scanOriginFolder;
+    }
+
+    // Deletes: drop the removed rows directly, even on partial failure (after playback if it is
+    // running: the playlist and the hidden list still index g_rows)
+    const bool isDeleteTask = (task->kind == FileOpKind::DeleteFiles);
+    if (isDeleteTask && !g_inPlayback) {
+        RemoveRowsForPaths(task->deleted);
+    }
+    else if (isDeleteTask) {
+        g_rowsDeletedInPlayback.insert(g_rowsDeletedInPlayback.end(), task->deleted.begin(), task->deleted.end());
+    }
+
+    // Auto-close on success (and delete task)
+    if (rc == 0) {
+        if (task->hwnd && IsWindow(task->hwnd)) {
+            DestroyWindow(task->hwnd);
+        }
+        task->hwnd = NULL;
+        task->hEdit = NULL;
+        task->hCancel = NULL;
+
+        EnterCriticalSection(&g_fileLock);
+        auto it = std::find(g_fileTasks.begin(), g_fileTasks.end(), task);
+        if (it != g_fileTasks.end()) g_fileTasks.erase(it);
+        LeaveCriticalSection(&g_fileLock);
+
+        delete task;
+        task = nullptr;
+    }
+
+    // Playback-exit batch countdown logic (your existing behavior)
+    if (isPlaybackExitTask) PlaybackExitBatchStep(gen);
+
+    // Normal tasks refresh the view when not in playback
+    if (!g_inPlayback && !isPlaybackExitTask && !isFinderTask && !isDeleteTask) {
+        RefreshCurrentView();
+    }
+
+    IoSchedPump();
+}
+
+static int FinderWorkerCount() {
+    SYSTEM_INFO si{};
+    GetSystemInfo(&si);
+    int n = (int)si.dwNumberOfProcessors;
+    return n < 1 ? 1 : (n > 8 ? 8 : n);
+}
+
+// Finder results become Search-view rows: full path as the name, cached props, set number.
+static Row FinderRowFromScan(const ScanFile& f, int groupId) {
+    Row r;
+    r.name = f.path;
+    r.full = f.path;
+    r.isDir = false;
+    r.size = f.size;
+    r.modified.dwLowDateTime = (DWORD)(f.mtime & 0xFFFFFFFFull);
+    r.modified.dwHighDateTime = (DWORD)(f.mtime >> 32);
+    if (!MetaCacheFillRow(r))
+        GetVideoPropsFastCached(r.full, r.vW, r.vH, r.vDur100ns);
+    r.groupId = groupId;
+    return r;
+}
+
+struct UnionFind {
+    std::vector<uint32_t> parent;
+    explicit UnionFind(size_t n) : parent(n) { for (size_t i = 0; i < n; ++i) parent[i] = (uint32_t)i; }
+    uint32_t Find(uint32_t x) {
+        while (parent[x] != x) { parent[x] = parent[parent[x]]; x = parent[x]; }
+        return x;
+    }
+    void Unite(uint32_t a, uint32_t b) {
+        a = Find(a); b = Find(b);
+        if (a != b) parent[a < b ? b : a] = (a < b ? a : b);
+    }
+};
+
+// Turns a union-find over 'files' into numbered sets (largest file first), one Row per member.
+static void FinderEmitGroups(const std::vector<ScanFile>& files, UnionFind& uf, std::vector<Row>& outRows,
+    size_t& outSets)
+{
+    std::unordered_map<uint32_t, std::vector<uint32_t>> byRoot;
+    for (uint32_t i = 0; i < (uint32_t)files.size(); ++i) byRoot[uf.Find(i)].push_back(i);
+
+    std::vector<std::vector<uint32_t>> groups;
+    for (auto& kv : byRoot) if (kv.second.size() > 1) groups.push_back(std::move(kv.second));
+
+    auto groupMax = [&](const std::vector<uint32_t>& g) {
+        ULONGLONG m = 0;
+        for (uint32_t i : g) if (files[i].size > m) m = files[i].size;
+        return m;
+    };
+    std::sort(groups.begin(), groups.end(), [&](const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        ULONGLONG ma = groupMax(a), mb = groupMax(b);
+        if (ma != mb) return ma > mb;
+        return a.front() < b.front();
+    });
+
+    outRows.clear();
+    for (size_t g = 0; g < groups.size(); ++g) {
+        for (uint32_t i : groups[g]) outRows.push_back(FinderRowFromScan(files[i], (int)g + 1));
+    }
+    outSets = groups.size();
+}
+
+// ----------------------------- Similar-video finder (NEW)
+// Perceptual fingerprint = 64-bit difference hashes (dHash) of scene-anchored keyframes, in
+// order: the first keyframe plus every keyframe that opens a new scene. Anchors come from the
+// content, not from positions in the file, so a trimmed copy keeps the anchors of the part it
+// contains (encoders put keyframes on scene cuts, so re-encodes keep them too). Re-encodes,
+// rescales and small crops keep most bits; flat (black/solid) frames are stored as 0 and ignored.
+static constexpr size_t kFpMaxAnchors = 96;  // keep the strongest cuts beyond this
+static constexpr int kFpSceneDelta = 24;     // mean |pixel delta| vs previous keyframe = new scene
+static constexpr int kFpMaxDistance = 8;     // Hamming distance for "same frame"
+static constexpr size_t kFpBucketMax = 256;  // skip chunk buckets this crowded (static logos etc.)
+
+static void MetaCacheSetFingerprint(const std::wstring& path, ULONGLONG size, ULONGLONG mtime,
+    const std::vector<ULONGLONG>& fp)
+{
+    EnterCriticalSection(&g_metaCacheLock);
+    MetaCacheEntry& slot = g_metaCache[ToLower(path)];
+    if (slot.size != size || slot.mtime != mtime) {
+        slot = MetaCacheEntry();
+        slot.size = size;
+        slot.mtime = mtime;
+    }
+    slot.fingerprint = fp;
+    g_metaCacheDirty = true;
+    LeaveCriticalSection(&g_metaCacheLock);
+}
+
+// 9x8 grayscale -> 64 bits: each bit is "pixel brighter than its right neighbour".
+static ULONGLONG DHashFromGray9x8(const BYTE* px) {
+    BYTE lo = 255, hi = 0;
+    for (int i = 0; i < 72; ++i) { if (px[i] < lo) lo = px[i]; if (px[i] > hi) hi = px[i]; }
+    if (hi - lo < 8) return 0; // flat frame
+
+    ULONGLONG h = 0;
+    for (int y = 0; y < 8; ++y)
+        for (int x = 0; x < 8; ++x)
+            h = (h << 1) | (px[y * 9 + x] > px[y * 9 + x + 1] ? 1u : 0u);
+    return h ? h : 1;
+}
+
+// One ffmpeg per file: the decoder skips non-keyframes and ffmpeg downsizes to 9x8 gray itself,
+// so only 72 bytes per keyframe cross the pipe. rawvideo is written at a constant rate; -r 2
+// bounds that, and the repeated frames it adds between keyframes show no change and never anchor.
+static bool ComputeVideoFingerprint(const std::wstring& path, std::vector<ULONGLONG>& out) {
+    out.clear();
+    std::wstring cmd = QuoteArg(g_ffmpegExeW) + L" -v error -nostdin -skip_frame nokey -i \"";
+    cmd += path;
+    cmd += L"\" -map 0:v:0 -an -sn -vf \"scale=9:8:flags=area,format=gray\" -r 2 -f rawvideo pipe:1";
+
+    std::string raw;
+    RunHiddenCaptureStdout(cmd, raw);
+    const size_t frames = raw.size() / 72;
+    if (frames == 0) return false;
+
+    struct Anchor { int delta; size_t at; ULONGLONG hash; };
+    const BYTE* px = (const BYTE*)raw.data();
+    std::vector<Anchor> anchors;
+    anchors.push_back({ INT_MAX, 0, DHashFromGray9x8(px) });
+    for (size_t i = 1; i < frames; ++i) {
+        const BYTE* cur = px + i * 72;
+        const BYTE* prev = cur - 72;
+        int sum = 0;
+        for (int k = 0; k < 72; ++k) sum += std::abs((int)cur[k] - (int)prev[k]);
+        if (sum / 72 >= kFpSceneDelta) anchors.push_back({ sum / 72, i, DHashFromGray9x8(cur) });
+    }
+
+    // Strength of a cut depends only on the frames around it, so copies thin out the same way.
+    if (anchors.size() > kFpMaxAnchors) {
+        std::nth_element(anchors.begin(), anchors.begin() + kFpMaxAnchors, anchors.end(),
+            [](const Anchor& a, const Anchor& b) { return a.delta > b.delta; });
+        anchors.resize(kFpMaxAnchors);
+        std::sort(anchors.begin(), anchors.end(), [](const Anchor& a, const Anchor& b) { return a.at < b.at; });
+    }
+
+    out.reserve(anchors.size());
+    for (const Anchor& a : anchors) out.push_back(a.hash);
+    return true;
+}
+
+static inline int HammingDistance64(ULONGLONG a, ULONGLONG b) {
+    return (int)std::bitset<64>(a ^ b).count();
+}
+
+// Longest common subsequence of two anchor sequences, "equal" meaning within kFpMaxDistance.
+// Order must agree but the offset is free, so a trimmed copy lines up with its source.
+static int FingerprintCommonAnchors(const std::vector<ULONGLONG>& a, const std::vector<ULONGLONG>& b) {
+    std::vector<int> prev(b.size() + 1, 0), cur(b.size() + 1, 0);
+    for (size_t i = 0; i < a.size(); ++i) {
+        for (size_t j = 0; j < b.size(); ++j) {
+            if (a[i] && b[j] && HammingDistance64(a[i], b[j]) <= kFpMaxDistance)
+                cur[j + 1] = prev[j] + 1;
+            else
+                cur[j + 1] = std::max(prev[j + 1], cur[j]);
+        }
+        prev.swap(cur);
+    }
+    return prev[b.size()];
+}
+
+static DWORD RunFindSimilar(FileOpTask* task) {
+    std::vector<ScanFile> files;
+    if (task->statusId) StatusOpUpdate(task->statusId, L"Find similar: scanning...");
+    ScanScope(task->scanFolders, task->scanFiles, files, task->cancel);
+    if (task->cancel.load()) return ERROR_CANCELLED;
+
+    {
+        wchar_t buf[128];
+        swprintf_s(buf, L"Scanned %zu video file(s)\r\n", files.size());
+        FileOpEmit(task, buf);
+    }
+
+    // 1) Fingerprints: cache hits are free, misses run in parallel.
+    std::vector<std::vector<ULONGLONG>> fps(files.size());
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < files.size(); ++i) {
+        MetaCacheEntry e;
+        if (MetaCacheLookup(files[i].path, files[i].size, files[i].mtime, e) && !e.fingerprint.empty())
+            fps[i] = e.fingerprint;
+        else
+            missing.push_back(i);
+    }
+
+    std::atomic<size_t> doneCount{ 0 };
+    std::atomic<DWORD> lastTick{ 0 };
+    ParallelFor(missing.size(), FinderWorkerCount(), [&](size_t k) {
+        const ScanFile& f = files[missing[k]];
+        std::vector<ULONGLONG> fp;
+        if (ComputeVideoFingerprint(f.path, fp)) {
+            MetaCacheSetFingerprint(f.path, f.size, f.mtime, fp);
+            fps[missing[k]].swap(fp);
+        }
+
+        size_t n = doneCount.fetch_add(1) + 1;
+        DWORD now = GetTickCount();
+        DWORD prev = lastTick.load();
+        if (task->statusId && now - prev >= 250 && lastTick.compare_exchange_strong(prev, now)) {
+            wchar_t buf[128];
+            swprintf_s(buf, L"Find similar: fingerprint %zu/%zu", n, missing.size());
+            StatusOpUpdate(task->statusId, buf);
+        }
+    }, task->cancel);
+    if (task->cancel.load()) return ERROR_CANCELLED;
+
+    {
+        wchar_t buf[128];
+        swprintf_s(buf, L"Fingerprinted %zu file(s), %zu from cache\r\n", missing.size(), files.size() - missing.size());
+        FileOpEmit(task, buf);
+    }
+    if (task->statusId) StatusOpUpdate(task->statusId, L"Find similar: grouping...");
+
+    // 2) Multi-index hashing: two hashes within distance 3 share at least one exact 16-bit
+    //    chunk, so candidate pairs come from chunk buckets instead of an all-pairs compare.
+    //    A pair needs at least one anchor within kFpMaxDistance to become a candidate.
+    std::unordered_map<uint32_t, std::vector<uint32_t>> buckets; // (chunk<<16 | value) -> file*kFpMaxAnchors+anchor
+    std::vector<int> valid(files.size(), 0);
+    for (uint32_t i = 0; i < (uint32_t)files.size(); ++i) {
+        for (size_t f = 0; f < fps[i].size() && f < kFpMaxAnchors; ++f) {
+            ULONGLONG h = fps[i][f];
+            if (!h) continue;
+            ++valid[i];
+            for (uint32_t c = 0; c < 4; ++c)
+                buckets[(c << 16) | (uint32_t)((h >> (16 * c)) & 0xFFFF)].push_back(i * (uint32_t)kFpMaxAnchors + (uint32_t)f);
+        }
+    }
+
+    std::unordered_map<ULONGLONG, bool> pairs; // (lo<<32 | hi)
+    for (const auto& kv : buckets) {
+        const std::vector<uint32_t>& v = kv.second;
+        if (v.size() < 2 || v.size() > kFpBucketMax) continue;
+        for (size_t a = 0; a < v.size(); ++a) {
+            for (size_t b = a + 1; b < v.size(); ++b) {
+                uint32_t fa = v[a] / (uint32_t)kFpMaxAnchors, fb = v[b] / (uint32_t)kFpMaxAnchors;
+                if (fa == fb) continue;
+                if (HammingDistance64(fps[fa][v[a] % kFpMaxAnchors], fps[fb][v[b] % kFpMaxAnchors]) > kFpMaxDistance) continue;
+                if (fa > fb) std::swap(fa, fb);
+                pairs[((ULONGLONG)fa << 32) | fb] = true;
+            }
+        }
+        if (task->cancel.load(std::memory_order_relaxed)) return ERROR_CANCELLED;
+    }
+
+    // 3) Two files are "similar" when at least half of the shorter anchor sequence lines up
+    //    in order (min 2 anchors), whatever the offset between them.
+    UnionFind uf(files.size());
+    for (const auto& kv : pairs) {
+        uint32_t fa = (uint32_t)(kv.first >> 32), fb = (uint32_t)(kv.first & 0xFFFFFFFFu);
+        int need = (std::min(valid[fa], valid[fb]) + 1) / 2;
+        if (need < 2) need = 2;
+        if (FingerprintCommonAnchors(fps[fa], fps[fb]) >= need) uf.Unite(fa, fb);
+        if (task->cancel.load(std::memory_order_relaxed)) return ERROR_CANCELLED;
+    }
+
+    size_t sets = 0;
+    FinderEmitGroups(files, uf, task->resultRows, sets);
+
+    wchar_t label[96];
+    swprintf_s(label, L"Similar videos - %zu set(s)", sets);
+    task->resultLabel = label;
+    FileOpEmit(task, task->resultLabel + L"\r\n");
+    return 0;
+}
+
+// ----------------------------- Duplicate finder (NEW)
+// Exact duplicates: size buckets -> partial SHA-256 (size + first/middle/last block) -> full
+// SHA-256 only for files that still collide. Both hashes live in the metadata cache, keyed by
+// path + size + mtime like everything else there.
+static constexpr DWORD kDupBlock = 64 * 1024;          // partial-hash block
+static constexpr DWORD kDupReadChunk = 4 * 1024 * 1024; // full-hash sequential read size
+
+static void MetaCacheSetHashes(const std::wstring& path, ULONGLONG size, ULONGLONG mtime,
+    const std::string& partialHash, const std::string& fullHash)
+{
+    EnterCriticalSection(&g_metaCacheLock);
+    MetaCacheEntry& slot = g_metaCache[ToLower(path)];
+    if (slot.size != size || slot.mtime != mtime) {
+        slot = MetaCacheEntry();
+        slot.size = size;
+        slot.mtime = mtime;
+    }
+    if (!partialHash.empty()) slot.partialHash = partialHash;
+    if (!fullHash.empty()) slot.fullHash = fullHash;
+    g_metaCacheDirty = true;
+    LeaveCriticalSection(&g_metaCacheLock);
+}
+
+// partial=true: SHA-256 over (size, first block, middle block, last block); files no larger
+// than three blocks are hashed whole, so their partial hash is already the full hash.
+static bool HashFileSha256(const std::wstring& path, ULONGLONG size, bool partial, std::string& outHex,
+    const std::atomic<bool>& cancel)
+{
+    outHex.clear();
+    HANDLE f = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, partial ? FILE_ATTRIBUTE_NORMAL : FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+
+    Sha256Ctx sha;
+    bool ok = Sha256Begin(sha);
+
+    if (ok && partial && size > 3ULL * kDupBlock) {
+        std::vector<BYTE> buf(kDupBlock);
+        ULONGLONG sz = size;
+        ok = Sha256Update(sha, &sz, sizeof(sz));
+        const ULONGLONG offs[3] = { 0, size / 2 - kDupBlock / 2, size - kDupBlock };
+        for (int i = 0; ok && i < 3; ++i) {
+            ok = ReadExactAt(f, offs[i], buf.data(), kDupBlock) &&
+                Sha256Update(sha, buf.data(), kDupBlock);
+        }
+    }
+    else if (ok) {
+        std::vector<BYTE> buf(partial ? kDupBlock * 3 : kDupReadChunk);
+        ULONGLONG total = 0;
+        DWORD got = 0;
+        for (;;) {
+            if (cancel.load(std::memory_order_relaxed)) { ok = false; break; }
+            if (!ReadFile(f, buf.data(), (DWORD)buf.size(), &got, NULL)) { ok = false; break; }
+            if (got == 0) break;
+            total += got;
+            if (!Sha256Update(sha, buf.data(), got)) { ok = false; break; }
         }
+        if (ok && total != size) ok = false; // file changed under us
     }
 
-    // Auto-close on success (and delete task)
-    if (rc == 0) {
-        if (task->hwnd && IsWindow(task->hwnd)) {
-            DestroyWindow(task->hwnd);
+    ok = Sha256End(sha, ok ? &outHex : nullptr) && ok;
+    CloseHandle(f);
+    return ok;
+}
+
+// Keeps only members of 'idx' whose key collides with another member (key empty = unreadable).
+static void KeepCollidingByKey(std::vector<size_t>& idx, const std::vector<std::string>& key) {
+    std::unordered_map<std::string, int> count;
+    for (size_t i : idx) if (!key[i].empty()) ++count[key[i]];
+    std::vector<size_t> out;
+    for (size_t i : idx) if (!key[i].empty() && count[key[i]] > 1) out.push_back(i);
+    idx.swap(out);
+}
+
+// Hashes files[idx] (partial or full) in parallel; cache hits skip the read entirely.
+static void DupHashPass(FileOpTask* task, const std::vector<ScanFile>& files, const std::vector<size_t>& idx,
+    bool partial, std::vector<std::string>& key)
+{
+    std::vector<size_t> todo;
+    for (size_t i : idx) {
+        MetaCacheEntry e;
+        if (MetaCacheLookup(files[i].path, files[i].size, files[i].mtime, e)) {
+            const std::string& cached = partial ? e.partialHash : e.fullHash;
+            if (!cached.empty()) { key[i] = cached; continue; }
+        }
+        todo.push_back(i);
+    }
+
+    std::atomic<size_t> doneCount{ 0 };
+    std::atomic<DWORD> lastTick{ 0 };
+    ParallelFor(todo.size(), FinderWorkerCount(), [&](size_t k) {
+        const ScanFile& f = files[todo[k]];
+        std::string hex;
+        if (HashFileSha256(f.path, f.size, partial, hex, task->cancel)) {
+            // small files: the partial hash covered everything
+            const bool whole = f.size <= 3ULL * kDupBlock;
+            MetaCacheSetHashes(f.path, f.size, f.mtime, partial ? hex : std::string(),
+                (!partial || whole) ? hex : std::string());
+            key[todo[k]] = hex;
+        }
+
+        size_t n = doneCount.fetch_add(1) + 1;
+        DWORD now = GetTickCount();
+        DWORD prev = lastTick.load();
+        if (task->statusId && now - prev >= 250 && lastTick.compare_exchange_strong(prev, now)) {
+            wchar_t buf[128];
+            swprintf_s(buf, L"Find duplicates: %s hash %zu/%zu", partial ? L"partial" : L"full", n, todo.size());
+            StatusOpUpdate(task->statusId, buf);
         }
-        task->hwnd = NULL;
-        task->hEdit = NULL;
-        task->hCancel = NULL;
+    }, task->cancel);
 
-        EnterCriticalSection(&g_fileLock);
-        auto it = std::find(g_fileTasks.begin(), g_fileTasks.end(), task);
-        if (it != g_fileTasks.end()) g_fileTasks.erase(it);
-        LeaveCriticalSection(&g_fileLock);
+    wchar_t buf[128];
+    swprintf_s(buf, L"%s hash: %zu file(s), %zu from cache\r\n", partial ? L"Partial" : L"Full",
+        idx.size(), idx.size() - todo.size());
+    FileOpEmit(task, buf);
+}
 
-        delete task;
-        task = nullptr;
+static DWORD RunFindDuplicates(FileOpTask* task) {
+    std::vector<ScanFile> files;
+    if (task->statusId) StatusOpUpdate(task->statusId, L"Find duplicates: scanning...");
+    ScanScope(task->scanFolders, task->scanFiles, files, task->cancel);
+    if (task->cancel.load()) return ERROR_CANCELLED;
+
+    // 1) Size buckets: a unique size cannot have a duplicate. Empty files are ignored.
+    std::unordered_map<ULONGLONG, int> bySize;
+    for (const auto& f : files) if (f.size) ++bySize[f.size];
+    std::vector<size_t> cand;
+    for (size_t i = 0; i < files.size(); ++i)
+        if (files[i].size && bySize[files[i].size] > 1) cand.push_back(i);
+
+    {
+        wchar_t buf[160];
+        swprintf_s(buf, L"Scanned %zu video file(s), %zu share a size\r\n", files.size(), cand.size());
+        FileOpEmit(task, buf);
     }
 
-    // Playback-exit batch countdown logic (your existing behavior)
-    if (isPlaybackExitTask && gen != 0 && gen == g_pbExitBatchActive) {
-        if (g_pbExitPending > 0) --g_pbExitPending;
+    // 2) Partial hash (size is part of the hashed data, so equal hashes imply equal size).
+    std::vector<std::string> partialKey(files.size()), fullKey(files.size());
+    DupHashPass(task, files, cand, true, partialKey);
+    if (task->cancel.load()) return ERROR_CANCELLED;
+    KeepCollidingByKey(cand, partialKey);
 
-        if (g_pbExitPending <= 0 && g_pbExitWantsReload) {
-            if (!g_inPlayback &&
-                g_view == ViewKind::Folder &&
-                _wcsicmp(g_folder.c_str(), g_pbExitFolder.c_str()) == 0)
-            {
-                StartBackgroundFolderReload(g_pbExitFolder);
-            }
+    // 3) Full hash for large files that still collide; small ones were hashed whole already.
+    std::vector<size_t> large;
+    for (size_t i : cand) {
+        if (files[i].size <= 3ULL * kDupBlock) fullKey[i] = partialKey[i];
+        else large.push_back(i);
+    }
+    DupHashPass(task, files, large, false, fullKey);
+    if (task->cancel.load()) return ERROR_CANCELLED;
+    KeepCollidingByKey(cand, fullKey);
 
-            g_pbExitWantsReload = false;
-            g_pbExitBatchActive = 0;
-            g_pbExitPending = 0;
-            g_pbExitFolder.clear();
+    UnionFind uf(files.size());
+    std::unordered_map<std::string, uint32_t> firstOf;
+    ULONGLONG reclaimable = 0;
+    for (size_t i : cand) {
+        auto ins = firstOf.emplace(fullKey[i], (uint32_t)i);
+        if (!ins.second) {
+            uf.Unite(ins.first->second, (uint32_t)i);
+            reclaimable += files[i].size;
         }
     }
 
-    // Normal tasks refresh the view when not in playback
-    if (!g_inPlayback && !isPlaybackExitTask) {
-        RefreshCurrentView();
-    }
-}
+    size_t sets = 0;
+    FinderEmitGroups(files, uf, task->resultRows, sets);
 
-static DWORD CALLBACK FileOpCopyProgressThunk(
-    LARGE_INTEGER, LARGE_INTEGER, LARGE_INTEGER, LARGE_INTEGER,
-    DWORD, DWORD, HANDLE, HANDLE, LPVOID lpData)
-{
-    FileOpTask* task = (FileOpTask*)lpData;
-    if (task && task->cancel.load(std::memory_order_relaxed)) return PROGRESS_CANCEL;
-    return PROGRESS_CONTINUE;
+    wchar_t label[128];
+    swprintf_s(label, L"Duplicate files - %zu set(s), %s reclaimable", sets, FormatSize(reclaimable).c_str());
+    task->resultLabel = label;
+    FileOpEmit(task, task->resultLabel + L"\r\n");
+    return 0;
 }
 
-static DWORD WINAPI FileOpThreadProc(LPVOID param) {
+static constexpr int kDeletesInFlight = 8;   // concurrent unlinks per delete task
+
+static DWORD WINAPI FileOpJobProc(LPVOID param) {
     FileOpTask* task = (FileOpTask*)param;
     if (!task) return 0;
 
@@ -4063,26 +8975,32 @@ static DWORD WINAPI FileOpThreadProc(LPVOID param) {
         const bool isCopy = (task->clipMode == ClipMode::Copy);
         const size_t total = task->srcFiles.size();
 
+        // 1) Plan every destination. 2) Same-volume moves are pure renames, all done in one
+        // quick pass before any data moves. 3) Everything else streams through the copy engine;
+        // for moves, each source is handed to the delete lane as soon as its copy completes.
+        struct PlannedRename { std::wstring src, dst; };
+        std::vector<PlannedRename> renames;
+        std::vector<CopyJob> jobs;
+        NamePlan np;
+        NamePlanBegin(np, task->dstFolder);
+        std::unordered_map<std::wstring, bool> resumed;
         for (size_t i = 0; i < total; ++i) {
             if (task->cancel.load(std::memory_order_relaxed)) { rc = ERROR_CANCELLED; break; }
 
             const std::wstring& src = task->srcFiles[i];
-            const wchar_t* base = wcsrchr(src.c_str(), L'\\'); base = base ? base + 1 : src.c_str();
-
-            if (task->statusId) {
-                std::wstring st = (isCopy ? L"Copy " : L"Move ");
-                st += std::to_wstring(i + 1);
-                st += L"/";
-                st += std::to_wstring(total);
-                st += L": ";
-                st += base;
-                StatusOpUpdate(task->statusId, st);
-            }
-
-            wchar_t fname[_MAX_FNAME] = {}, ext[_MAX_EXT] = {};
-            _wsplitpath_s(base, NULL, 0, NULL, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
-
-            std::wstring dst = UniqueName(task->dstFolder, fname, ext);
+            std::wstring fname, ext;
+            SplitBaseExt(src, fname, ext);
+
+            // An interrupted copy of this very file (its .partial + .mecopy, the final name still
+            // free) continues under that name; a finished file there is never overwritten
+            std::wstring dst = task->dstFolder + fname + ext;
+            CopyJournal pending;
+            const bool resume = NamePlanIsFree(np, fname + ext) &&
+                GetFileAttributesW(CopyPartialPath(dst).c_str()) != INVALID_FILE_ATTRIBUTES &&
+                CopyJournalRead(dst, pending) && _wcsicmp(pending.src.c_str(), src.c_str()) == 0 &&
+                resumed.emplace(ToLower(dst), true).second;
+            if (resume) NamePlanMark(np, fname + ext);
+            else dst = NamePlanTake(np, fname, ext);
 
             {
                 wchar_t hdr[256];
@@ -4090,90 +9008,177 @@ static DWORD WINAPI FileOpThreadProc(LPVOID param) {
                     isCopy ? L"Copying" : L"Moving", i + 1, total);
                 FileOpEmit(task, hdr);
                 FileOpEmit(task, L"  From: " + src + L"\r\n");
-                FileOpEmit(task, L"  To  : " + dst + L"\r\n");
+                FileOpEmit(task, L"  To  : " + dst + (resume ? L" (resuming)\r\n" : L"\r\n"));
             }
 
-            BOOL ok = FALSE;
-            DWORD err = 0;
-
-            if (isCopy) {
-                BOOL cancelFlag = FALSE;
-                ok = CopyFileExW(src.c_str(), dst.c_str(),
-                    FileOpCopyProgressThunk, task, &cancelFlag, 0);
-                if (!ok) err = GetLastError();
-                if (cancelFlag || task->cancel.load()) { rc = ERROR_CANCELLED; break; }
-            }
-            else {
-                if (SameVolume(src, dst)) {
-                    ok = MoveFileExW(src.c_str(), dst.c_str(), MOVEFILE_REPLACE_EXISTING);
-                    if (!ok) err = GetLastError();
-                }
-                else {
-                    BOOL cancelFlag = FALSE;
-                    ok = CopyFileExW(src.c_str(), dst.c_str(),
-                        FileOpCopyProgressThunk, task, &cancelFlag, 0);
-                    if (!ok) err = GetLastError();
-                    if (cancelFlag || task->cancel.load()) { rc = ERROR_CANCELLED; break; }
-
-                    if (ok) {
-                        if (!DeleteFileW(src.c_str())) {
-                            MoveFileExW(src.c_str(), NULL, MOVEFILE_DELAY_UNTIL_REBOOT);
-                        }
-                    }
-                    else {
-                        DeleteFileW(dst.c_str());
-                    }
-                }
+            if (!isCopy && SameVolume(src, dst)) {
+                renames.push_back({ src, dst });
+                continue;
             }
 
-            if (!ok) {
+            CopyJob job;
+            job.src = src;
+            job.dst = dst;
+            job.createNew = true;   // resumed or not, the final name must still be free at the rename
+            jobs.push_back(std::move(job));
+        }
+        FileOpEmit(task, L"\r\n");
+
+        // Another name for a planned destination that turned out to exist at create time
+        auto replan = [&](std::wstring& dst, const std::wstring& src) {
+            const wchar_t* taken = wcsrchr(dst.c_str(), L'\\');
+            NamePlanMark(np, taken ? taken + 1 : dst);
+            std::wstring fname, ext;
+            SplitBaseExt(src, fname, ext);
+            dst = NamePlanTake(np, fname, ext);
+            FileOpEmit(task, L"Name taken meanwhile, using: " + dst + L"\r\n");
+        };
+
+        for (size_t i = 0; rc == 0 && i < renames.size(); ++i) {
+            if (task->cancel.load(std::memory_order_relaxed)) { rc = ERROR_CANCELLED; break; }
+            PlannedRename& r = renames[i];
+            BOOL moved = MoveFileExW(r.src.c_str(), r.dst.c_str(), 0);
+            for (int retry = 0; !moved && retry < 3 &&
+                (GetLastError() == ERROR_ALREADY_EXISTS || GetLastError() == ERROR_FILE_EXISTS); ++retry) {
+                replan(r.dst, r.src);
+                moved = MoveFileExW(r.src.c_str(), r.dst.c_str(), 0);
+            }
+            if (!moved) {
+                DWORD err = GetLastError();
                 wchar_t buf[256];
-                swprintf_s(buf, L"ERROR: operation failed (err=%lu)\r\n\r\n", err);
-                FileOpEmit(task, buf);
+                swprintf_s(buf, L"ERROR: operation failed (err=%lu): ", err);
+                FileOpEmit(task, buf + r.src + L"\r\n\r\n");
                 rc = (err ? err : 1);
                 break;
             }
+            FileOpEmit(task, L"OK (renamed): " + r.dst + L"\r\n");
+        }
+
+        if (rc == 0 && !jobs.empty()) {
+            CopyProgress prog;
+            prog.cancel = &task->cancel;
+            const uint64_t statusId = task->statusId;
+            size_t nJobs = jobs.size(); // files in the batch now running (collision retries are smaller)
+            prog.onProgress = [statusId, isCopy, &nJobs](ULONGLONG done, ULONGLONG totalBytes) {
+                if (!statusId) return;
+                wchar_t buf[160];
+                swprintf_s(buf, L"%s %zu file(s): %s of %s (%d%%)", isCopy ? L"Copy" : L"Move", nJobs,
+                    FormatSize(done).c_str(), FormatSize(totalBytes).c_str(),
+                    totalBytes ? (int)(done * 100 / totalBytes) : 100);
+                StatusOpUpdate(statusId, buf);
+                StatusOpBytes(statusId, done, totalBytes);
+            };
+
+            DeleteLane lane;
+            if (!isCopy) {
+                DeleteLaneStart(lane);
+                prog.onFileDone = [&lane](const CopyJob& j) { DeleteLanePush(lane, j.src); };
+            }
+            rc = CopyEngineRunBatch(jobs, prog);
+
+            // Collisions: those files alone go again under their next free names
+            for (int retry = 0; retry < 3; ++retry) {
+                std::vector<size_t> again;
+                for (size_t k = 0; k < jobs.size(); ++k)
+                    if (!jobs[k].ok && jobs[k].err == ERROR_FILE_EXISTS) again.push_back(k);
+                if (again.empty() || task->cancel.load(std::memory_order_relaxed)) break;
+
+                std::vector<CopyJob> redo;
+                for (size_t k : again) {
+                    CopyJob j;
+                    j.src = jobs[k].src;
+                    j.dst = jobs[k].dst;
+                    j.createNew = true;
+                    replan(j.dst, j.src);
+                    redo.push_back(std::move(j));
+                }
+                CopyProgress prog2;
+                prog2.cancel = &task->cancel;
+                prog2.onProgress = prog.onProgress;   // same status op: the retry shows its bytes / rate too
+                prog2.onFileDone = prog.onFileDone;
+                nJobs = redo.size();
+                CopyEngineRunBatch(redo, prog2);
+                for (size_t n = 0; n < again.size(); ++n) jobs[again[n]] = std::move(redo[n]);
+
+                rc = 0;
+                if (task->cancel.load()) rc = ERROR_CANCELLED;
+                for (const CopyJob& j : jobs) if (rc == 0 && !j.ok) rc = j.err ? j.err : 1;
+            }
+            if (!isCopy) DeleteLaneFinish(lane);
 
-            FileOpEmit(task, L"OK\r\n\r\n");
+            for (const CopyJob& j : jobs) {
+                if (j.ok) {
+                    FileOpEmit(task, L"OK: " + j.dst + L"\r\n");
+                }
+                else if (j.err && j.err != ERROR_CANCELLED) {
+                    wchar_t buf[256];
+                    swprintf_s(buf, L"ERROR: operation failed (err=%lu): ", j.err);
+                    FileOpEmit(task, buf + j.src + L"\r\n");
+                }
+            }
+            for (const auto& f : lane.failed) {
+                wchar_t buf[256];
+                swprintf_s(buf, L"Source delete failed (err=%lu), queued for reboot: ", f.second);
+                FileOpEmit(task, buf + f.first + L"\r\n");
+            }
+            FileOpEmit(task, L"\r\n");
         }
     }
     else if (task->kind == FileOpKind::DeleteFiles) {
+        // Unlinks are independent and latency-bound (SMB round trips), so several run at once;
+        // the log is written afterwards in list order.
         const size_t total = task->srcFiles.size();
-        for (size_t i = 0; i < total; ++i) {
-            if (task->cancel.load(std::memory_order_relaxed)) { rc = ERROR_CANCELLED; break; }
-
+        std::vector<DWORD> errs(total, ERROR_CANCELLED);
+        std::atomic<size_t> finished{ 0 };
+        ParallelFor(total, kDeletesInFlight, [&](size_t i) {
             const std::wstring& p = task->srcFiles[i];
-            const wchar_t* base = wcsrchr(p.c_str(), L'\\'); base = base ? base + 1 : p.c_str();
+            DWORD err = 0;
+            if (!DeleteFileW(p.c_str())) {
+                err = GetLastError();
+                if (!err) err = 1;
+                MoveFileExW(p.c_str(), NULL, MOVEFILE_DELAY_UNTIL_REBOOT);
+            }
+            errs[i] = err;
 
+            const size_t n = finished.fetch_add(1) + 1;
             if (task->statusId) {
+                const wchar_t* base = wcsrchr(p.c_str(), L'\\'); base = base ? base + 1 : p.c_str();
                 std::wstring st = L"Delete ";
-                st += std::to_wstring(i + 1);
+                st += std::to_wstring(n);
                 st += L"/";
                 st += std::to_wstring(total);
                 st += L": ";
                 st += base;
                 StatusOpUpdate(task->statusId, st);
             }
+        }, task->cancel);
 
-            wchar_t hdr[256];
-            swprintf_s(hdr, L"Deleting %zu of %zu:\r\n", i + 1, total);
-            FileOpEmit(task, hdr);
-            FileOpEmit(task, L"  " + p + L"\r\n");
-
-            if (!DeleteFileW(p.c_str())) {
-                DWORD err = GetLastError();
-                MoveFileExW(p.c_str(), NULL, MOVEFILE_DELAY_UNTIL_REBOOT);
-
-                wchar_t buf[256];
-                swprintf_s(buf, L"  FAILED (err=%lu) -> queued delete on reboot\r\n\r\n", err);
-                FileOpEmit(task, buf);
-
-                if (rc == 0) rc = err ? err : 1;
+        size_t ok = 0, failed = 0, skipped = 0;
+        for (size_t i = 0; i < total; ++i) {
+            const std::wstring& p = task->srcFiles[i];
+            if (errs[i] == 0) {
+                FileOpEmit(task, L"Deleted: " + p + L"\r\n");
+                task->deleted.push_back(p);
+                ++ok;
+            }
+            else if (errs[i] == ERROR_CANCELLED) {
+                ++skipped;   // never attempted
             }
             else {
-                FileOpEmit(task, L"  OK\r\n\r\n");
+                wchar_t buf[256];
+                swprintf_s(buf, L"FAILED (err=%lu) -> queued delete on reboot: ", errs[i]);
+                FileOpEmit(task, buf + p + L"\r\n");
+                if (rc == 0) rc = errs[i];
+                ++failed;
             }
         }
+        if (skipped && rc == 0) rc = ERROR_CANCELLED;
+
+        wchar_t sum[160];
+        swprintf_s(sum, L"\r\n%zu deleted, %zu failed, %zu not attempted.\r\n", ok, failed, skipped);
+        FileOpEmit(task, sum);
+        LogLine(L"[Delete] \"%s\": %zu deleted, %zu failed, %zu not attempted",
+            task->title.c_str(), ok, failed, skipped);
     }
     else if (task->kind == FileOpKind::CopyToPath) {
         if (task->srcSingle.empty() || task->dstPath.empty()) {
@@ -4191,13 +9196,20 @@ static DWORD WINAPI FileOpThreadProc(LPVOID param) {
 
             FileOpEmit(task, L"Copying:\r\n  From: " + task->srcSingle + L"\r\n  To  : " + task->dstPath + L"\r\n\r\n");
 
-            BOOL cancelFlag = FALSE;
-            BOOL ok = CopyFileExW(task->srcSingle.c_str(), task->dstPath.c_str(),
-                FileOpCopyProgressThunk, task, &cancelFlag, 0);
+            const uint64_t statusId = task->statusId;
+            std::wstring baseName = base;
+            DWORD err = 0;
+            BOOL ok = CopyFileFast(task->srcSingle, task->dstPath, &task->cancel, err,
+                [statusId, baseName](ULONGLONG done, ULONGLONG totalBytes) {
+                    if (!statusId) return;
+                    wchar_t buf[64];
+                    swprintf_s(buf, L" (%d%%)", totalBytes ? (int)(done * 100 / totalBytes) : 100);
+                    StatusOpUpdate(statusId, L"Copy: " + baseName + buf);
+                    StatusOpBytes(statusId, done, totalBytes);
+                });
 
             if (!ok) {
-                DWORD err = GetLastError();
-                if (cancelFlag || task->cancel.load()) rc = ERROR_CANCELLED;
+                if (err == ERROR_CANCELLED || task->cancel.load()) rc = ERROR_CANCELLED;
                 else rc = err ? err : 1;
 
                 wchar_t buf[256];
@@ -4217,6 +9229,17 @@ static DWORD WINAPI FileOpThreadProc(LPVOID param) {
             rc = 2;
         }
         else {
+            // Every queued name up front: the video and its .json / ._json sidecars share a stem
+            const std::vector<std::wstring> sidecars{ L".json", L"._json" };
+            NamePlan np;
+            NamePlanBegin(np, task->dstFolder);
+            std::vector<std::wstring> planned(total);
+            for (size_t i = 0; i < total; ++i) {
+                std::wstring fname, ext;
+                SplitBaseExt(task->srcFiles[i], fname, ext);
+                planned[i] = NamePlanTake(np, fname, ext, sidecars);
+            }
+
             for (size_t i = 0; i < total; ++i) {
                 if (task->cancel.load(std::memory_order_relaxed)) { rc = ERROR_CANCELLED; break; }
 
@@ -4233,28 +9256,7 @@ static DWORD WINAPI FileOpThreadProc(LPVOID param) {
                     StatusOpUpdate(task->statusId, st);
                 }
 
-                wchar_t fname[_MAX_FNAME] = {}, ext[_MAX_EXT] = {};
-                _wsplitpath_s(base, NULL, 0, NULL, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
-
-                std::wstring dstVideo = UniqueName(task->dstFolder, fname, ext);
-
-                const wchar_t* dstBase = wcsrchr(dstVideo.c_str(), L'\\');
-                dstBase = dstBase ? dstBase + 1 : dstVideo.c_str();
-
-                wchar_t dstF[_MAX_FNAME] = {}, dstE[_MAX_EXT] = {};
-                _wsplitpath_s(dstBase, NULL, 0, NULL, 0, dstF, _MAX_FNAME, dstE, _MAX_EXT);
-
-                std::wstring jsonFinal = task->dstFolder + dstF + L".json";
-                std::wstring jsonTemp = task->dstFolder + dstF + L"._json";
-
-                int bump = 1;
-                while (PathFileExistsW(jsonFinal.c_str()) || PathFileExistsW(jsonTemp.c_str())) {
-                    wchar_t suf[32]; swprintf_s(suf, L" (%d)", bump++);
-                    std::wstring newBase = std::wstring(dstF) + suf;
-                    dstVideo = task->dstFolder + newBase + dstE;
-                    jsonFinal = task->dstFolder + newBase + L".json";
-                    jsonTemp = task->dstFolder + newBase + L"._json";
-                }
+                std::wstring dstVideo = planned[i];
 
                 {
                     wchar_t hdr[256];
@@ -4264,13 +9266,32 @@ static DWORD WINAPI FileOpThreadProc(LPVOID param) {
                     FileOpEmit(task, L"  To  : " + dstVideo + L"\r\n");
                 }
 
-                BOOL cancelFlag = FALSE;
-                BOOL ok = CopyFileExW(src.c_str(), dstVideo.c_str(),
-                    FileOpCopyProgressThunk, task, &cancelFlag, 0);
+                DWORD err = 0;
+                std::string sha256;
+                const uint64_t statusId = task->statusId;
+                BOOL ok = FALSE;
+                for (int attempt = 0; attempt < 4; ++attempt) {
+                    ok = CopyFileFast(src, dstVideo, &task->cancel, err,
+                        [statusId](ULONGLONG done, ULONGLONG totalBytes) { StatusOpBytes(statusId, done, totalBytes); },
+                        &sha256, true);
+                    if (ok || err != ERROR_FILE_EXISTS) break;
+
+                    // Someone queued this name since the listing: take the next one
+                    const wchar_t* taken = wcsrchr(dstVideo.c_str(), L'\\');
+                    NamePlanMark(np, taken ? taken + 1 : dstVideo);
+                    std::wstring fname, ext;
+                    SplitBaseExt(src, fname, ext);
+                    dstVideo = NamePlanTake(np, fname, ext, sidecars);
+                    FileOpEmit(task, L"  Name taken meanwhile, using: " + dstVideo + L"\r\n");
+                }
+
+                std::wstring dstF, dstE;
+                SplitBaseExt(dstVideo, dstF, dstE);
+                const std::wstring jsonFinal = task->dstFolder + dstF + L".json";
+                const std::wstring jsonTemp = task->dstFolder + dstF + L"._json";
 
                 if (!ok) {
-                    DWORD err = GetLastError();
-                    if (cancelFlag || task->cancel.load()) rc = ERROR_CANCELLED;
+                    if (err == ERROR_CANCELLED || task->cancel.load()) rc = ERROR_CANCELLED;
                     else rc = err ? err : 1;
 
                     wchar_t buf[256];
@@ -4284,9 +9305,9 @@ static DWORD WINAPI FileOpThreadProc(LPVOID param) {
                     std::wstring queuedNameOnly = q ? (q + 1) : dstVideo;
 
                     std::string jsonUtf8;
-                    BuildTopazJobJsonUtf8(src, queuedNameOnly, task->topaz, jsonUtf8);
+                    BuildTopazJobJsonUtf8(src, queuedNameOnly, task->topaz, sha256, jsonUtf8);
 
-                    HANDLE h = CreateFileW(jsonTemp.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+                    HANDLE h = CreateFileW(jsonTemp.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_NEW,
                         FILE_ATTRIBUTE_NORMAL, NULL);
                     if (h == INVALID_HANDLE_VALUE) {
                         rc = GetLastError() ? GetLastError() : 5;
@@ -4303,7 +9324,7 @@ static DWORD WINAPI FileOpThreadProc(LPVOID param) {
                         break;
                     }
 
-                    if (!MoveFileExW(jsonTemp.c_str(), jsonFinal.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED)) {
+                    if (!MoveFileExW(jsonTemp.c_str(), jsonFinal.c_str(), MOVEFILE_COPY_ALLOWED)) {
                         rc = GetLastError() ? GetLastError() : 7;
                         FileOpEmit(task, L"ERROR: failed to publish job json (rename).\r\n\r\n");
                         break;
@@ -4314,6 +9335,12 @@ static DWORD WINAPI FileOpThreadProc(LPVOID param) {
             }
         }
     }
+    else if (task->kind == FileOpKind::FindSimilar) {
+        rc = RunFindSimilar(task);
+    }
+    else if (task->kind == FileOpKind::FindDuplicates) {
+        rc = RunFindDuplicates(task);
+    }
 
     if (rc == ERROR_CANCELLED) {
         FileOpEmit(task, L"\r\n[CANCELLED]\r\n");
@@ -4327,14 +9354,16 @@ static DWORD WINAPI FileOpThreadProc(LPVOID param) {
     task->running = false;
     task->done = true;
 
-    PostMessageW(g_hwndMain, WM_APP_FILEOP_DONE, (WPARAM)task, (LPARAM)rc);
-    return 0;
+    return rc;
 }
 
 // Helper: refresh current view without forcing a specific folder
 static void RefreshCurrentView() {
     if (g_inPlayback) return;
-    if (g_view == ViewKind::Search && g_search.active) {
+    if (g_view == ViewKind::Search && g_search.active && !g_search.groupLabel.empty()) {
+        RefreshGroupedResults();
+    }
+    else if (g_view == ViewKind::Search && g_search.active) {
         std::vector<Row> res;
         RunSearchFromOrigin(res);
         ShowSearchResults(res);
@@ -4347,6 +9376,160 @@ static void RefreshCurrentView() {
     }
 }
 
+// ----------------------------- Per-device I/O scheduler (NEW)
+// File-op tasks are mapped to the physical devices they read and write (disk number for local
+// volumes, server for network paths). A bulk task starts only while each of its devices runs
+// fewer than io_tasks_per_device bulk tasks; tasks on different devices run in parallel.
+// Small tasks (deletes, same-volume moves) touch no device slots and start immediately.
+// UI thread only (StartFileOpTask / OnFileOpDone / CancelMostRecentFileOpTask).
+static std::unordered_map<std::wstring, std::vector<std::wstring>> g_ioDevicesOfRoot; // lower volume root -> device keys
+static std::unordered_map<std::wstring, int> g_ioBusy;                                // device key -> running bulk tasks
+static std::vector<FileOpTask*> g_ioQueue;                                            // waiting bulk tasks, FIFO
+
+static int IoTasksPerDevice() {
+    return g_cfg.ioTasksPerDevice > 0 ? g_cfg.ioTasksPerDevice : 1;
+}
+
+static void IoDevicesForPath(const std::wstring& path, std::vector<std::wstring>& out) {
+    wchar_t root[MAX_PATH] = {};
+    if (!GetVolumePathNameW(path.c_str(), root, MAX_PATH)) return;
+    const std::wstring key = ToLower(root);
+
+    auto it = g_ioDevicesOfRoot.find(key);
+    if (it == g_ioDevicesOfRoot.end()) {
+        std::vector<std::wstring> devs;
+        std::wstring remote;
+        if (key.size() > 2 && key[0] == L'\\' && key[1] == L'\\' && key[2] != L'?') {
+            remote = key;                                   // UNC path
+        }
+        else if (key.size() >= 2 && key[1] == L':' && GetDriveTypeW(root) == DRIVE_REMOTE) {
+            GetDriveRemoteUNC(key[0], remote);              // mapped drive
+            remote = ToLower(remote);
+        }
+
+        if (!remote.empty()) {
+            size_t end = remote.find(L'\\', 2);             // \\server\share -> \\server
+            devs.push_back(L"net:" + remote.substr(0, end));
+        }
+        else {
+            wchar_t vol[MAX_PATH] = {};
+            if (GetVolumeNameForVolumeMountPointW(root, vol, MAX_PATH)) {
+                std::wstring dev = vol;
+                if (!dev.empty() && dev.back() == L'\\') dev.pop_back(); // \\?\Volume{...} opens the volume
+                HANDLE h = CreateFileW(dev.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+                if (h != INVALID_HANDLE_VALUE) {
+                    BYTE buf[sizeof(VOLUME_DISK_EXTENTS) + 7 * sizeof(DISK_EXTENT)] = {};
+                    DWORD got = 0;
+                    if (DeviceIoControl(h, IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS, NULL, 0, buf, sizeof(buf), &got, NULL)) {
+                        const VOLUME_DISK_EXTENTS* ext = (const VOLUME_DISK_EXTENTS*)buf;
+                        for (DWORD i = 0; i < ext->NumberOfDiskExtents && i < 8; ++i) {
+                            std::wstring d = L"disk:" + std::to_wstring(ext->Extents[i].DiskNumber);
+                            if (std::find(devs.begin(), devs.end(), d) == devs.end()) devs.push_back(d);
+                        }
+                    }
+                    CloseHandle(h);
+                }
+            }
+        }
+        if (devs.empty()) devs.push_back(L"vol:" + key);    // unknown layout: one device per volume
+        it = g_ioDevicesOfRoot.emplace(key, std::move(devs)).first;
+    }
+
+    for (const auto& d : it->second)
+        if (std::find(out.begin(), out.end(), d) == out.end()) out.push_back(d);
+}
+
+static void IoAssignDevices(FileOpTask* task) {
+    task->ioDevices.clear();
+    switch (task->kind) {
+    case FileOpKind::DeleteFiles:
+        break; // metadata only
+    case FileOpKind::ClipboardPaste: {
+        bool allRenames = (task->clipMode == ClipMode::Move);
+        for (const auto& f : task->srcFiles) {
+            if (allRenames && !SameVolume(f, task->dstFolder)) allRenames = false;
+        }
+        if (allRenames) break;
+        for (const auto& f : task->srcFiles) IoDevicesForPath(f, task->ioDevices);
+        IoDevicesForPath(task->dstFolder, task->ioDevices);
+        break;
+    }
+    case FileOpKind::CopyToPath:
+        IoDevicesForPath(task->srcSingle, task->ioDevices);
+        IoDevicesForPath(task->dstPath, task->ioDevices);
+        break;
+    case FileOpKind::TopazSubmit:
+        for (const auto& f : task->srcFiles) IoDevicesForPath(f, task->ioDevices);
+        IoDevicesForPath(task->dstFolder, task->ioDevices);
+        break;
+    case FileOpKind::FindSimilar:
+    case FileOpKind::FindDuplicates:
+        for (const auto& f : task->scanFolders) IoDevicesForPath(f, task->ioDevices);
+        for (const auto& f : task->scanFiles) IoDevicesForPath(f, task->ioDevices);
+        break;
+    }
+}
+
+static bool IoCanStart(const FileOpTask* task) {
+    if (task->cancel.load(std::memory_order_relaxed)) return true; // exits at once
+    const int limit = IoTasksPerDevice();
+    for (const auto& d : task->ioDevices) {
+        auto it = g_ioBusy.find(d);
+        if (it != g_ioBusy.end() && it->second >= limit) return false;
+    }
+    return true;
+}
+
+static void IoAcquire(FileOpTask* task) {
+    for (const auto& d : task->ioDevices) ++g_ioBusy[d];
+    task->ioHeld = true;
+}
+
+static void IoRelease(FileOpTask* task) {
+    if (!task->ioHeld) return;
+    for (const auto& d : task->ioDevices) {
+        auto it = g_ioBusy.find(d);
+        if (it != g_ioBusy.end() && --it->second <= 0) g_ioBusy.erase(it);
+    }
+    task->ioHeld = false;
+}
+
+static void LaunchFileOpJob(FileOpTask* task);
+
+// Start every queued task whose devices have room (earlier tasks first).
+static void IoSchedPump() {
+    for (size_t i = 0; i < g_ioQueue.size();) {
+        FileOpTask* t = g_ioQueue[i];
+        if (!IoCanStart(t)) { ++i; continue; }
+        g_ioQueue.erase(g_ioQueue.begin() + i);
+        LaunchFileOpJob(t);
+    }
+}
+
+static void LaunchFileOpJob(FileOpTask* task) {
+    IoAcquire(task);
+    // Paste / copy / delete: the user is waiting. Topaz submits and finders can yield.
+    JobPriority prio = JobPriority::High;
+    if (task->kind == FileOpKind::TopazSubmit) prio = JobPriority::Normal;
+    else if (task->kind == FileOpKind::FindSimilar || task->kind == FileOpKind::FindDuplicates) prio = JobPriority::Low;
+    task->jobId = JobSubmit(JobKind::FileOp, prio, FileOpJobProc, task, &task->cancel, true);
+    if (!task->jobId) {
+        IoRelease(task);
+        EnterCriticalSection(&g_fileLock);
+        auto it = std::find(g_fileTasks.begin(), g_fileTasks.end(), task);
+        if (it != g_fileTasks.end()) g_fileTasks.erase(it);
+        LeaveCriticalSection(&g_fileLock);
+
+        if (task->statusId) StatusOpEnd(task->statusId);
+        if (task->hwnd && IsWindow(task->hwnd)) DestroyWindow(task->hwnd);
+        PlaybackExitDeleteRelease(task, false);
+        delete task;
+
+        MessageBoxW(g_hwndMain, L"Failed to start background file-op job.", L"File operation", MB_OK);
+        return;
+    }
+}
+
 static void StartFileOpTask(FileOpTask* task) {
     if (!task) return;
 
@@ -4359,6 +9542,7 @@ static void StartFileOpTask(FileOpTask* task) {
         HWND logWnd = CreateFileOpLogWindow(task);
         if (!logWnd) {
             if (task->statusId) StatusOpEnd(task->statusId);
+            PlaybackExitDeleteRelease(task, false);
             delete task;
             MessageBoxW(g_hwndMain, L"Failed to create file-op log window.", L"File operation", MB_OK);
             return;
@@ -4370,22 +9554,14 @@ static void StartFileOpTask(FileOpTask* task) {
     g_fileTasks.push_back(task);
     LeaveCriticalSection(&g_fileLock);
 
-    HANDLE hThread = CreateThread(NULL, 0, FileOpThreadProc, task, 0, NULL);
-    if (!hThread) {
-        EnterCriticalSection(&g_fileLock);
-        auto it = std::find(g_fileTasks.begin(), g_fileTasks.end(), task);
-        if (it != g_fileTasks.end()) g_fileTasks.erase(it);
-        LeaveCriticalSection(&g_fileLock);
-
-        if (task->statusId) StatusOpEnd(task->statusId);
-        if (task->hwnd && IsWindow(task->hwnd)) DestroyWindow(task->hwnd);
-        delete task;
-
-        MessageBoxW(g_hwndMain, L"Failed to start background file-op thread.", L"File operation", MB_OK);
+    IoAssignDevices(task);
+    if (!IoCanStart(task)) {
+        g_ioQueue.push_back(task);
+        if (task->statusId) StatusOpUpdate(task->statusId, task->title + L" (queued)");
+        LogLine(L"[FileOp] queued \"%s\" (device busy)", task->title.c_str());
         return;
     }
-
-    task->hThread = hThread;
+    LaunchFileOpJob(task);
 }
 
 static void ScheduleClipboardPasteAsync(const std::wstring& dstFolder)
@@ -4447,7 +9623,8 @@ static void ScheduleCopyToPathAsync(const std::wstring& src,
     const std::wstring& dst,
     const std::wstring& title,
     bool fromPlaybackExit,
-    uint32_t playbackExitGen)
+    uint32_t playbackExitGen,
+    PlaybackExitDelete* deleteAfter)
 {
     if (src.empty() || dst.empty()) return;
     FileOpTask* task = new FileOpTask();
@@ -4459,10 +9636,68 @@ static void ScheduleCopyToPathAsync(const std::wstring& src,
 
     task->fromPlaybackExit = fromPlaybackExit;
     task->playbackExitGen = playbackExitGen;
+    task->deleteAfter = deleteAfter;
 
     StartFileOpTask(task);
 }
 
+// Finder scope: Search view = its result files; Folder view = selection, else the folder
+// (recursive); Drives view = selected drives, else every fixed/network drive.
+static bool CollectFinderScope(FileOpTask* task) {
+    task->scanFolders.clear();
+    task->scanFiles.clear();
+
+    if (g_view == ViewKind::Search) {
+        for (const Row& r : g_rows) if (!r.isDir) task->scanFiles.push_back(r.full);
+        task->scanOriginView = g_search.originView;
+        task->scanOriginFolder = g_search.originFolder;
+    }
+    else {
+        CollectSelection(task->scanFolders, task->scanFiles);
+        if (task->scanFolders.empty() && task->scanFiles.empty()) {
+            if (g_view == ViewKind::Folder) {
+                task->scanFolders.push_back(EnsureSlash(g_folder));
+            }
+            else {
+                DWORD mask = GetLogicalDrives();
+                for (int i = 0; i < 26; ++i) {
+                    if (!(mask & (1u << i))) continue;
+                    wchar_t root[4] = { wchar_t(L'A' + i), L':', L'\\', 0 };
+                    if (GetDriveTypeW(root) == DRIVE_CDROM) continue;
+                    task->scanFolders.push_back(root);
+                }
+            }
+        }
+        task->scanOriginView = g_view;
+        task->scanOriginFolder = (g_view == ViewKind::Folder ? g_folder : L"");
+    }
+    return !task->scanFolders.empty() || !task->scanFiles.empty();
+}
+
+// Ctrl+S: group visually similar videos (re-encodes, rescales, different containers).
+static void Browser_FindSimilar() {
+    if (!g_cfg.ffmpegAvailable) {
+        StatusBarSetText(L"Find similar: requires ffmpegAvailable=1 in mediaexplorer.ini");
+        return;
+    }
+    FileOpTask* task = new FileOpTask();
+    task->kind = FileOpKind::FindSimilar;
+    if (!CollectFinderScope(task)) { delete task; return; }
+    task->title = L"Find similar videos";
+    task->running = true;
+    StartFileOpTask(task);
+}
+
+// Ctrl+D: group byte-identical videos (same scope rules as Ctrl+S).
+static void Browser_FindDuplicates() {
+    FileOpTask* task = new FileOpTask();
+    task->kind = FileOpKind::FindDuplicates;
+    if (!CollectFinderScope(task)) { delete task; return; }
+    task->title = L"Find duplicate files";
+    task->running = true;
+    StartFileOpTask(task);
+}
+
 // -------- Embedded video_combine logic (internal, ffmpeg-based) --------
 
 // Narrow/wide helpers using the ANSI code page (matches old console argv behavior).
@@ -4511,50 +9746,64 @@ static void VC_UpdateCombineWindowTitle(CombineTask* task, const wchar_t* status
     SetWindowTextW(task->hwnd, title.c_str());
 }
 
-// Run a command in a hidden console and wait for it to finish.
-// Returns the process exit code, or (DWORD)-1 on failure to spawn.
-static DWORD RunHiddenCommandAnsi(const char* cmdAnsi) {
+// Runs one combine ffmpeg command (ANSI, as the stages build it) in a hidden console. Progress
+// goes to onProgress; console output is dropped except the last line, logged if ffmpeg fails.
+// The process is killed at the next progress report (about twice a second) once task->cancel or
+// *stop is set. Returns the exit code, or (DWORD)-1 on failure to spawn.
+static DWORD VC_RunFfmpeg(CombineTask* task, const char* cmdAnsi, HANDLE hStdin,
+    const std::function<void(const FfmpegProgress&)>& onProgress, const std::atomic<bool>* stop = nullptr)
+{
     if (!cmdAnsi || !*cmdAnsi) return (DWORD)-1;
-
     std::wstring w = WideFromNarrowACP(cmdAnsi);
     if (w.empty()) return (DWORD)-1;
 
-    std::vector<wchar_t> cmdBuf(w.size() + 1);
-    wcscpy_s(cmdBuf.data(), cmdBuf.size(), w.c_str());
-
-    STARTUPINFOW si{};
-    si.cb = sizeof(si);
-    PROCESS_INFORMATION pi{};
-    DWORD flags = CREATE_NO_WINDOW;
-
-    BOOL ok = CreateProcessW(
-        NULL,               // use command line for program+args
-        cmdBuf.data(),      // modifiable buffer
-        NULL, NULL,
-        FALSE,
-        flags,
-        NULL, NULL,
-        &si, &pi);
-    if (!ok) {
-        return (DWORD)-1;
+    // Valid from spawn until RunFfmpegProgress returns; the callbacks run on this thread
+    HANDLE hProcess = NULL;
+    bool killed = false;
+    std::string last;
+    const DWORD exitCode = RunFfmpegProgress(w, hStdin, &hProcess, [&](const FfmpegProgress& p) {
+        if (!killed && hProcess && (task->cancel || (stop && *stop))) {
+            killed = true;
+            TerminateProcess(hProcess, ERROR_CANCELLED);
+        }
+        if (onProgress) onProgress(p);
+        }, [&](const std::string& line) {
+        if (line.find_first_not_of(" \r\n") != std::string::npos) last = line;
+        });
+    if (killed) return ERROR_CANCELLED;
+    if (exitCode != 0 && !last.empty()) {
+        while (!last.empty() && (last.back() == '\n' || last.back() == '\r')) last.pop_back();
+        VC_LogCmd(task, ("ffmpeg: " + last).c_str());
     }
-
-    WaitForSingleObject(pi.hProcess, INFINITE);
-    DWORD exitCode = 0;
-    GetExitCodeProcess(pi.hProcess, &exitCode);
-    CloseHandle(pi.hThread);
-    CloseHandle(pi.hProcess);
     return exitCode;
 }
 
-// Same, but execute via "cmd.exe /C <command>" for shell built-ins like copy.
-static DWORD RunHiddenCommandAnsiViaCmd(const char* innerCmdAnsi) {
-    if (!innerCmdAnsi || !*innerCmdAnsi) return (DWORD)-1;
-    char full[9000];
-    sprintf(full, "cmd.exe /C %s", innerCmdAnsi);
-    return RunHiddenCommandAnsi(full);
+// Progress of one combine ffmpeg run: status bar on every report, the log every kFfProgressLogMs.
+static std::function<void(const FfmpegProgress&)> VC_ProgressSink(CombineTask* task, const std::wstring& stage,
+    int64_t durationMs)
+{
+    ULONGLONG lastLog = GetTickCount64();
+    return [task, stage, durationMs, lastLog](const FfmpegProgress& p) mutable {
+        const std::wstring text = stage + L" " + FfmpegProgressText(p, durationMs);
+        if (task->statusId) StatusOpUpdate(task->statusId, L"Combine: " + task->title + L"  " + text);
+        const ULONGLONG now = GetTickCount64();
+        if (p.ended || now - lastLog >= kFfProgressLogMs) {
+            lastLog = now;
+            VC_LogMsg(task, L"[progress] " + text + L"\r\n");
+        }
+    };
 }
 
+// Sum of the cached durations of the sources (ANSI paths); 0 if any of them is not known.
+static int64_t VC_TotalDurationMs(const std::vector<std::string>& files) {
+    int64_t total = 0;
+    for (const auto& f : files) {
+        const int64_t ms = MetaCacheDurationMs(WideFromNarrowACP(f));
+        if (ms <= 0) return 0;
+        total += ms;
+    }
+    return total;
+}
 
 // From video_combine.cpp: prevent duplicate entries in list.
 static bool nodup_add(std::vector<std::string>& list, const std::string& new_file) {
@@ -4572,124 +9821,340 @@ static bool nodup_add(std::vector<std::string>& list, const std::string& new_fil
 
 // ---- Direct ports of video_combine.cpp functions (same method, in-process) ----
 
-// Stage 1: convert each source to an .mpg using ffmpeg -qscale:v 1
+// Parts normalized at once: about one ffmpeg per 4 cores (x264 threads well, but its
+// demux / filter / mux stages do not), never more than 4 or than there are parts.
+static int VC_PartsInFlight(size_t parts) {
+    SYSTEM_INFO si{};
+    GetSystemInfo(&si);
+    int n = (int)si.dwNumberOfProcessors / 4;
+    if (n < 1) n = 1;
+    if (n > 4) n = 4;
+    return (size_t)n > parts ? (int)parts : n;
+}
+
+// Mezzanine geometry from the first part's stream signature (its "v,codec,profile,WxH,pix,sar,fps,..."
+// entry, wherever it sits): every part is scaled / padded to its size and resampled to its frame
+// rate. false = no video geometry (cannot probe, or no video stream).
+static bool VC_MezzanineFilter(const std::string& firstPart, std::string& vf) {
+    const std::string sig = StreamSignatureOf(WideFromNarrowACP(firstPart));
+    size_t start = 0;
+    if (sig.compare(0, 2, "v,") != 0) {
+        start = sig.find(";v,");
+        if (start == std::string::npos) return false;
+        ++start;
+    }
+    const size_t end = sig.find(';', start);
+    const std::string video = sig.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    std::vector<std::string> f;
+    size_t pos = 0;
+    while (pos <= video.size()) {
+        size_t c = video.find(',', pos);
+        if (c == std::string::npos) c = video.size();
+        f.push_back(video.substr(pos, c - pos));
+        pos = c + 1;
+    }
+    int w = 0, h = 0;
+    if (f.size() < 7 || sscanf(f[3].c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) return false;
+    w &= ~1;
+    h &= ~1;
+    char buf[256];
+    sprintf_s(buf, "scale=%d:%d:force_original_aspect_ratio=decrease,pad=%d:%d:(ow-iw)/2:(oh-ih)/2,setsar=1",
+        w, h, w, h);
+    vf = buf;
+    if (!f[6].empty() && f[6] != "0/0") vf += ",fps=" + f[6];
+    return true;
+}
+
+// Stage 1: normalize every part (read in place) into the working dir, several parts at once.
+// Mezzanine = H.264 (CRF 14) + AAC 48 kHz stereo in MPEG-TS at the first part's size and frame
+// rate: TS parts join by plain byte concatenation and the joined stream only needs a remux.
+// Any failure stops the remaining parts and removes every part written so far.
 static bool convert2mpg(const std::vector<std::string>& srcfn,
     std::vector<std::string>& mpgfn,
     CombineTask* task)
 {
-    bool retval = true;
-    char drive[260];
-    char path[260];
     char fn[260];
-    int  limit = (int)srcfn.size();
-    char mpgfile[260];
-    char cmd[8192];
+    const int limit = (int)srcfn.size();
+
+    // Parts go to the working dir; numbered, since sources from different folders may share a name
+    const std::string workDir = NarrowFromWideACP(EnsureSlash(task->workingDir));
+    mpgfn.clear();
+    for (int index = 0; index < limit; ++index) {
+        _splitpath(srcfn[index].c_str(), NULL, NULL, fn, NULL);
+        char num[16];
+        sprintf(num, "%03d-", index + 1);
+        mpgfn.push_back(workDir + num + fn + ".ts");
+        task->workFiles.push_back(WideFromNarrowACP(mpgfn.back()));
+    }
+
+    std::string vf;
+    if (!VC_MezzanineFilter(srcfn[0], vf)) {
+        VC_LogMsg(task, L"Cannot read the video size / frame rate of " + WideFromNarrowACP(srcfn[0]) +
+            L"; parts cannot be normalized.\r\n");
+        return false;
+    }
+    const int inFlight = VC_PartsInFlight(srcfn.size());
+    SYSTEM_INFO si{};
+    GetSystemInfo(&si);
+    const int threadsEach = (std::max)(1, (int)si.dwNumberOfProcessors / inFlight);
+    {
+        wchar_t buf[160];
+        swprintf_s(buf, L"Normalizing %d part(s), %d at a time...\r\n", limit, inFlight);
+        VC_LogMsg(task, buf);
+    }
 
+    // Overall progress: each part's output position against its cached duration
+    std::vector<int64_t> partMs(limit, 0);
+    int64_t totalMs = 0;
     for (int index = 0; index < limit; ++index) {
-        _splitpath(srcfn[index].c_str(), drive, path, fn, NULL);
-        sprintf(mpgfile, "%s%s%s.mpg", drive, path, fn);
-        mpgfn.push_back(mpgfile);
+        partMs[index] = MetaCacheDurationMs(WideFromNarrowACP(srcfn[index]));
+        totalMs = (totalMs < 0 || partMs[index] <= 0) ? -1 : totalMs + partMs[index];
+    }
+    std::vector<std::atomic<int64_t>> partAt(limit);
+    for (auto& at : partAt) at = 0;
+    const ULONGLONG startAll = GetTickCount64();
+
+    std::atomic<bool> stop{ false };
+    std::atomic<int> finished{ 0 };
+    ParallelFor(srcfn.size(), inFlight, [&](size_t index) {
+        if (stop || task->cancel) { stop = true; return; }
+
+        // Parts without audio get silence, so the joined stream has audio throughout
+        const std::string sig = StreamSignatureOf(WideFromNarrowACP(srcfn[index]));
+        const bool noAudio = !sig.empty() && sig.compare(0, 2, "a,") != 0 && sig.find(";a,") == std::string::npos;
+
+        char cmd[8192];
+        sprintf(cmd, "%s -y -i \"%s\"%s -map 0:v:0 %s%s%s -c:v libx264 -preset fast -crf 14 -pix_fmt yuv420p "
+            "-threads %d -c:a aac -b:a 256k -ar 48000 -ac 2 -f mpegts \"%s\"",
+            g_ffmpegExeA.c_str(), srcfn[index].c_str(),
+            noAudio ? " -f lavfi -i anullsrc=r=48000:cl=stereo" : "",
+            noAudio ? "-map 1:a -shortest" : "-map 0:a:0?",
+            " -vf \"", (vf + "\"").c_str(),
+            threadsEach, mpgfn[index].c_str());
+        char head[64];
+        sprintf(head, "[part %d/%d] ", (int)index + 1, limit);
+        VC_LogCmd(task, (std::string(head) + cmd).c_str());
+
+        const DWORD t0 = GetTickCount();
+        ULONGLONG lastLog = GetTickCount64();
+        const DWORD exitCode = VC_RunFfmpeg(task, cmd, NULL, [&](const FfmpegProgress& p) {
+            if (p.outTimeMs >= 0) partAt[index] = partMs[index] > 0 ? (std::min)(p.outTimeMs, partMs[index]) : p.outTimeMs;
+            wchar_t b[96];
+            std::wstring text;
+            int64_t at = 0;
+            for (const auto& a : partAt) at += a;
+            if (totalMs > 0 && at > 0) {
+                const double left = (double)(GetTickCount64() - startAll) * (double)(totalMs - at) / (double)at;
+                swprintf_s(b, L"normalizing %d%% (%d/%d parts done)", (int)(at * 100 / totalMs), (int)finished, limit);
+                text = std::wstring(b) + L"  ETA " + FormatHMSms((LONGLONG)left);
+            }
+            else {
+                swprintf_s(b, L"normalizing (%d/%d parts done)", (int)finished, limit);
+                text = b;
+            }
+            if (task->statusId) StatusOpUpdate(task->statusId, L"Combine: " + task->title + L"  " + text);
+            const ULONGLONG now = GetTickCount64();
+            if (now - lastLog >= kFfProgressLogMs) {
+                lastLog = now;
+                VC_LogMsg(task, WideFromNarrowACP(head) + FfmpegProgressText(p, partMs[index]) + L"\r\n");
+            }
+            }, &stop);
+        char msg[9000];
+        if (exitCode != 0) {
+            const bool stopped = stop.exchange(true) || task->cancel;
+            if (stopped) sprintf(msg, "%sstopped: %s", head, srcfn[index].c_str());
+            else sprintf(msg, "%sfailed (exit=%lu): %s", head, (unsigned long)exitCode, srcfn[index].c_str());
+            VC_LogCmd(task, msg);
+            return;
+        }
+        const int n = ++finished;
+        sprintf(msg, "%sdone in %.1f s (%d of %d normalized)", head, (GetTickCount() - t0) / 1000.0, n, limit);
+        VC_LogCmd(task, msg);
+        wchar_t title[96];
+        swprintf_s(title, L"(normalizing %d/%d...)", n, limit);
+        VC_UpdateCombineWindowTitle(task, title);
+        }, stop);
+
+    if (stop || task->cancel || finished != limit) {
+        for (const auto& part : mpgfn) _unlink(part.c_str());
+        VC_LogMsg(task, L"Normalization stopped; partial outputs removed.\r\n");
+        return false;
+    }
+    return true;
+}
 
-        // ffmpeg -i "src" -qscale:v 1 "dst.mpg"
-        sprintf(cmd, "%s -i \"%s\" -qscale:v 1 \"%s\"",
-            g_ffmpegExeA.c_str(), srcfn[index].c_str(), mpgfile);
-        VC_LogCmd(task, cmd);
+struct VC_FeedCtx {
+    CombineTask* task = nullptr;
+    const std::vector<std::string>* parts = nullptr;
+    HANDLE hWrite = NULL;
+    ULONGLONG total = 0;
+    ULONGLONG sent = 0;
+    bool readFailed = false;    // a part could not be read, or the combine was cancelled
+};
 
-        DWORD exitCode = RunHiddenCommandAnsi(cmd);
-        if (exitCode == 0) {
-            // success
-        }
-        else {
-            char fail[9000];
-            sprintf(fail, "%s failed (exit=%lu)", cmd, (unsigned long)exitCode);
-            VC_LogCmd(task, fail);
-            retval = false;
-            break;
+// Feeder thread: the parts back to back into ffmpeg's stdin, then EOF (closes the pipe).
+static DWORD WINAPI VC_FeedPartsProc(LPVOID param) {
+    VC_FeedCtx* ctx = (VC_FeedCtx*)param;
+    CombineTask* task = ctx->task;
+    std::vector<BYTE> buf(4 * 1024 * 1024);
+    int shownPct = -1;
+    bool pipeClosed = false;
+    for (size_t i = 0; i < ctx->parts->size() && !ctx->readFailed && !pipeClosed; ++i) {
+        const std::wstring wp = WideFromNarrowACP((*ctx->parts)[i]);
+        wchar_t head[64];
+        swprintf_s(head, L"[join %zu/%zu] ", i + 1, ctx->parts->size());
+        VC_LogMsg(task, head + wp + L"\r\n");
+        HANDLE hIn = CreateFileW(wp.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hIn == INVALID_HANDLE_VALUE) { ctx->readFailed = true; break; }
+        for (;;) {
+            if (task->cancel) { ctx->readFailed = true; break; }
+            DWORD got = 0;
+            if (!ReadFile(hIn, buf.data(), (DWORD)buf.size(), &got, NULL)) { ctx->readFailed = true; break; }
+            if (got == 0) break;
+            DWORD put = 0;
+            if (!WriteFile(ctx->hWrite, buf.data(), got, &put, NULL) || put != got) { pipeClosed = true; break; }
+            ctx->sent += got;
+            const int pct = ctx->total ? (int)(ctx->sent * 100 / ctx->total) : 0;
+            if (pct != shownPct) {
+                shownPct = pct;
+                wchar_t title[64];
+                swprintf_s(title, L"(joining %d%%...)", pct);
+                VC_UpdateCombineWindowTitle(task, title);
+            }
         }
+        CloseHandle(hIn);
     }
-    return retval;
+    CloseHandle(ctx->hWrite);   // EOF for ffmpeg; a cut-short stream is rejected by the caller
+    ctx->hWrite = NULL;
+    return 0;
 }
 
-// Stage 2: copy /B file1.mpg+file2.mpg+... combined.mpg
-static bool combinempg(const std::vector<std::string>& mpgfn,
-    std::string& combinefile,
-    CombineTask* task)
+// Stage 2: feed the parts back to back into ffmpeg's stdin (large sequential reads, in
+// process): the joined stream never lands on disk and there is no command-line length limit.
+// outArgs follows "-i pipe:0"; durationMs (0 = unknown) is the joined length for the progress.
+// Returns ffmpeg's exit code, (DWORD)-1 if it could not be started or a part could not be read.
+static DWORD VC_StreamPartsToFfmpeg(CombineTask* task, const std::vector<std::string>& parts,
+    const std::string& outArgs, const wchar_t* stage, int64_t durationMs)
 {
-    bool retval = true;
-    char cmd[8192];
-    int  limit = (int)mpgfn.size();
-
-    strcpy(cmd, "copy /B ");
-
-    for (int index = 0; index < limit; ++index) {
-        strcat(cmd, "\"");
-        strcat(cmd, mpgfn[index].c_str());
-        strcat(cmd, "\" ");
-
-        if (index < limit - 1)
-            strcat(cmd, "+ ");
+    VC_FeedCtx ctx;
+    ctx.task = task;
+    ctx.parts = &parts;
+    for (const auto& p : parts) {
+        WIN32_FILE_ATTRIBUTE_DATA fad{};
+        if (GetFileAttributesExW(WideFromNarrowACP(p).c_str(), GetFileExInfoStandard, &fad))
+            ctx.total += ((ULONGLONG)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+    }
+
+    const std::string cmd = g_ffmpegExeA + " -y -f mpegts -i pipe:0 " + outArgs;
+    VC_LogCmd(task, cmd.c_str());
+
+    // Both ends private: RunFfmpegProgress makes hRead inheritable only while it spawns ffmpeg
+    HANDLE hRead = NULL;
+    if (!CreatePipe(&hRead, &ctx.hWrite, NULL, 1024 * 1024)) return (DWORD)-1;
+
+    // The feeder blocks until ffmpeg reads; closing hRead after ffmpeg exits releases it
+    HANDLE hFeed = CreateThread(NULL, 0, VC_FeedPartsProc, &ctx, 0, NULL);
+    if (!hFeed) {
+        CloseHandle(ctx.hWrite);
+        CloseHandle(hRead);
+        return (DWORD)-1;
     }
+    DWORD exitCode = VC_RunFfmpeg(task, cmd.c_str(), hRead, VC_ProgressSink(task, stage, durationMs));
+    CloseHandle(hRead);
+    WaitForSingleObject(hFeed, INFINITE);
+    CloseHandle(hFeed);
 
-    strcat(cmd, " \"");
-    strcat(cmd, combinefile.c_str());
-    strcat(cmd, "\"");
-
-    VC_LogCmd(task, cmd);
-
-    DWORD exitCode = RunHiddenCommandAnsiViaCmd(cmd);
-    if (exitCode == 0) {
-        // Delete intermediate .mpg files just like original code
-        for (int index = 0; index < limit; ++index) {
-            _unlink(mpgfn[index].c_str());
-        }
-    }
-    else {
-        char fail[9000];
-        sprintf(fail, "%s failed (exit=%lu)", cmd, (unsigned long)exitCode);
-        VC_LogCmd(task, fail);
-        retval = false;
+    if (ctx.readFailed) {
+        VC_LogMsg(task, task->cancel ? L"Join cancelled.\r\n" : L"Cannot read a part; join stopped.\r\n");
+        return (DWORD)-1;
     }
-    return retval;
+    char msg[160];
+    sprintf(msg, "Streamed %.1f MB to ffmpeg (exit=%lu)", ctx.sent / (1024.0 * 1024.0), (unsigned long)exitCode);
+    VC_LogCmd(task, msg);
+    return exitCode;
 }
 
-// Stage 3: convert combined.mpg back to final format using ffmpeg -qscale:v 2
-static bool convertback(const std::string& combinefile,
+// Stage 3: the streamed parts are remuxed into the final container (stream copy); encode again
+// (ffmpeg -qscale:v 2, the original method) only if that container cannot take H.264 / AAC.
+static bool convertback(const std::vector<std::string>& mpgfn,
     const std::string& finalfile,
+    int64_t durationMs,
     CombineTask* task)
 {
-    char cmd[8192];
-    bool retval = true;
+    const std::string out = "\"" + finalfile + "\"";
+    if (VC_StreamPartsToFfmpeg(task, mpgfn, "-map 0 -c copy " + out, L"remux", durationMs) == 0) return true;
+    _unlink(finalfile.c_str());
+    if (task->cancel) return false;
+    VC_LogMsg(task, L"Remux failed; encoding the final file instead.\r\n");
+
+    DWORD exitCode = VC_StreamPartsToFfmpeg(task, mpgfn, "-qscale:v 2 " + out, L"encode", durationMs);
+    if (exitCode != 0) {
+        char fail[64];
+        sprintf(fail, "Final encode failed (exit=%lu)", (unsigned long)exitCode);
+        VC_LogCmd(task, fail);
+        _unlink(finalfile.c_str());
+        return false;
+    }
+    return true;
+}
 
-    // ffmpeg -i "combined.mpg" -qscale:v 2 "final.ext"
-    sprintf(cmd, "%s -i \"%s\" -qscale:v 2 \"%s\"",
-        g_ffmpegExeA.c_str(), combinefile.c_str(), finalfile.c_str());
-    VC_LogCmd(task, cmd);
+// Fast path: parts whose video/audio parameters all agree are joined by the concat demuxer with
+// stream copy (no transcode, no quality loss). false = not compatible or ffmpeg failed.
+static bool VC_ConcatCopy(CombineTask* task, const std::vector<std::string>& srcfn, const std::string& finalfile) {
+    std::string first;
+    for (const auto& f : srcfn) {
+        const std::wstring wf = WideFromNarrowACP(f);
+        const std::string sig = StreamSignatureOf(wf);
+        if (sig.empty()) {
+            VC_LogMsg(task, L"Cannot probe " + wf + L"; using the transcode path.\r\n");
+            return false;
+        }
+        if (first.empty()) first = sig;
+        else if (sig != first) {
+            VC_LogMsg(task, L"Parts differ (" + FromUtf8(first) + L" vs " + FromUtf8(sig) + L" in " + wf +
+                L"); using the transcode path.\r\n");
+            return false;
+        }
+    }
+    VC_LogMsg(task, L"All parts match (" + FromUtf8(first) + L"): joining by stream copy.\r\n");
 
-    DWORD exitCode = RunHiddenCommandAnsi(cmd);
-    if (exitCode == 0) {
-        // success
+    const std::string listfile = NarrowFromWideACP(EnsureSlash(task->workingDir)) + "parts.ffconcat";
+    task->workFiles.push_back(WideFromNarrowACP(listfile));
+    std::string text = "ffconcat version 1.0\n";
+    for (const auto& f : srcfn) text += FfconcatFileLine(WideFromNarrowACP(f));
+    FILE* lf = fopen(listfile.c_str(), "wb");
+    if (!lf) {
+        VC_LogMsg(task, L"Cannot write the concat list; using the transcode path.\r\n");
+        return false;
     }
-    else {
-        char fail[9000];
-        sprintf(fail, "%s failed (exit=%lu)", cmd, (unsigned long)exitCode);
-        VC_LogCmd(task, fail);
-        retval = false;
+    const bool wrote = fwrite(text.data(), 1, text.size(), lf) == text.size();
+    fclose(lf);
+
+    const std::string cmd = g_ffmpegExeA + " -y -f concat -safe 0 -i \"" + listfile + "\" -map 0:v -map 0:a? -c copy \"" +
+        finalfile + "\"";
+    VC_LogCmd(task, cmd.c_str());
+    DWORD exitCode = wrote ? VC_RunFfmpeg(task, cmd.c_str(), NULL, VC_ProgressSink(task, L"stream copy", VC_TotalDurationMs(srcfn)))
+        : (DWORD)-1;
+    _unlink(listfile.c_str());
+    if (exitCode != 0) {
+        const std::string fail = cmd + " failed (exit=" + std::to_string(exitCode) + "); using the transcode path";
+        VC_LogCmd(task, fail.c_str());
+        _unlink(finalfile.c_str());
+        return false;
     }
-    return retval;
+    return true;
 }
 
 // Full video_combine "combine_videos" logic as a function:
-// uses the 3 stages above, same algorithm as original tool.
+// stream-copy concat when the parts match, else the stages above (normalize, then join
+// and remux in one streamed pass).
 static bool VC_CombineVideos(CombineTask* task,
     const std::vector<std::string>& srcfn,
     std::string& finalfile)
 {
     bool retval = false;
     std::vector<std::string> mpgfn;
-    std::string combinefile;
-    char drive[260];
-    char path[260];
-    char fn[260];
 
     int limit = (int)srcfn.size();
     if (limit == 0) return false;
@@ -4697,20 +10162,17 @@ static bool VC_CombineVideos(CombineTask* task,
     std::wstring wFinal = WideFromNarrowACP(finalfile);
     VC_LogMsg(task, L"Start Combining Video " + wFinal + L"\r\n");
 
+    if (VC_ConcatCopy(task, srcfn, finalfile)) {
+        VC_LogMsg(task, L"Video combined successful for " + wFinal + L" (stream copy)\r\n");
+        return true;
+    }
+
     if (convert2mpg(srcfn, mpgfn, task)) {
-        _splitpath(finalfile.c_str(), drive, path, fn, NULL);
-        combinefile = drive;
-        combinefile += path;
-        combinefile += fn;
-        combinefile += ".mpg";
-
-        if (combinempg(mpgfn, combinefile, task)) {
-            if (convertback(combinefile, finalfile, task)) {
-                VC_LogMsg(task, L"Video combined successful for " + wFinal + L"\r\n");
-                retval = true;
-                _unlink(combinefile.c_str());
-            }
+        if (convertback(mpgfn, finalfile, VC_TotalDurationMs(srcfn), task)) {
+            VC_LogMsg(task, L"Video combined successful for " + wFinal + L"\r\n");
+            retval = true;
         }
+        for (const auto& part : mpgfn) _unlink(part.c_str());
     }
 
     if (!retval) {
@@ -4720,17 +10182,17 @@ static bool VC_CombineVideos(CombineTask* task,
     return retval;
 }
 
-// Run the embedded video_combine algorithm using the copied .mp4/.mkv files
+// Run the embedded video_combine algorithm on the source files (read in place)
 // and the intended user-chosen output name (combinedFull).
 static bool RunEmbeddedVideoCombine(CombineTask* task,
-    const std::vector<std::wstring>& copiedFiles,
+    const std::vector<std::wstring>& srcFiles,
     const std::wstring& combinedFull)
 {
     // Build ANSI source list with duplicate check...
     std::vector<std::string> srcAnsi;
-    srcAnsi.reserve(copiedFiles.size());
+    srcAnsi.reserve(srcFiles.size());
 
-    for (const auto& wf : copiedFiles) {
+    for (const auto& wf : srcFiles) {
         std::string a = NarrowFromWideACP(wf);
         if (a.empty()) continue;
         if (nodup_add(srcAnsi, a)) {
@@ -4753,7 +10215,18 @@ static bool RunEmbeddedVideoCombine(CombineTask* task,
     // Show ffmpeg progress in the combine window title while we work
     VC_UpdateCombineWindowTitle(task, L"(ffmpeg in progress...)");
 
-    bool ok = VC_CombineVideos(task, srcAnsi, finalfile);
+    // ffmpeg writes the temp; an existing output is only replaced by a finished one
+    std::string tempfile = NarrowFromWideACP(task->outputTemp);
+    bool ok = VC_CombineVideos(task, srcAnsi, tempfile);
+    const std::wstring wTemp = WideFromNarrowACP(tempfile), wFinal = WideFromNarrowACP(finalfile);
+    if (ok && !MoveFileExW(wTemp.c_str(), wFinal.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        wchar_t err[64];
+        swprintf_s(err, L" (err=%lu)\r\n", GetLastError());
+        VC_LogMsg(task, L"Cannot replace " + wFinal + err);
+        ok = false;
+    }
+    if (ok) VC_LogMsg(task, L"Saved as " + wFinal + L"\r\n");
+    else DeleteFileW(wTemp.c_str());
 
     // Update task->combinedFull to the actual final path (with _combined suffix)
     if (ok) {
@@ -4764,33 +10237,15 @@ static bool RunEmbeddedVideoCombine(CombineTask* task,
     return ok;
 }
 
-// Delete the combine working directory and its files (shallow) on success.
+// Delete the intermediates this job wrote, then the working directory if the job created it
+// (RemoveDirectoryW only succeeds on an empty folder, so anything else in it is left alone).
 static void DeleteCombineWorkingDirIfExists(CombineTask* task) {
     if (!task) return;
-    if (task->workingDir.empty()) return;
+    for (const auto& f : task->workFiles) DeleteFileW(f.c_str());
+    task->workFiles.clear();
+    if (task->workingDir.empty() || !task->workingDirCreated) return;
 
     std::wstring dir = task->workingDir;
-
-    // Ensure trailing slash for building file paths
-    std::wstring pattern = EnsureSlash(dir) + L"*";
-    WIN32_FIND_DATAW fd{};
-    HANDLE hFind = FindFirstFileW(pattern.c_str(), &fd);
-    if (hFind != INVALID_HANDLE_VALUE) {
-        do {
-            if (wcscmp(fd.cFileName, L".") == 0 || wcscmp(fd.cFileName, L"..") == 0)
-                continue;
-
-            std::wstring full = EnsureSlash(dir) + fd.cFileName;
-
-            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-                // Working dir should be flat; skip any subdirs just in case.
-                continue;
-            }
-            DeleteFileW(full.c_str());
-        } while (FindNextFileW(hFind, &fd));
-        FindClose(hFind);
-    }
-
     if (!RemoveDirectoryW(dir.c_str())) {
         DWORD err = GetLastError();
         wchar_t buf[512];
@@ -4806,81 +10261,40 @@ static void DeleteCombineWorkingDirIfExists(CombineTask* task) {
     }
 }
 
-static DWORD WINAPI CombineThreadProc(LPVOID param) {
+static DWORD WINAPI CombineJobProc(LPVOID param) {
     CombineTask* task = (CombineTask*)param;
     if (!task) return 0;
 
-    // Create working directory
-    if (!CreateDirectoryW(task->workingDir.c_str(), NULL)) {
-        DWORD e = GetLastError();
-        if (e != ERROR_ALREADY_EXISTS) {
-            std::wstring msg = L"ERROR: Failed to create working directory:\r\n";
-            msg += task->workingDir;
-            msg += L"\r\n";
-            PostCombineOutput(task, msg);
-            PostMessageW(g_hwndMain, WM_APP_COMBINE_DONE, (WPARAM)task, (LPARAM)1);
-            return 0;
-        }
-    }
-
-    // Copy files into working directory (same as before)
-    {
-        wchar_t buf[256];
-        swprintf_s(buf, L"Copying %zu file(s)...\r\n", task->srcFiles.size());
-        PostCombineOutput(task, buf);
-    }
-
-    std::vector<std::wstring> copiedFiles;
-    copiedFiles.reserve(task->srcFiles.size());
-
-    for (size_t i = 0; i < task->srcFiles.size(); ++i) {
-        const std::wstring& src = task->srcFiles[i];
-        const wchar_t* base = wcsrchr(src.c_str(), L'\\');
-        base = base ? base + 1 : src.c_str();
-
-        // Make destination unique inside the working directory (important for Search view)
-        wchar_t fname[_MAX_FNAME] = {}, ext[_MAX_EXT] = {};
-        _wsplitpath_s(base, NULL, 0, NULL, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
-
-        std::wstring dstFolder = EnsureSlash(task->workingDir);
-        std::wstring dst = UniqueName(dstFolder, fname, ext);
-
-        std::wstring line = L"  -> ";
-        line += dst;
-        line += L"\r\n";
-        PostCombineOutput(task, line);
-
-        if (!CopyFileW(src.c_str(), dst.c_str(), FALSE)) {
-            std::wstring err = L"ERROR: Failed to copy file:\r\n";
-            err += src;
-            err += L"\r\n";
-            PostCombineOutput(task, err);
-            PostMessageW(g_hwndMain, WM_APP_COMBINE_DONE, (WPARAM)task, (LPARAM)2);
-            return 0;
-        }
-        copiedFiles.push_back(dst);
+    // Working directory for intermediates only; the sources are read where they are
+    int rc = SHCreateDirectoryExW(NULL, task->workingDir.c_str(), NULL);
+    task->workingDirCreated = rc == ERROR_SUCCESS;
+    if (rc != ERROR_SUCCESS && rc != ERROR_ALREADY_EXISTS && rc != ERROR_FILE_EXISTS) {
+        std::wstring msg = L"ERROR: Failed to create working directory:\r\n";
+        msg += task->workingDir;
+        msg += L"\r\n";
+        PostCombineOutput(task, msg);
+        return 1;
     }
+    task->statusId = StatusOpBegin(L"Combine: " + task->title);
 
-    PostCombineOutput(task, L"All files copied. Combining via internal ffmpeg pipeline...\r\n");
+    PostCombineOutput(task, L"Combining via internal ffmpeg pipeline (sources read in place)...\r\n");
 
-    // --- NEW: run embedded video_combine algorithm instead of video_combine.exe ---
-    bool ok = RunEmbeddedVideoCombine(task, copiedFiles, task->combinedFull);
+    bool ok = RunEmbeddedVideoCombine(task, task->srcFiles, task->combinedFull);
 
     DWORD exitCode = ok ? 0 : 1;
 
-    // On success, remove the working directory that held the copied parts
-    if (ok) {
-        DeleteCombineWorkingDirIfExists(task);
-    }
+    // Only this job's intermediates (and the folder, if it made it) go, either way
+    DeleteCombineWorkingDirIfExists(task);
+    StatusOpEnd(task->statusId);
+    task->statusId = 0;
 
     wchar_t doneMsg[256];
     swprintf_s(doneMsg, L"\r\n[internal video combine %s with code %lu]\r\n",
         ok ? L"succeeded" : L"failed", exitCode);
     PostCombineOutput(task, doneMsg);
 
-    // Notify main window that the combine task is done (same message ID as before)
-    PostMessageW(g_hwndMain, WM_APP_COMBINE_DONE, (WPARAM)task, (LPARAM)exitCode);
-    return 0;
+    // The scheduler posts WM_APP_JOB_DONE with this code
+    return exitCode;
 }
 
 
@@ -5257,6 +10671,24 @@ static LRESULT CALLBACK ListSubclass(HWND h, UINT m, WPARAM w, LPARAM l,
             return 0;
         }
 
+        // Thumbnail column: Ctrl+T
+        if (ctrl && w == 'T') {
+            ToggleThumbnails();
+            return 0;
+        }
+
+        // Similar-video finder: Ctrl+S
+        if (ctrl && w == 'S') {
+            Browser_FindSimilar();
+            return 0;
+        }
+
+        // Exact duplicate finder: Ctrl+D
+        if (ctrl && w == 'D') {
+            Browser_FindDuplicates();
+            return 0;
+        }
+
         switch (w) {
         case VK_ESCAPE: CancelMostRecentFileOpTask(); return 0;
 
@@ -5266,6 +10698,10 @@ static LRESULT CALLBACK ListSubclass(HWND h, UINT m, WPARAM w, LPARAM l,
         case VK_F1:     ShowHelp(); return 0;
 
         case 'A':
+            if (ctrl && g_view == ViewKind::Search && !g_search.groupLabel.empty()) {
+                SelectAllButFirstPerGroup();
+                return 0;
+            }
             if (ctrl) {
                 for (int i = 0; i < (int)g_rows.size(); ++i) {
                     if (!g_rows[i].isDir) {
@@ -5300,6 +10736,7 @@ static LRESULT CALLBACK ListSubclass(HWND h, UINT m, WPARAM w, LPARAM l,
                     g_search.useExplicitScope = false;
                     g_search.explicitFolders.clear();
                     g_search.explicitFiles.clear();
+                    g_search.groupLabel.clear();
 
                     std::vector<std::wstring> selFolders, selFiles;
                     CollectSelection(selFolders, selFiles);
@@ -5318,7 +10755,8 @@ static LRESULT CALLBACK ListSubclass(HWND h, UINT m, WPARAM w, LPARAM l,
                     std::vector<Row> filtered;
                     filtered.reserve(g_rows.size());
                     for (size_t i = 0; i < g_rows.size(); ++i) {
-                        if (NameContainsAllTerms(g_rows[i].full, g_search.termsLower))
+                        if (NameContainsAllTerms(g_rows[i].full, g_search.termsLower) &&
+                            RowMatchesFieldTerms(g_rows[i], g_search.termsLower))
                             filtered.push_back(g_rows[i]);
                     }
                     ShowSearchResults(filtered);
@@ -5390,83 +10828,88 @@ static void ScheduleFfmpegTask(FfmpegOpKind kind) {
     libvlc_time_t refMs = libvlc_media_player_get_time(g_mp);
     if (refMs < 0) refMs = 0;
 
-    // Determine folder + base + ext
-    std::wstring folder = cur;
-    PathRemoveFileSpecW(&folder[0]);
-    folder = folder.c_str(); // shrink
-    folder = EnsureSlash(folder);
-
-    std::wstring workingDir = folder + L"video_process\\";
-
-    const wchar_t* baseName = wcsrchr(cur.c_str(), L'\\');
-    baseName = baseName ? baseName + 1 : cur.c_str();
-
-    wchar_t fname[_MAX_FNAME] = {}, ext[_MAX_EXT] = {};
-    _wsplitpath_s(baseName, NULL, 0, NULL, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
-
-    std::wstring inputCopy = workingDir;
-    inputCopy += fname;
-    inputCopy += ext;
-
-    std::wstring outputTemp = workingDir;
-    outputTemp += fname;
-    switch (kind) {
-    case FfmpegOpKind::TrimFront: outputTemp += L"_trimfront"; break;
-    case FfmpegOpKind::TrimEnd:   outputTemp += L"_trimend";   break;
-    case FfmpegOpKind::HFlip:     outputTemp += L"_hflip";     break;
-    }
-    outputTemp += ext;
-
-    FfmpegTask* task = new FfmpegTask();
-    task->sourceFull = cur;
-    task->workingDir = workingDir;
-    task->inputCopy = inputCopy;
-    task->outputTemp = outputTemp;
-    task->refMs = refMs;
-    task->kind = kind;
-    task->running = true;
-
-    LogLine(L"FFmpegTask scheduled: kind=%d src=\"%s\" refMs=%lld workingDir=\"%s\"",
-        (int)kind, cur.c_str(), (long long)refMs, workingDir.c_str());
-
-    // Title for the log window
-    switch (kind) {
-    case FfmpegOpKind::TrimFront: task->title = L"Trim front: "; break;
-    case FfmpegOpKind::TrimEnd:   task->title = L"Trim end: ";   break;
-    case FfmpegOpKind::HFlip:     task->title = L"Horizontal flip: "; break;
+    // Edits join the open plan of the file being played; nothing runs until playback leaves it
+    FfmpegTask* task = nullptr;
+    EnterCriticalSection(&g_ffLock);
+    for (FfmpegTask* t : g_ffTasks) {
+        if (t && !t->submitted && _wcsicmp(t->sourceFull.c_str(), cur.c_str()) == 0) { task = t; break; }
     }
-    task->title += baseName;
+    LeaveCriticalSection(&g_ffLock);
 
-    EnsureFfmpegLogClass();
-    HWND logWnd = CreateFfmpegLogWindow(task);
-    if (!logWnd) {
-        delete task;
-        MessageBoxW(g_hwndMain, L"Failed to create FFmpeg task log window.",
-            L"FFmpeg tools", MB_OK);
-        return;
-    }
-    task->hwnd = logWnd;
+    if (!task) {
+        // Determine folder + base + ext
+        std::wstring folder = cur;
+        PathRemoveFileSpecW(&folder[0]);
+        folder = folder.c_str(); // shrink
+        folder = EnsureSlash(folder);
 
-    EnterCriticalSection(&g_ffLock);
-    g_ffTasks.push_back(task);
-    LeaveCriticalSection(&g_ffLock);
+        const wchar_t* baseName = wcsrchr(cur.c_str(), L'\\');
+        baseName = baseName ? baseName + 1 : cur.c_str();
+
+        wchar_t fname[_MAX_FNAME] = {}, ext[_MAX_EXT] = {};
+        _wsplitpath_s(baseName, NULL, 0, NULL, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
+
+        // Temp output in the source's own folder (same volume: publishing is a rename), unique per
+        // process and plan; the real extension stays last so ffmpeg picks the same muxer
+        static unsigned s_tempSeq = 0;
+        wchar_t tag[64];
+        swprintf_s(tag, L".metmp-%lu-%u-edit", GetCurrentProcessId(), ++s_tempSeq);
+
+        task = new FfmpegTask();
+        task->sourceFull = cur;
+        task->outputTemp = folder + fname + tag + ext;
+        task->title = L"Edits: ";
+        task->title += baseName;
+
+        EnsureFfmpegLogClass();
+        HWND logWnd = CreateFfmpegLogWindow(task);
+        if (!logWnd) {
+            delete task;
+            MessageBoxW(g_hwndMain, L"Failed to create FFmpeg task log window.",
+                L"FFmpeg tools", MB_OK);
+            return;
+        }
+        task->hwnd = logWnd;
 
-    HANDLE hThread = CreateThread(NULL, 0, FfmpegThreadProc, task, 0, NULL);
-    if (!hThread) {
         EnterCriticalSection(&g_ffLock);
-        auto it = std::find(g_ffTasks.begin(), g_ffTasks.end(), task);
-        if (it != g_ffTasks.end()) g_ffTasks.erase(it);
+        g_ffTasks.push_back(task);
         LeaveCriticalSection(&g_ffLock);
-
-        if (IsWindow(task->hwnd)) DestroyWindow(task->hwnd);
-        delete task;
-
-        MessageBoxW(g_hwndMain, L"Failed to start background thread for FFmpeg task.",
-            L"FFmpeg tools", MB_OK);
-        return;
+        FfTempListSave();   // before ffmpeg can create the temp
+        LogLine(L"FFmpegTask plan opened: src=\"%s\" outputTemp=\"%s\"", cur.c_str(), task->outputTemp.c_str());
     }
 
-    task->hThread = hThread;
+    // Merge the edit (the plan is only touched here until it is submitted)
+    wchar_t at[64];
+    swprintf_s(at, L"%.3f s", (double)refMs / 1000.0);
+    std::wstring note;
+    switch (kind) {
+    case FfmpegOpKind::TrimFront:
+        if (task->keepToMs >= 0 && refMs >= task->keepToMs) {
+            note = std::wstring(L"Ignored: trim front at ") + at + L" is not before the trim end.";
+            break;
+        }
+        task->keepFromMs = refMs;
+        note = std::wstring(L"Queued: trim front at ") + at;
+        break;
+    case FfmpegOpKind::TrimEnd:
+        if (refMs <= task->keepFromMs) {
+            note = std::wstring(L"Ignored: trim end at ") + at + L" is not after the trim front.";
+            break;
+        }
+        task->keepToMs = refMs;
+        note = std::wstring(L"Queued: trim end at ") + at;
+        break;
+    case FfmpegOpKind::HFlip:
+    case FfmpegOpKind::HFlipBake:
+        task->hflip = !task->hflip;
+        if (kind == FfmpegOpKind::HFlipBake) task->bakeFlip = true;
+        note = task->hflip ? L"Queued: horizontal flip" : L"Queued: flip again (cancels the earlier flip)";
+        if (task->hflip && task->bakeFlip) note += L" (baked in)";
+        break;
+    }
+    PostFfmpegOutput(task, note + L"\r\n");
+    LogLine(L"FFmpegTask edit: kind=%d src=\"%s\" refMs=%lld -> %s",
+        (int)kind, cur.c_str(), (long long)refMs, FfmpegPlanText(task).c_str());
 }
 
 static LRESULT CALLBACK VideoSubclass(HWND h, UINT m, WPARAM w, LPARAM l,
@@ -5513,6 +10956,9 @@ static LRESULT CALLBACK VideoSubclass(HWND h, UINT m, WPARAM w, LPARAM l,
                 else if (choice == 4 && canFfmpeg) {
                     ScheduleFfmpegTask(FfmpegOpKind::HFlip);
                 }
+                else if (choice == 5 && canFfmpeg) {
+                    ScheduleFfmpegTask(FfmpegOpKind::HFlipBake);
+                }
 
                 if (wasPlaying) libvlc_media_player_set_pause(g_mp, 0);
                 return 0;
@@ -5577,12 +11023,13 @@ static LRESULT CALLBACK VideoSubclass(HWND h, UINT m, WPARAM w, LPARAM l,
         case VK_RIGHT: {
             if (ctrl) { if (w == VK_RIGHT) NextInPlaylist(); else PrevInPlaylist(); }
             else {
-                libvlc_time_t cur = libvlc_media_player_get_time(g_mp);
+                const libvlc_time_t from = libvlc_media_player_get_time(g_mp);
+                libvlc_time_t cur = from;
                 libvlc_time_t len = libvlc_media_player_get_length(g_mp);
                 libvlc_time_t step = shift ? 60000 : 10000; // 60s / 10s
                 if (w == VK_RIGHT) cur += step; else cur = (cur > step ? cur - step : 0);
                 if (len > 0 && cur > len) cur = len;
-                libvlc_media_player_set_time(g_mp, cur);
+                libvlc_media_player_set_time(g_mp, SnapSeekToKeyframe(g_playlist[g_playlistIndex], from, cur));
             }
             return 0;
         }
@@ -5640,6 +11087,74 @@ static HICON LoadAppIcon(int cx, int cy) {
 }
 
 // ----------------------------- Window proc
+// ----------------------------- Job completion (UI thread, from WM_APP_JOB_DONE)
+static void OnFfmpegDone(FfmpegTask* task, DWORD exitCode) {
+    EnterCriticalSection(&g_ffLock);
+    for (FfmpegTask* t : g_ffTasks) {
+        if (t == task) {
+            t->running = false;
+            t->done = true;
+            t->exitCode = exitCode;
+            break;
+        }
+    }
+    LeaveCriticalSection(&g_ffLock);
+}
+
+static void OnCombineDone(CombineTask* task, DWORD exitCode) {
+    const bool success = (exitCode == 0);
+
+    // Mark not running (and optionally remove on success); the job renamed or removed its temp
+    EnterCriticalSection(&g_combineLock);
+    auto it = std::find(g_combineTasks.begin(), g_combineTasks.end(), task);
+    if (it != g_combineTasks.end()) {
+        (*it)->running = false;
+        (*it)->outputTemp.clear();
+        if (success) {
+            g_combineTasks.erase(it);
+        }
+    }
+    LeaveCriticalSection(&g_combineLock);
+    FfTempListSave();
+
+    // Close handles
+    if (task) {
+        if (task->hProcess) { CloseHandle(task->hProcess); task->hProcess = NULL; }
+    }
+
+    if (task && success) {
+        // Auto-close the log window on success
+        if (task->hwnd && IsWindow(task->hwnd)) {
+            DestroyWindow(task->hwnd);   // NOTE: DestroyWindow (not WM_CLOSE) bypasses your SW_HIDE behavior
+        }
+        task->hwnd = NULL;
+        task->hEdit = NULL;
+
+        delete task;
+        task = NULL;
+    }
+    else if (task && !success) {
+        // On failure, keep the window so the user can read the log.
+        if (task->hwnd && IsWindow(task->hwnd)) {
+            ShowWindow(task->hwnd, SW_SHOWNOACTIVATE);
+            SetWindowPos(task->hwnd, HWND_TOP, 0, 0, 0, 0,
+                SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+        }
+    }
+
+    // Refresh only when NOT in playback (prevents messing with playback UI)
+    if (!g_inPlayback) {
+        if (g_view == ViewKind::Folder) {
+            ShowFolder(g_folder);
+        }
+        else if (g_view == ViewKind::Search && g_search.active) {
+            std::vector<Row> res;
+            RunSearchFromOrigin(res);
+            ShowSearchResults(res);
+        }
+    }
+}
+
 LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
 {
     // keep your existing code unchanged by providing aliases:
@@ -5671,6 +11186,23 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
         InitializeCriticalSection(&g_metaLock);
         InitializeCriticalSection(&g_combineLock);
         InitializeCriticalSection(&g_ffLock);   // NEW
+        InitializeCriticalSection(&g_jobLock);
+        InitializeCriticalSection(&g_spawnLock);
+        InitializeConditionVariable(&g_jobWake);
+        g_jobChildren = CreateJobObjectW(NULL, NULL);
+        if (g_jobChildren) {
+            JOBOBJECT_EXTENDED_LIMIT_INFORMATION li{};
+            li.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE; // also on a crash
+            SetInformationJobObject(g_jobChildren, JobObjectExtendedLimitInformation, &li, sizeof(li));
+        }
+        InitializeCriticalSection(&g_metaCacheLock);
+        InitializeCriticalSection(&g_kfLock);
+        InitializeCriticalSection(&g_dirAggLock);
+        MetaCacheLoad();
+        FfTempRecoverOrphans();
+        InitializeCriticalSection(&g_thumbLock);
+        g_thumbJob = CreateJobObjectW(NULL, NULL);
+        if (g_cfg.ffmpegAvailable) ThumbCacheOpen();
 
         g_hwndList = CreateWindowExW(WS_EX_CLIENTEDGE, WC_LISTVIEWW, L"",
             WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SHOWSELALWAYS,
@@ -5679,6 +11211,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
             LVS_EX_FULLROWSELECT | LVS_EX_DOUBLEBUFFER | LVS_EX_GRIDLINES | LVS_EX_LABELTIP);
         LV_ResetColumns();
         SetWindowSubclass(g_hwndList, ListSubclass, 1, 0);
+        if (g_cfg.thumbnails) ToggleThumbnails(); // starts off; turn on per config
 
         g_hwndVideo = CreateWindowExW(0, L"STATIC", L"",
             WS_CHILD | WS_CLIPSIBLINGS | WS_CLIPCHILDREN,
@@ -5744,6 +11277,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
                 SortRows(g_sortCol, g_sortAsc);
                 SendMessageW(g_hwndList, WM_SETREDRAW, TRUE, 0);
                 InvalidateRect(g_hwndList, NULL, TRUE);
+                ThumbPrioritizeVisible();
+                return 0;
+            }
+            if (nm->code == LVN_ENDSCROLL) {
+                ThumbPrioritizeVisible(); // viewport first
                 return 0;
             }
         }
@@ -5758,8 +11296,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
             }
             else if (code == TB_ENDTRACK || code == TB_THUMBPOSITION) {
                 g_userDragging = false;
-                LRESULT pos = SendMessageW(g_hwndSeek, TBM_GETPOS, 0, 0);
-                libvlc_media_player_set_time(g_mp, (libvlc_time_t)pos);
+                const libvlc_time_t pos = (libvlc_time_t)SendMessageW(g_hwndSeek, TBM_GETPOS, 0, 0);
+                libvlc_media_player_set_time(g_mp, SnapSeekToKeyframe(g_playlist[g_playlistIndex], pos, pos));
             }
             return 0;
         }
@@ -5789,29 +11327,52 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
         if (g_inPlayback) { SendMessageW(g_hwndVideo, WM_KEYDOWN, w, l); return 0; }
         break;
 
+    case WM_APP_MIRROR: {
+        std::unique_ptr<std::wstring> path((std::wstring*)l);
+        if (!path || !g_inPlayback || !g_mp || g_playlistIndex >= g_playlist.size()) return 0;
+        if (_wcsicmp(g_playlist[g_playlistIndex].c_str(), path->c_str()) != 0) return 0;
+        PlayLoadMedia(*path, true, libvlc_media_player_get_time(g_mp));
+        return 0;
+    }
+
     case WM_APP + 1: // VLC: end reached
         if (g_inPlayback && g_playlistIndex + 1 < g_playlist.size()) NextInPlaylist();
         else if (g_inPlayback) ExitPlayback();
         return 0;
 
-    case WM_APP_FILEOP_OUTPUT: {
-        FileOpTask* task = (FileOpTask*)w;
-        std::wstring* p = (std::wstring*)l;
-        if (task && task->hEdit && IsWindow(task->hEdit) && p) {
-            HWND edit = task->hEdit;
+    case WM_APP_JOB_OUTPUT: {
+        JobEvent* ev = (JobEvent*)l;
+        if (!ev) return 0;
+        HWND edit = NULL;
+        const wchar_t* tag = NULL;  // mirrored to the main log file (if loggingEnabled)
+        switch (ev->kind) {
+        case JobKind::FileOp:  edit = ((FileOpTask*)ev->owner)->hEdit;  tag = L"FileOp"; break;
+        case JobKind::Ffmpeg:  edit = ((FfmpegTask*)ev->owner)->hEdit;  break;
+        case JobKind::Combine: edit = ((CombineTask*)ev->owner)->hEdit; tag = L"Combine"; break;
+        default: break;
+        }
+        if (edit && IsWindow(edit)) {
             SendMessageW(edit, EM_SETSEL, (WPARAM)-1, (LPARAM)-1);
-            SendMessageW(edit, EM_REPLACESEL, FALSE, (LPARAM)p->c_str());
+            SendMessageW(edit, EM_REPLACESEL, FALSE, (LPARAM)ev->text.c_str());
             SendMessageW(edit, EM_SCROLLCARET, 0, 0);
         }
-        if (p && !p->empty()) {
-            LogLine(L"[FileOp] %s", p->c_str());
+        if (tag && !ev->text.empty()) {
+            LogLine(L"[%s] %s", tag, ev->text.c_str());
         }
-        delete p;
+        delete ev;
         return 0;
     }
 
-    case WM_APP_FILEOP_DONE: {
-        OnFileOpDone((FileOpTask*)w, (DWORD)l);
+    case WM_APP_JOB_DONE: {
+        JobEvent* ev = (JobEvent*)l;
+        if (!ev) return 0;
+        switch (ev->kind) {
+        case JobKind::FileOp:  OnFileOpDone((FileOpTask*)ev->owner, ev->rc); break;
+        case JobKind::Ffmpeg:  OnFfmpegDone((FfmpegTask*)ev->owner, ev->rc); break;
+        case JobKind::Combine: OnCombineDone((CombineTask*)ev->owner, ev->rc); break;
+        default: break;
+        }
+        delete ev;
         return 0;
     }
 
@@ -5830,6 +11391,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
 
         if (accept && res->rows) {
             CancelMetaWorkAndClearTodo();
+            CancelThumbWorkAndClearTodo();
+            CancelDirAggWork();
 
             g_rows.swap(*res->rows);
 
@@ -5845,6 +11408,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
             InvalidateRect(g_hwndList, NULL, TRUE);
 
             QueueMissingPropsAndKickWorker();
+            QueueThumbsAndKickWorkers();
+            QueueDirAggregates();
             SetTitleFolderOrDrives();
         }
 
@@ -5854,153 +11419,114 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
     }
 
     case WM_APP_META: {
-        MetaResult* r = (MetaResult*)l;
-        if (r) {
-            if (r->gen == g_metaGen.load(std::memory_order_relaxed)) {
+        std::vector<MetaResult>* batch = (std::vector<MetaResult>*)l;
+        if (batch) {
+            if (!batch->empty() && batch->front().gen == g_metaGen.load(std::memory_order_relaxed)) {
+                // one path->row index per batch instead of a scan per result
+                std::unordered_map<std::wstring, int> index;
                 for (int i = 0; i < (int)g_rows.size(); ++i) {
-                    if (_wcsicmp(g_rows[i].full.c_str(), r->path.c_str()) == 0) {
-                        Row& it = g_rows[i];
-                        it.vW = r->w; it.vH = r->h; it.vDur100ns = r->dur;
-                        if (!it.isDir) {
-                            if (it.vW > 0 && it.vH > 0) {
-                                wchar_t buf[64]; swprintf_s(buf, L"%dx%d", it.vW, it.vH);
-                                ListView_SetItemText(g_hwndList, i, 4, buf);
-                            }
-                            if (it.vDur100ns > 0) {
-                                std::wstring ds = FormatDuration100ns(it.vDur100ns);
-                                ListView_SetItemText(g_hwndList, i, 5, const_cast<wchar_t*>(ds.c_str()));
-                            }
-                        }
-                        break;
+                    if (!g_rows[i].isDir) index[ToLower(g_rows[i].full)] = i;
+                }
+                // Search rows kept provisionally by a field term are checked again now
+                const bool refilter = g_view == ViewKind::Search && g_search.active && g_search.groupLabel.empty();
+                std::vector<std::wstring> failed;
+                for (const MetaResult* r = batch->data(); r != batch->data() + batch->size(); ++r) {
+                    auto found = index.find(ToLower(r->path));
+                    if (found == index.end()) continue;
+                    int i = found->second;
+                    Row& it = g_rows[i];
+                    it.vW = r->w; it.vH = r->h; it.vDur100ns = r->dur;
+                    if (it.vW > 0 && it.vH > 0) {
+                        wchar_t buf[64]; swprintf_s(buf, L"%dx%d", it.vW, it.vH);
+                        ListView_SetItemText(g_hwndList, i, 4, buf);
+                    }
+                    if (it.vDur100ns > 0) {
+                        std::wstring ds = FormatDuration100ns(it.vDur100ns);
+                        ListView_SetItemText(g_hwndList, i, 5, const_cast<wchar_t*>(ds.c_str()));
                     }
+                    if (r->extProbed) {
+                        it.extProbed = true;
+                        it.vCodec = r->vCodec; it.aCodec = r->aCodec; it.container = r->container;
+                        it.bitrate = r->bitrate; it.fpsMilli = r->fpsMilli; it.aChannels = r->aChannels;
+                        LV_SetExtendedCells(i, it);
+                    }
+                    if (refilter && !RowMatchesFieldTerms(it, g_search.termsLower)) failed.push_back(it.full);
                 }
+                RemoveRowsForPaths(failed);
             }
-            delete r;
-        }
-        return 0;
-    }
-
-    case WMU_STATUS_OP:
-    {
-        std::unique_ptr<StatusOpMsg> msg((StatusOpMsg*)lParam);
-
-        switch (msg->action)
-        {
-        case StatusOpAction::Begin:  g_statusOps.begin(msg->id, std::move(msg->text)); break;
-        case StatusOpAction::Update: g_statusOps.update(msg->id, std::move(msg->text)); break;
-        case StatusOpAction::End:    g_statusOps.end(msg->id); break;
+            delete batch;
         }
-        RefreshStatusBar();
         return 0;
     }
 
-
-    case WM_APP_FFMPEG_OUTPUT: {
-        FfmpegTask* task = (FfmpegTask*)w;
-        std::wstring* p = (std::wstring*)l;
-        if (task && task->hEdit && p) {
-            HWND edit = task->hEdit;
-            SendMessageW(edit, EM_SETSEL, (WPARAM)-1, (LPARAM)-1);
-            SendMessageW(edit, EM_REPLACESEL, FALSE, (LPARAM)p->c_str());
-            SendMessageW(edit, EM_SCROLLCARET, 0, 0);
+    case WM_APP_DIRAGG: {
+        std::unique_ptr<DirAggResult> r((DirAggResult*)l);
+        if (!r || r->gen != g_dirAggGen.load(std::memory_order_relaxed)) return 0;
+        for (int i = 0; i < (int)g_rows.size(); ++i) {
+            Row& it = g_rows[i];
+            if (!it.isDir || _wcsicmp(it.full.c_str(), r->path.c_str()) != 0) continue;
+            it.size = r->bytes;
+            it.vDur100ns = r->dur;
+            it.aggVideos = r->videos;
+            it.aggDone = true;
+            it.aggPartial = r->partial;
+            LV_UpdateRow(i, it);
+            break;
         }
-        delete p;
         return 0;
     }
 
-    case WM_APP_FFMPEG_DONE: {
-        FfmpegTask* task = (FfmpegTask*)w;
-        DWORD exitCode = (DWORD)l;
-        UNREFERENCED_PARAMETER(exitCode);
-
-        EnterCriticalSection(&g_ffLock);
-        for (FfmpegTask* t : g_ffTasks) {
-            if (t == task) {
-                t->running = false;
-                t->done = true;
-                t->exitCode = exitCode;
+    case WM_APP_THUMB: {
+        std::unique_ptr<ThumbResult> r((ThumbResult*)l);
+        if (!r || !g_thumbsOn || !g_thumbImages) return 0;
+        if (r->gen != g_thumbGen.load(std::memory_order_relaxed)) return 0;
+        if (r->bgr.size() != kThumbBytes) return 0;
+
+        BITMAPINFO bi{};
+        bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bi.bmiHeader.biWidth = kThumbW;
+        bi.bmiHeader.biHeight = -kThumbH; // top-down, as ffmpeg writes it
+        bi.bmiHeader.biPlanes = 1;
+        bi.bmiHeader.biBitCount = 24;
+        bi.bmiHeader.biCompression = BI_RGB;
+        void* bits = NULL;
+        HBITMAP hbm = CreateDIBSection(NULL, &bi, DIB_RGB_COLORS, &bits, NULL, 0);
+        if (!hbm || !bits) return 0;
+        memcpy(bits, r->bgr.data(), kThumbBytes);
+        int img = ImageList_Add(g_thumbImages, hbm, NULL);
+        DeleteObject(hbm);
+        if (img < 0) return 0;
+
+        g_thumbImageOfPath[ToLower(r->path)] = img;
+        for (int i = 0; i < (int)g_rows.size(); ++i) {
+            if (_wcsicmp(g_rows[i].full.c_str(), r->path.c_str()) == 0) {
+                LVITEMW it{};
+                it.mask = LVIF_IMAGE;
+                it.iItem = i;
+                it.iImage = img;
+                ListView_SetItem(g_hwndList, &it);
                 break;
             }
         }
-        LeaveCriticalSection(&g_ffLock);
-        return 0;
-    }
-
-    case WM_APP_COMBINE_OUTPUT: {
-        CombineTask* task = (CombineTask*)w;
-        std::wstring* p = (std::wstring*)l;
-        if (task && task->hEdit && p) {
-            HWND edit = task->hEdit;
-            SendMessageW(edit, EM_SETSEL, (WPARAM)-1, (LPARAM)-1);
-            SendMessageW(edit, EM_REPLACESEL, FALSE, (LPARAM)p->c_str());
-            SendMessageW(edit, EM_SCROLLCARET, 0, 0);
-        }
-        if (p && !p->empty()) {
-            // Mirror to main log file (if loggingEnabled)
-            LogLine(L"[Combine] %s", p->c_str());
-        }
-        delete p;
         return 0;
     }
 
-    case WM_APP_COMBINE_DONE: {
-        CombineTask* task = (CombineTask*)w;
-        DWORD exitCode = (DWORD)l;
-
-        const bool success = (exitCode == 0);
-
-        // Mark not running (and optionally remove on success)
-        EnterCriticalSection(&g_combineLock);
-        auto it = std::find(g_combineTasks.begin(), g_combineTasks.end(), task);
-        if (it != g_combineTasks.end()) {
-            (*it)->running = false;
-            if (success) {
-                g_combineTasks.erase(it);
-            }
-        }
-        LeaveCriticalSection(&g_combineLock);
-
-        // Close handles
-        if (task) {
-            if (task->hProcess) { CloseHandle(task->hProcess); task->hProcess = NULL; }
-            if (task->hThread) { CloseHandle(task->hThread);  task->hThread = NULL; }
-        }
-
-        if (task && success) {
-            // Auto-close the log window on success
-            if (task->hwnd && IsWindow(task->hwnd)) {
-                DestroyWindow(task->hwnd);   // NOTE: DestroyWindow (not WM_CLOSE) bypasses your SW_HIDE behavior
-            }
-            task->hwnd = NULL;
-            task->hEdit = NULL;
-
-            delete task;
-            task = NULL;
-        }
-        else if (task && !success) {
-            // On failure, keep the window so the user can read the log.
-            if (task->hwnd && IsWindow(task->hwnd)) {
-                ShowWindow(task->hwnd, SW_SHOWNOACTIVATE);
-                SetWindowPos(task->hwnd, HWND_TOP, 0, 0, 0, 0,
-                    SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
-            }
-        }
+    case WMU_STATUS_OP:
+    {
+        std::unique_ptr<StatusOpMsg> msg((StatusOpMsg*)lParam);
 
-        // Refresh only when NOT in playback (prevents messing with playback UI)
-        if (!g_inPlayback) {
-            if (g_view == ViewKind::Folder) {
-                ShowFolder(g_folder);
-            }
-            else if (g_view == ViewKind::Search && g_search.active) {
-                std::vector<Row> res;
-                RunSearchFromOrigin(res);
-                ShowSearchResults(res);
-            }
+        switch (msg->action)
+        {
+        case StatusOpAction::Begin:  g_statusOps.begin(msg->id, std::move(msg->text)); break;
+        case StatusOpAction::Update: g_statusOps.update(msg->id, std::move(msg->text)); break;
+        case StatusOpAction::End:    g_statusOps.end(msg->id); break;
+        case StatusOpAction::Bytes:  g_statusOps.bytes(msg->id, msg->bytesDone, msg->bytesTotal); break;
         }
-
+        RefreshStatusBar();
         return 0;
     }
 
+
     case WM_CLOSE:
         if (g_loadingFolder) {
             // Avoid tearing down the window while ShowFolder is mid-loop
@@ -6023,31 +11549,42 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
 
         KillTimer(h, kTimerPlaybackUI);
 
-        // stop meta work
+        // stop every job before its task is deleted: cancel flags first, then JobShutdown kills
+        // their processes and joins the pool (jobs that have not started are dropped). The
+        // thumbnail cancel kills the extractions in g_thumbJob; folder walks stop at their next
+        // directory or file.
         CancelMetaWorkAndClearTodo();
-        if (g_metaThread) {
-            WaitForSingleObject(g_metaThread, 200);
-            CloseHandle(g_metaThread);
-            g_metaThread = NULL;
-        }
+        CancelThumbWorkAndClearTodo();
+        CancelDirAggWork();
+        EnterCriticalSection(&g_fileLock);
+        for (FileOpTask* t : g_fileTasks) if (t) t->cancel = true;
+        LeaveCriticalSection(&g_fileLock);
+        EnterCriticalSection(&g_ffLock);
+        for (FfmpegTask* t : g_ffTasks) if (t) t->cancel = true;
+        LeaveCriticalSection(&g_ffLock);
+        EnterCriticalSection(&g_combineLock);
+        for (CombineTask* t : g_combineTasks) if (t) t->cancel = true;
+        LeaveCriticalSection(&g_combineLock);
+        JobShutdown();
 
         // ---- Cleanup FileOp tasks
         EnterCriticalSection(&g_fileLock);
         for (FileOpTask* t : g_fileTasks) {
             if (!t) continue;
-            if (t->hThread) { CloseHandle(t->hThread); t->hThread = NULL; }
+            t->cancel = true;
             if (t->hwnd && IsWindow(t->hwnd)) DestroyWindow(t->hwnd);
             delete t;
         }
         g_fileTasks.clear();
+        g_ioQueue.clear();
         LeaveCriticalSection(&g_fileLock);
 
         // ---- Cleanup FFmpeg tasks (safety net)
         EnterCriticalSection(&g_ffLock);
         for (FfmpegTask* t : g_ffTasks) {
             if (!t) continue;
+            t->cancel = true;
             if (t->hProcess) { CloseHandle(t->hProcess); t->hProcess = NULL; }
-            if (t->hThread) { CloseHandle(t->hThread);  t->hThread = NULL; }
             if (t->hwnd && IsWindow(t->hwnd)) DestroyWindow(t->hwnd);
             delete t;
         }
@@ -6058,16 +11595,35 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT m, WPARAM wParam, LPARAM lParam)
         EnterCriticalSection(&g_combineLock);
         for (CombineTask* t : g_combineTasks) {
             if (!t) continue;
+            t->cancel = true;
             if (t->hProcess) { CloseHandle(t->hProcess); t->hProcess = NULL; }
-            if (t->hThread) { CloseHandle(t->hThread);  t->hThread = NULL; }
             if (t->hwnd && IsWindow(t->hwnd)) DestroyWindow(t->hwnd);
             delete t;
         }
         g_combineTasks.clear();
         LeaveCriticalSection(&g_combineLock);
 
+        // thumbnail and folder-total jobs were joined by JobShutdown
+        if (g_thumbJob) { CloseHandle(g_thumbJob); g_thumbJob = NULL; }
+        EnterCriticalSection(&g_thumbLock);
+        ThumbCacheClose();
+        LeaveCriticalSection(&g_thumbLock);
+        if (g_thumbImages) {
+            // detach first: without LVS_SHAREIMAGELISTS the list would destroy it again
+            ListView_SetImageList(g_hwndList, NULL, LVSIL_SMALL);
+            ImageList_Destroy(g_thumbImages);
+            g_thumbImages = NULL;
+        }
+
+        // ---- Persist metadata cache (worker already stopped above)
+        MetaCacheSave();
+
         // ---- Delete critical sections AFTER all use
         DeleteCriticalSection(&g_metaLock);
+        DeleteCriticalSection(&g_metaCacheLock);
+        DeleteCriticalSection(&g_kfLock);
+        DeleteCriticalSection(&g_dirAggLock);
+        DeleteCriticalSection(&g_thumbLock);
         DeleteCriticalSection(&g_combineLock);
         DeleteCriticalSection(&g_ffLock);
         DeleteCriticalSection(&g_fileLock);